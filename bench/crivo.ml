@@ -0,0 +1,27 @@
+// Crivo de Eratóstenes: acessos a array com passos variados.
+// exit: 4
+var crivo[8192];
+var rodada = 0;
+var primos = 0;
+while (rodada < 1000) {
+    var i = 2;
+    while (i < 8192) {
+        crivo[i] = 0;
+        i = i + 1;
+    }
+    primos = 0;
+    i = 2;
+    while (i < 8192) {
+        if (crivo[i] < 1) {
+            primos = primos + 1;
+            var j = i * i;
+            while (j < 8192) {
+                crivo[j] = 1;
+                j = j + i;
+            }
+        }
+        i = i + 1;
+    }
+    rodada = rodada + 1;
+}
+exit(primos - (primos / 256) * 256);
@@ -0,0 +1,19 @@
+// Desvios imprevisíveis: um bit de um gerador congruencial decide os 'ifs'.
+// exit: 76
+var x = 12345;
+var i = 0;
+var a = 0;
+var b = 0;
+while (i < 4000000) {
+    x = x * 1103515245 + 12345;
+    x = x - (x / 2147483648) * 2147483648;
+    var bit = x / 65536 - (x / 131072) * 2;
+    if (bit > 0) {
+        a = a + 1;
+    }
+    if (bit < 1) {
+        b = b + 3;
+    }
+    i = i + 1;
+}
+exit((a + b) - ((a + b) / 256) * 256);
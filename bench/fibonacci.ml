@@ -0,0 +1,9 @@
+// Chamadas de função recursivas (call, ret e acessos à stack).
+// exit: 5
+fn fib(n) {
+    if (n < 2) {
+        return n;
+    }
+    return fib(n - 1) + fib(n - 2);
+}
+exit(fib(32) - (fib(32) / 256) * 256);
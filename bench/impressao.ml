@@ -0,0 +1,8 @@
+// Muitos 'print': custo do runtime de saída bufferizado.
+// exit: 0
+var i = 0;
+while (i < 1000000) {
+    print(i * 7);
+    i = i + 1;
+}
+exit(0);
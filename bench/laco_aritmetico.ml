@@ -0,0 +1,9 @@
+// Laço com aritmética escalar (multiplicação e divisão por constante).
+// exit: 219
+var i = 0;
+var soma = 0;
+while (i < 20000000) {
+    soma = soma + i * 3 - i / 7;
+    i = i + 1;
+}
+exit(soma - (soma / 256) * 256);
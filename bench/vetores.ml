@@ -0,0 +1,22 @@
+// Laço sobre arrays que o Otimizador vetoriza (checar generate_while_vetorial).
+// exit: 8
+var a[4096];
+var b[4096];
+var i = 0;
+while (i < 4096) {
+    a[i] = i;
+    b[i] = 4096 - i;
+    i = i + 1;
+}
+var rodada = 0;
+var total = 0;
+while (rodada < 10000) {
+    i = 0;
+    while (i < 4096) {
+        a[i] = a[i] + b[i] * 3;
+        i = i + 1;
+    }
+    total = total + a[rodada - (rodada / 4096) * 4096];
+    rodada = rodada + 1;
+}
+exit(total - (total / 256) * 256);
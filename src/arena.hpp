@@ -1,12 +1,20 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <memory>
+#include <algorithm>
+#include <vector>
+#include <type_traits>
+
 /*
 Com muitos tipos de nós para a parse-tree e para a AST,
 temos definições "circulares" de nós (nó x depende do y,
-que depende do x). Então precisamos usar ponteiros. 
+que depende do x). Então precisamos usar ponteiros.
 No entanto, com o método padrão de alocação de memória
 dinâmica (new / malloc), teriamos muitos 'cache miss',
-diminuindo muito a eficiência. Então uma alocação em 
+diminuindo muito a eficiência. Então uma alocação em
 arena permite uso muito menor da RAM, aumentando a
 eficiência do compilador com muitos nós.
 */
@@ -14,36 +22,119 @@ eficiência do compilador com muitos nós.
 
 class ArenaAlloc {
     public:
-        inline explicit ArenaAlloc(size_t bytes) 
+        inline explicit ArenaAlloc(size_t bytes)
             : m_size(bytes)
         {
-            m_buffer = static_cast<std::byte*>(malloc(m_size)); // casting void* para std::byte*
-            m_arena_ptr = m_buffer;
+            novo_bloco(m_size);
         }
 
         /*
-        TODO: documentação
+        Método que reserva espaço para um objeto do tipo T
+        na arena, respeitando seu alinhamento, e o constrói
+        no local. Quando o bloco atual acaba, um novo bloco
+        é encadeado, de modo que o tamanho da AST é limitado
+        apenas pela memória disponível. Objetos com destrutor
+        não trivial (ex.: nós que contêm std::vector) são
+        registrados para serem destruídos em reset() ou no
+        destrutor da arena.
+        PARÂMETROS:
+        RETURNS:
+        - (T*): ponteiro para o objeto construído.
         */
         template <typename T> inline T* alloc() {
-            void* arena_ptr = m_arena_ptr;
-            m_arena_ptr += sizeof(T);
-            return static_cast<T*>(arena_ptr);
+            void* arena_ptr = reservar(sizeof(T), alignof(T));
+            if (arena_ptr == nullptr) {
+                novo_bloco(std::max(m_size, sizeof(T) + alignof(T)));
+                arena_ptr = reservar(sizeof(T), alignof(T));
+            }
+            T* objeto = new (arena_ptr) T();
+            m_num_allocs++;
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                m_destrutores.push_back({objeto, [](void* ptr) { static_cast<T*>(ptr)->~T(); }});
+            }
+            return objeto;
+        }
+
+        /*
+        Método que libera, de uma vez, todos os objetos alocados
+        na arena, mantendo o primeiro bloco para a próxima compilação.
+        É o que permite reaproveitar a mesma arena em várias
+        compilações seguidas sem pagar o custo de um novo malloc.
+        PARÂMETROS:
+        RETURNS:
+        */
+        inline void reset() {
+            destruir();
+            while (m_blocos.size() > 1) {
+                free(m_blocos.back());
+                m_blocos.pop_back();
+            }
+            m_arena_ptr = m_blocos.front();
+            m_arena_fim = m_arena_ptr + m_size;
+            m_num_allocs = 0;
+        }
+
+        /*
+        Número de objetos alocados desde a criação (ou o último
+        reset()) da arena.
+        */
+        inline size_t num_allocs() const {
+            return m_num_allocs;
         }
 
         // deletando constructor de copia e de atribuição
         ArenaAlloc(const ArenaAlloc&) = delete;
         ArenaAlloc& operator=(const ArenaAlloc&) = delete;
-        
+
         /*
-        TODO: documentação
+        Destrutor da arena. Chama os destrutores registrados
+        e libera todos os blocos.
         */
         inline ~ArenaAlloc() {
-            free(m_buffer);
+            destruir();
+            for (std::byte* bloco : m_blocos) {
+                free(bloco);
+            }
         }
 
 
     private:
+        struct Destrutor {
+            void* objeto;
+            void (*destruir)(void*);
+        };
+
         size_t m_size;
-        std::byte* m_buffer;
+        std::vector<std::byte*> m_blocos;
         std::byte* m_arena_ptr;
-};
\ No newline at end of file
+        std::byte* m_arena_fim;
+        size_t m_num_allocs = 0;
+        std::vector<Destrutor> m_destrutores;
+
+        inline void* reservar(size_t tamanho, size_t alinhamento) {
+            void* arena_ptr = m_arena_ptr;
+            size_t espaco = static_cast<size_t>(m_arena_fim - m_arena_ptr);
+            if (std::align(alinhamento, tamanho, arena_ptr, espaco) == nullptr) {
+                return nullptr;
+            }
+            m_arena_ptr = static_cast<std::byte*>(arena_ptr) + tamanho;
+            return arena_ptr;
+        }
+
+        inline void novo_bloco(size_t tamanho) {
+            std::byte* bloco = static_cast<std::byte*>(malloc(tamanho)); // casting void* para std::byte*
+            if (bloco == nullptr) {
+                throw std::bad_alloc();
+            }
+            m_blocos.push_back(bloco);
+            m_arena_ptr = bloco;
+            m_arena_fim = bloco + tamanho;
+        }
+
+        inline void destruir() {
+            for (auto it = m_destrutores.rbegin(); it != m_destrutores.rend(); it++) {
+                it->destruir(it->objeto);
+            }
+            m_destrutores.clear();
+        }
+};
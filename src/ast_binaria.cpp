@@ -0,0 +1,593 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "./ast_binaria.hpp"
+#include "./erro.hpp"
+#include "./parser.hpp"
+#include "./perfil.hpp"
+#include "./trace.hpp"
+
+
+namespace mlc {
+    /*
+    Escritor da AST binária. A árvore é percorrida em pós-ordem com
+    uma pilha explícita: cada nó sai da pilha duas vezes, a primeira
+    para empilhar os filhos e a segunda, quando os índices dos filhos
+    já estão em 'm_indices', para ser escrito.
+    */
+    class EscritorAst {
+        public:
+            std::vector<NoAst> nos;
+            std::vector<uint32_t> listas;
+            std::string nomes;
+
+            inline uint32_t escrever_statmt(const node::Statmt* statmt) {
+                return escrever({.tipo = TipoTarefa::statmt, .no = statmt});
+            }
+
+            inline uint32_t escrever_funcao(const node::Function* funcao) {
+                return escrever({.tipo = TipoTarefa::funcao, .no = funcao});
+            }
+
+            /*
+            Escreve uma lista na seção de listas.
+            PARÂMETROS:
+            - elementos (std::span<const uint32_t>): elementos da lista.
+            RETURNS:
+            - (uint32_t): índice da lista.
+            */
+            inline uint32_t lista(std::span<const uint32_t> elementos) {
+                uint32_t indice = static_cast<uint32_t>(listas.size());
+                listas.push_back(static_cast<uint32_t>(elementos.size()));
+                listas.insert(listas.end(), elementos.begin(), elementos.end());
+                return indice;
+            }
+
+        private:
+            enum class TipoTarefa {
+                expr,
+                statmt,
+                scope,
+                funcao
+            };
+
+            struct Tarefa {
+                TipoTarefa tipo;
+                const void* no;
+                bool expandida = false;
+                size_t base = 0; // tamanho de 'm_indices' antes dos filhos
+            };
+
+            std::vector<Tarefa> m_pilha;
+            std::vector<uint32_t> m_indices; // índices dos nós já escritos, ainda sem pai
+            std::unordered_map<std::string, uint32_t> m_nomes;
+
+            inline uint32_t escrever(Tarefa raiz) {
+                m_pilha.push_back(raiz);
+                while (!m_pilha.empty()) {
+                    Tarefa tarefa = m_pilha.back();
+                    m_pilha.pop_back();
+                    if (tarefa.expandida) {
+                        emitir(tarefa);
+                        continue;
+                    }
+                    if (tarefa.tipo == TipoTarefa::statmt) {
+                        // um escopo usado como statement é escrito como o próprio escopo
+                        const auto& variant_statmt = static_cast<const node::Statmt*>(tarefa.no)->variant_statmt;
+                        if (auto scope = std::get_if<node::Scope*>(&variant_statmt)) {
+                            tarefa.tipo = TipoTarefa::scope;
+                            tarefa.no = *scope;
+                        }
+                    }
+                    tarefa.expandida = true;
+                    tarefa.base = m_indices.size();
+                    m_pilha.push_back(tarefa);
+                    size_t inicio = m_pilha.size();
+                    empilhar_filhos(tarefa);
+                    std::reverse(m_pilha.begin() + inicio, m_pilha.end()); // o primeiro filho é escrito primeiro
+                }
+                uint32_t indice = m_indices.back();
+                m_indices.pop_back();
+                return indice;
+            }
+
+            inline void empilhar(TipoTarefa tipo, const void* no) {
+                m_pilha.push_back({.tipo = tipo, .no = no});
+            }
+
+            inline void empilhar_filhos(const Tarefa& tarefa) {
+                switch (tarefa.tipo) {
+                    case TipoTarefa::expr: {
+                        const auto* expr = static_cast<const node::Expr*>(tarefa.no);
+                        if (auto bin_expr = std::get_if<node::BinExpr>(&expr->variant_expr)) {
+                            empilhar(TipoTarefa::expr, bin_expr->lado_esquerdo);
+                            empilhar(TipoTarefa::expr, bin_expr->lado_direito);
+                            break;
+                        }
+                        const auto& term = std::get<node::Term>(expr->variant_expr);
+                        if (auto term_paren = std::get_if<node::TermParen>(&term.variant_term)) {
+                            empilhar(TipoTarefa::expr, term_paren->expr);
+                        } else if (auto term_call = std::get_if<node::TermCall>(&term.variant_term)) {
+                            for (const node::Expr* arg : term_call->args) {
+                                empilhar(TipoTarefa::expr, arg);
+                            }
+                        } else if (auto term_index = std::get_if<node::TermIndex>(&term.variant_term)) {
+                            empilhar(TipoTarefa::expr, term_index->indice);
+                        }
+                        break;
+                    }
+                    case TipoTarefa::statmt: {
+                        const auto& variant_statmt = static_cast<const node::Statmt*>(tarefa.no)->variant_statmt;
+                        if (auto statmt_var = std::get_if<node::StatmtVar*>(&variant_statmt)) {
+                            std::visit([&](const auto* var) { empilhar(TipoTarefa::expr, var->expr); }, (*statmt_var)->variant_var);
+                        } else if (auto statmt_exit = std::get_if<node::StatmtExit*>(&variant_statmt)) {
+                            empilhar(TipoTarefa::expr, (*statmt_exit)->expr);
+                        } else if (auto statmt_if = std::get_if<node::StatmtIf*>(&variant_statmt)) {
+                            empilhar(TipoTarefa::expr, (*statmt_if)->expr);
+                            empilhar(TipoTarefa::scope, (*statmt_if)->scope);
+                        } else if (auto statmt_while = std::get_if<node::StatmtWhile*>(&variant_statmt)) {
+                            empilhar(TipoTarefa::expr, (*statmt_while)->expr);
+                            empilhar(TipoTarefa::scope, (*statmt_while)->scope);
+                        } else if (auto statmt_return = std::get_if<node::StatmtReturn*>(&variant_statmt)) {
+                            empilhar(TipoTarefa::expr, (*statmt_return)->expr);
+                        } else if (auto statmt_index = std::get_if<node::StatmtIndex*>(&variant_statmt)) {
+                            empilhar(TipoTarefa::expr, (*statmt_index)->indice);
+                            empilhar(TipoTarefa::expr, (*statmt_index)->expr);
+                        } else if (auto statmt_print = std::get_if<node::StatmtPrint*>(&variant_statmt)) {
+                            empilhar(TipoTarefa::expr, (*statmt_print)->expr);
+                        }
+                        break;
+                    }
+                    case TipoTarefa::scope:
+                        for (const node::Statmt* statmt : static_cast<const node::Scope*>(tarefa.no)->statmts_scope) {
+                            empilhar(TipoTarefa::statmt, statmt);
+                        }
+                        break;
+                    case TipoTarefa::funcao:
+                        empilhar(TipoTarefa::scope, static_cast<const node::Function*>(tarefa.no)->scope);
+                        break;
+                }
+            }
+
+            inline void emitir(const Tarefa& tarefa) {
+                std::span<const uint32_t> filhos (m_indices.data() + tarefa.base, m_indices.size() - tarefa.base);
+                NoAst no {};
+                switch (tarefa.tipo) {
+                    case TipoTarefa::expr: {
+                        const auto* expr = static_cast<const node::Expr*>(tarefa.no);
+                        if (auto bin_expr = std::get_if<node::BinExpr>(&expr->variant_expr)) {
+                            no = {.tipo = TipoNoAst::bin, .token = static_cast<uint8_t>(bin_expr->token.tipo), .offset = bin_expr->token.offset,
+                                .a = filhos[0], .b = filhos[1]};
+                            break;
+                        }
+                        const auto& term = std::get<node::Term>(expr->variant_expr);
+                        if (auto term_int_lit = std::get_if<node::TermIntLit>(&term.variant_term)) {
+                            no = {.tipo = TipoNoAst::int_lit, .offset = term_int_lit->token_int.offset, .valor = term_int_lit->token_int.valor_int};
+                        } else if (auto term_identif = std::get_if<node::TermIdentif>(&term.variant_term)) {
+                            no = {.tipo = TipoNoAst::identif, .offset = term_identif->token_identif.offset, .a = nome(term_identif->token_identif)};
+                        } else if (std::holds_alternative<node::TermParen>(term.variant_term)) {
+                            no = {.tipo = TipoNoAst::paren, .a = filhos[0]};
+                        } else if (auto term_call = std::get_if<node::TermCall>(&term.variant_term)) {
+                            no = {.tipo = TipoNoAst::call, .offset = term_call->token_identif.offset, .a = nome(term_call->token_identif), .b = lista(filhos)};
+                        } else if (auto term_index = std::get_if<node::TermIndex>(&term.variant_term)) {
+                            no = {.tipo = TipoNoAst::index, .offset = term_index->token_identif.offset, .a = nome(term_index->token_identif), .b = filhos[0]};
+                        }
+                        break;
+                    }
+                    case TipoTarefa::statmt: {
+                        const auto& variant_statmt = static_cast<const node::Statmt*>(tarefa.no)->variant_statmt;
+                        if (auto statmt_var = std::get_if<node::StatmtVar*>(&variant_statmt)) {
+                            bool nova = std::holds_alternative<node::NewVar*>((*statmt_var)->variant_var);
+                            std::visit([&](const auto* var) {
+                                no = {.tipo = nova ? TipoNoAst::new_var : TipoNoAst::reass_var, .offset = var->token_identif.offset,
+                                    .a = nome(var->token_identif), .b = filhos[0]};
+                            }, (*statmt_var)->variant_var);
+                        } else if (std::holds_alternative<node::StatmtExit*>(variant_statmt)) {
+                            no = {.tipo = TipoNoAst::exit, .a = filhos[0]};
+                        } else if (auto statmt_if = std::get_if<node::StatmtIf*>(&variant_statmt)) {
+                            no = {.tipo = TipoNoAst::_if, .a = filhos[0], .b = filhos[1], .extra = (*statmt_if)->contador};
+                        } else if (std::holds_alternative<node::StatmtWhile*>(variant_statmt)) {
+                            no = {.tipo = TipoNoAst::_while, .a = filhos[0], .b = filhos[1]};
+                        } else if (auto statmt_return = std::get_if<node::StatmtReturn*>(&variant_statmt)) {
+                            no = {.tipo = TipoNoAst::_return, .offset = (*statmt_return)->token_return.offset, .a = filhos[0]};
+                        } else if (auto statmt_array = std::get_if<node::StatmtArray*>(&variant_statmt)) {
+                            no = {.tipo = TipoNoAst::array, .offset = (*statmt_array)->token_identif.offset, .a = nome((*statmt_array)->token_identif),
+                                .extra = (*statmt_array)->token_tamanho.offset, .valor = (*statmt_array)->token_tamanho.valor_int};
+                        } else if (auto statmt_index = std::get_if<node::StatmtIndex*>(&variant_statmt)) {
+                            no = {.tipo = TipoNoAst::atrib_index, .offset = (*statmt_index)->token_identif.offset, .a = nome((*statmt_index)->token_identif),
+                                .b = filhos[0], .c = filhos[1]};
+                        } else if (std::holds_alternative<node::StatmtPrint*>(variant_statmt)) {
+                            no = {.tipo = TipoNoAst::print, .a = filhos[0]};
+                        }
+                        break;
+                    }
+                    case TipoTarefa::scope:
+                        no = {.tipo = TipoNoAst::scope, .a = lista(filhos), .extra = static_cast<const node::Scope*>(tarefa.no)->contador};
+                        break;
+                    case TipoTarefa::funcao: {
+                        const auto* funcao = static_cast<const node::Function*>(tarefa.no);
+                        std::vector<uint32_t> params;
+                        for (const Token& param : funcao->params) {
+                            params.push_back(nome(param));
+                            params.push_back(param.offset);
+                        }
+                        no = {.tipo = TipoNoAst::funcao, .offset = funcao->token_identif.offset, .a = nome(funcao->token_identif),
+                            .b = lista(params), .c = filhos[0]};
+                        break;
+                    }
+                }
+                m_indices.resize(tarefa.base);
+                m_indices.push_back(static_cast<uint32_t>(nos.size()));
+                nos.push_back(no);
+            }
+
+            /*
+            Posição do nome do identificador 'token' na seção de nomes,
+            que guarda cada nome uma única vez.
+            */
+            inline uint32_t nome(const Token& token) {
+                auto [it, novo] = m_nomes.try_emplace(token.valor.value(), static_cast<uint32_t>(nomes.size()));
+                if (novo) {
+                    nomes.append(token.valor.value());
+                    nomes.push_back('\0');
+                }
+                return it->second;
+            }
+    };
+
+    std::string serializar_ast(const node::Program& program, std::string_view src) {
+        MLC_TRACE_SCOPE("serializar_ast");
+        EscritorAst escritor;
+        std::vector<uint32_t> statmts;
+        for (const node::Statmt* statmt : program.statmts) {
+            statmts.push_back(escritor.escrever_statmt(statmt));
+        }
+        std::vector<uint32_t> funcoes;
+        for (const node::Function* funcao : program.funcoes) {
+            funcoes.push_back(escritor.escrever_funcao(funcao));
+        }
+        IndiceLinhas linhas (src);
+        CabecalhoAst cabecalho = {
+            .magica = MAGICA_AST,
+            .versao = VERSAO_AST,
+            .usa_print = program.usa_print,
+            .hash_fonte = mlc::hash_fonte(src),
+            .tamanho_fonte = static_cast<uint32_t>(src.size()),
+            .num_contadores = program.num_contadores,
+            .raiz_statmts = escritor.lista(statmts),
+            .raiz_funcoes = escritor.lista(funcoes)
+        };
+        cabecalho.num_nos = static_cast<uint32_t>(escritor.nos.size());
+        cabecalho.num_listas = static_cast<uint32_t>(escritor.listas.size());
+        cabecalho.num_linhas = static_cast<uint32_t>(linhas.inicios().size());
+        cabecalho.bytes_nomes = static_cast<uint32_t>(escritor.nomes.size());
+
+        std::string arquivo;
+        arquivo.reserve(sizeof(CabecalhoAst) + escritor.nos.size() * sizeof(NoAst)
+            + (escritor.listas.size() + linhas.inicios().size()) * sizeof(uint32_t) + escritor.nomes.size());
+        auto anexar = [&arquivo](const void* dados, size_t bytes) {
+            arquivo.append(static_cast<const char*>(dados), bytes);
+        };
+        anexar(&cabecalho, sizeof(cabecalho));
+        anexar(escritor.nos.data(), escritor.nos.size() * sizeof(NoAst));
+        anexar(escritor.listas.data(), escritor.listas.size() * sizeof(uint32_t));
+        anexar(linhas.inicios().data(), linhas.inicios().size() * sizeof(uint32_t));
+        arquivo.append(escritor.nomes);
+        return arquivo;
+    }
+
+    AstBinaria::~AstBinaria() {
+        if (m_dados != nullptr) {
+            munmap(const_cast<unsigned char*>(m_dados), m_tamanho);
+        }
+    }
+
+    std::optional<std::string> AstBinaria::abrir(const std::string& arquivo) {
+        MLC_TRACE_SCOPE("abrir_ast");
+        int fd = open(arquivo.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return std::string("open: ") + strerror(errno);
+        }
+        struct stat info;
+        if (fstat(fd, &info) < 0) {
+            int codigo = errno;
+            close(fd);
+            return std::string("fstat: ") + strerror(codigo);
+        }
+        size_t tamanho = static_cast<size_t>(info.st_size);
+        if (tamanho < sizeof(CabecalhoAst)) {
+            close(fd);
+            return "O arquivo não é uma AST binária.";
+        }
+        void* mapa = mmap(nullptr, tamanho, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // o mapeamento continua válido sem o descritor
+        if (mapa == MAP_FAILED) {
+            return std::string("mmap: ") + strerror(errno);
+        }
+        if (m_dados != nullptr) {
+            munmap(const_cast<unsigned char*>(m_dados), m_tamanho);
+        }
+        m_dados = static_cast<const unsigned char*>(mapa);
+        m_tamanho = tamanho;
+
+        std::memcpy(&m_cabecalho, m_dados, sizeof(m_cabecalho));
+        if (m_cabecalho.magica != MAGICA_AST) {
+            return "O arquivo não é uma AST binária.";
+        }
+        if (m_cabecalho.versao != VERSAO_AST) {
+            return "AST binária da versão " + std::to_string(m_cabecalho.versao) + "; esta versão do compilador lê apenas a versão "
+                + std::to_string(VERSAO_AST) + ". Gere-a novamente com --emit-ast.";
+        }
+        uint64_t esperado = sizeof(CabecalhoAst) + uint64_t(m_cabecalho.num_nos) * sizeof(NoAst)
+            + (uint64_t(m_cabecalho.num_listas) + m_cabecalho.num_linhas) * sizeof(uint32_t) + m_cabecalho.bytes_nomes;
+        m_nos = m_dados + sizeof(CabecalhoAst);
+        m_listas = reinterpret_cast<const uint32_t*>(m_nos + size_t(m_cabecalho.num_nos) * sizeof(NoAst));
+        m_linhas = m_listas + m_cabecalho.num_listas;
+        m_nomes = reinterpret_cast<const char*>(m_linhas + m_cabecalho.num_linhas);
+        if (esperado != m_tamanho || m_cabecalho.num_linhas == 0 || m_linhas[0] != 0
+            || (m_cabecalho.bytes_nomes > 0 && m_nomes[m_cabecalho.bytes_nomes - 1] != '\0')) {
+            return "AST binária corrompida.";
+        }
+        return {};
+    }
+
+    void AstBinaria::materializar(node::Program& program, ArenaAlloc& alloc, uint32_t base_contador, uint32_t base_offset) const {
+        MLC_TRACE_SCOPE("materializar_ast");
+        auto corrompida = []() -> void {
+            throw ErroCompilacao {.mensagem = "AST binária corrompida.", .offset = 0};
+        };
+
+        // categoria de cada tipo de nó: onde ele pode aparecer como filho
+        enum class Classe {
+            expr,
+            statmt,
+            scope,
+            funcao,
+            invalida
+        };
+        auto classe = [](uint8_t tipo) {
+            switch (static_cast<TipoNoAst>(tipo)) {
+                case TipoNoAst::int_lit: case TipoNoAst::identif: case TipoNoAst::paren:
+                case TipoNoAst::call: case TipoNoAst::index: case TipoNoAst::bin:
+                    return Classe::expr;
+                case TipoNoAst::new_var: case TipoNoAst::reass_var: case TipoNoAst::exit: case TipoNoAst::_if:
+                case TipoNoAst::_while: case TipoNoAst::_return: case TipoNoAst::print: case TipoNoAst::array:
+                case TipoNoAst::atrib_index:
+                    return Classe::statmt;
+                case TipoNoAst::scope:
+                    return Classe::scope;
+                case TipoNoAst::funcao:
+                    return Classe::funcao;
+            }
+            return Classe::invalida;
+        };
+
+        uint32_t num_nos = m_cabecalho.num_nos;
+        std::vector<void*> construidos (num_nos, nullptr); // node::Expr*, node::Statmt*, node::Scope* ou node::Function*
+        std::vector<bool> usados (num_nos, false);
+
+        /*
+        Filho 'indice' do nó 'pai', que precisa vir antes dele, não
+        ter outro pai e ser da classe 'esperada'. Escopos também são
+        aceitos onde se espera um statement.
+        */
+        auto filho = [&](uint32_t indice, uint32_t pai, Classe esperada) -> void* {
+            if (indice >= pai || usados[indice]) {
+                corrompida();
+            }
+            Classe encontrada = classe(m_nos[size_t(indice) * sizeof(NoAst)]);
+            usados[indice] = true;
+            if (encontrada == esperada) {
+                return construidos[indice];
+            }
+            if (esperada != Classe::statmt || encontrada != Classe::scope) {
+                corrompida();
+            }
+            auto statmt = alloc.alloc<node::Statmt>();
+            statmt->variant_statmt = static_cast<node::Scope*>(construidos[indice]);
+            return statmt;
+        };
+        auto expr = [&](uint32_t indice, uint32_t pai) {
+            return static_cast<node::Expr*>(filho(indice, pai, Classe::expr));
+        };
+        auto lista = [&](uint32_t inicio) {
+            if (inicio >= m_cabecalho.num_listas || m_listas[inicio] > m_cabecalho.num_listas - inicio - 1) {
+                corrompida();
+            }
+            return std::span<const uint32_t>(m_listas + inicio + 1, m_listas[inicio]);
+        };
+        auto nome = [&](uint32_t posicao, uint32_t offset) {
+            if (posicao >= m_cabecalho.bytes_nomes) {
+                corrompida();
+            }
+            return Token {.tipo = TipoToken::identif, .valor = std::string(m_nomes + posicao), .offset = offset + base_offset};
+        };
+        auto contador = [&](uint32_t valor) {
+            if (valor >= m_cabecalho.num_contadores) {
+                corrompida();
+            }
+            return valor + base_contador;
+        };
+        auto nova_expr = [&](auto variant) {
+            auto expr = alloc.alloc<node::Expr>();
+            expr->variant_expr = std::move(variant);
+            return expr;
+        };
+        auto novo_statmt = [&](auto* statmt_tipo) {
+            auto statmt = alloc.alloc<node::Statmt>();
+            statmt->variant_statmt = statmt_tipo;
+            return statmt;
+        };
+
+        for (uint32_t i = 0; i < num_nos; i++) {
+            NoAst no;
+            std::memcpy(&no, m_nos + size_t(i) * sizeof(NoAst), sizeof(NoAst));
+            uint32_t offset = no.offset + base_offset;
+            void* construido = nullptr;
+            switch (no.tipo) {
+                case TipoNoAst::int_lit:
+                    construido = nova_expr(node::Term {.variant_term = node::TermIntLit {
+                        .token_int = {.tipo = TipoToken::int_lit, .valor_int = no.valor, .offset = offset}
+                    }});
+                    break;
+                case TipoNoAst::identif:
+                    construido = nova_expr(node::Term {.variant_term = node::TermIdentif {.token_identif = nome(no.a, no.offset)}});
+                    break;
+                case TipoNoAst::paren:
+                    construido = nova_expr(node::Term {.variant_term = node::TermParen {.expr = expr(no.a, i)}});
+                    break;
+                case TipoNoAst::call: {
+                    node::TermCall term_call {.token_identif = nome(no.a, no.offset), .args = {}};
+                    for (uint32_t arg : lista(no.b)) {
+                        term_call.args.push_back(expr(arg, i));
+                    }
+                    construido = nova_expr(node::Term {.variant_term = std::move(term_call)});
+                    break;
+                }
+                case TipoNoAst::index:
+                    construido = nova_expr(node::Term {.variant_term = node::TermIndex {.token_identif = nome(no.a, no.offset), .indice = expr(no.b, i)}});
+                    break;
+                case TipoNoAst::bin: {
+                    if (no.token >= static_cast<uint8_t>(TipoToken::_num_tipos) || !info_operador(static_cast<TipoToken>(no.token)).has_value()) {
+                        corrompida();
+                    }
+                    // os operandos são lidos antes de o Token existir: expr() pode lançar o erro de AST corrompida
+                    node::Expr* lado_esquerdo = expr(no.a, i);
+                    node::Expr* lado_direito = expr(no.b, i);
+                    Token token {.tipo = static_cast<TipoToken>(no.token), .valor = std::nullopt, .offset = offset};
+                    construido = nova_expr(node::BinExpr {.token = std::move(token), .lado_esquerdo = lado_esquerdo, .lado_direito = lado_direito});
+                    break;
+                }
+                case TipoNoAst::new_var: {
+                    auto new_var = alloc.alloc<node::NewVar>();
+                    new_var->token_identif = nome(no.a, no.offset);
+                    new_var->expr = expr(no.b, i);
+                    auto statmt_var = alloc.alloc<node::StatmtVar>();
+                    statmt_var->variant_var = new_var;
+                    construido = novo_statmt(statmt_var);
+                    break;
+                }
+                case TipoNoAst::reass_var: {
+                    auto reass_var = alloc.alloc<node::ReassVar>();
+                    reass_var->token_identif = nome(no.a, no.offset);
+                    reass_var->expr = expr(no.b, i);
+                    auto statmt_var = alloc.alloc<node::StatmtVar>();
+                    statmt_var->variant_var = reass_var;
+                    construido = novo_statmt(statmt_var);
+                    break;
+                }
+                case TipoNoAst::exit: {
+                    auto statmt_exit = alloc.alloc<node::StatmtExit>();
+                    statmt_exit->expr = expr(no.a, i);
+                    construido = novo_statmt(statmt_exit);
+                    break;
+                }
+                case TipoNoAst::scope: {
+                    auto scope = alloc.alloc<node::Scope>();
+                    for (uint32_t statmt : lista(no.a)) {
+                        scope->statmts_scope.push_back(static_cast<node::Statmt*>(filho(statmt, i, Classe::statmt)));
+                    }
+                    scope->contador = contador(no.extra);
+                    construido = scope;
+                    break;
+                }
+                case TipoNoAst::_if: {
+                    auto statmt_if = alloc.alloc<node::StatmtIf>();
+                    statmt_if->expr = expr(no.a, i);
+                    statmt_if->scope = static_cast<node::Scope*>(filho(no.b, i, Classe::scope));
+                    statmt_if->contador = contador(no.extra);
+                    construido = novo_statmt(statmt_if);
+                    break;
+                }
+                case TipoNoAst::_while: {
+                    auto statmt_while = alloc.alloc<node::StatmtWhile>();
+                    statmt_while->expr = expr(no.a, i);
+                    statmt_while->scope = static_cast<node::Scope*>(filho(no.b, i, Classe::scope));
+                    construido = novo_statmt(statmt_while);
+                    break;
+                }
+                case TipoNoAst::_return: {
+                    auto statmt_return = alloc.alloc<node::StatmtReturn>();
+                    statmt_return->token_return = {.tipo = TipoToken::_return, .offset = offset};
+                    statmt_return->expr = expr(no.a, i);
+                    construido = novo_statmt(statmt_return);
+                    break;
+                }
+                case TipoNoAst::print: {
+                    auto statmt_print = alloc.alloc<node::StatmtPrint>();
+                    statmt_print->expr = expr(no.a, i);
+                    construido = novo_statmt(statmt_print);
+                    break;
+                }
+                case TipoNoAst::array: {
+                    auto statmt_array = alloc.alloc<node::StatmtArray>();
+                    statmt_array->token_identif = nome(no.a, no.offset);
+                    statmt_array->token_tamanho = {.tipo = TipoToken::int_lit, .valor_int = no.valor, .offset = no.extra + base_offset};
+                    construido = novo_statmt(statmt_array);
+                    break;
+                }
+                case TipoNoAst::atrib_index: {
+                    auto statmt_index = alloc.alloc<node::StatmtIndex>();
+                    statmt_index->token_identif = nome(no.a, no.offset);
+                    statmt_index->indice = expr(no.b, i);
+                    statmt_index->expr = expr(no.c, i);
+                    construido = novo_statmt(statmt_index);
+                    break;
+                }
+                case TipoNoAst::funcao: {
+                    auto funcao = alloc.alloc<node::Function>();
+                    funcao->token_identif = nome(no.a, no.offset);
+                    std::span<const uint32_t> params = lista(no.b);
+                    if (params.size() % 2 != 0) {
+                        corrompida();
+                    }
+                    for (size_t k = 0; k < params.size(); k += 2) {
+                        funcao->params.push_back(nome(params[k], params[k + 1]));
+                    }
+                    funcao->scope = static_cast<node::Scope*>(filho(no.c, i, Classe::scope));
+                    construido = funcao;
+                    break;
+                }
+                default:
+                    corrompida();
+            }
+            construidos[i] = construido;
+        }
+
+        for (uint32_t statmt : lista(m_cabecalho.raiz_statmts)) {
+            program.statmts.push_back(static_cast<node::Statmt*>(filho(statmt, num_nos, Classe::statmt)));
+        }
+        for (uint32_t funcao : lista(m_cabecalho.raiz_funcoes)) {
+            program.funcoes.push_back(static_cast<node::Function*>(filho(funcao, num_nos, Classe::funcao)));
+        }
+        program.usa_print = program.usa_print || m_cabecalho.usa_print != 0;
+        program.num_contadores += m_cabecalho.num_contadores;
+    }
+
+    Posicao AstBinaria::localizar(uint32_t offset) const {
+        const uint32_t* fim = m_linhas + m_cabecalho.num_linhas;
+        const uint32_t* it = std::upper_bound(m_linhas, fim, offset); // m_linhas[0] == 0, então 'it' nunca é o início
+        return {.linha = static_cast<uint32_t>(it - m_linhas), .coluna = offset - *(it - 1) + 1};
+    }
+
+    uint64_t AstBinaria::hash_fonte() const {
+        return m_cabecalho.hash_fonte;
+    }
+
+    uint32_t AstBinaria::tamanho_fonte() const {
+        return m_cabecalho.tamanho_fonte;
+    }
+
+    uint32_t AstBinaria::num_contadores() const {
+        return m_cabecalho.num_contadores;
+    }
+}
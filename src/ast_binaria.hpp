@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "./arena.hpp"
+#include "./diagnostico.hpp"
+
+namespace node {
+    struct Program;
+}
+
+/*
+AST binária (.mlast): a árvore de um programa (node::Program)
+logo após o parser, serializada num formato que pode ser mapeado
+com mmap e usado sem tokenizar nem parsear o código de novo. O
+formato não contém ponteiros: os nós ficam num vetor e se referem
+uns aos outros pelo índice, então o arquivo não precisa de nenhuma
+relocação e vale em qualquer endereço. Layout (little-endian, como
+o x86-64):
+- Cabecalho (64 bytes): MAGICA_AST, VERSAO_AST, o tamanho e o hash
+do código fonte (checar hash_fonte), os campos de node::Program e o
+tamanho de cada seção.
+- Nós (NoAst, 32 bytes cada), em pós-ordem: os filhos de um nó
+sempre vêm antes dele, e cada nó tem no máximo um pai.
+- Listas (u32): cada lista é o seu tamanho seguido dos elementos.
+- Linhas (u32): offset do início de cada linha do código fonte,
+para que os erros ainda possam ser mostrados com linha e coluna.
+- Nomes: os identificadores, terminados em '\0' e sem repetições.
+*/
+namespace mlc {
+    inline constexpr uint64_t MAGICA_AST = 0x0000'5453'4143'4C4DULL; // "MLCAST\0\0" em little-endian
+    inline constexpr uint32_t VERSAO_AST = 1;
+
+    struct CabecalhoAst {
+        uint64_t magica = 0;
+        uint32_t versao = 0;
+        uint32_t usa_print = 0;
+        uint64_t hash_fonte = 0;
+        uint32_t tamanho_fonte = 0;
+        uint32_t num_contadores = 0;
+        uint32_t num_nos = 0;
+        uint32_t num_listas = 0; // palavras (u32) da seção de listas
+        uint32_t num_linhas = 0;
+        uint32_t bytes_nomes = 0;
+        uint32_t raiz_statmts = 0; // lista com os statements do programa
+        uint32_t raiz_funcoes = 0; // lista com as funções do programa
+        uint32_t reservado[2] = {0, 0};
+    };
+    static_assert(sizeof(CabecalhoAst) == 64);
+
+    /*
+    Tipo de cada nó. Os campos a, b e c de NoAst guardam, conforme
+    o tipo, índices de nós (N), de listas (L) ou de nomes (S); os
+    campos que o tipo não usa ficam em zero:
+    - int_lit: 'valor'.
+    - identif: a = S.
+    - paren: a = N.
+    - call: a = S, b = L de argumentos (N).
+    - index: a = S, b = N do índice.
+    - bin: 'token' é o operador, a = N esquerdo, b = N direito.
+    - new_var, reass_var: a = S, b = N.
+    - exit, print: a = N.
+    - scope: a = L de statements (N), 'extra' = contador.
+    - _if: a = N, b = N do escopo, 'extra' = contador.
+    - _while: a = N, b = N do escopo.
+    - _return: a = N.
+    - array: a = S, 'extra' = offset do tamanho, 'valor' = tamanho.
+    - atrib_index: a = S, b = N do índice, c = N da expressão.
+    - funcao: a = S, b = L de parâmetros (pares S e offset), c = N do escopo.
+    'offset' é a posição do token principal do nó no código fonte.
+    */
+    enum class TipoNoAst : uint8_t {
+        int_lit,
+        identif,
+        paren,
+        call,
+        index,
+        bin,
+        new_var,
+        reass_var,
+        exit,
+        scope,
+        _if,
+        _while,
+        _return,
+        print,
+        array,
+        atrib_index,
+        funcao
+    };
+
+    struct NoAst {
+        TipoNoAst tipo = TipoNoAst::int_lit;
+        uint8_t token = 0;
+        uint16_t reservado = 0;
+        uint32_t offset = 0;
+        uint32_t a = 0;
+        uint32_t b = 0;
+        uint32_t c = 0;
+        uint32_t extra = 0;
+        int64_t valor = 0;
+    };
+    static_assert(sizeof(NoAst) == 32);
+
+    /*
+    Serializa a AST de um programa recém parseado (antes do
+    Otimizador, que anota os nós com informações que dependem
+    do resto do programa).
+    PARÂMETROS:
+    - program (const node::Program&): AST do programa.
+    - src (std::string_view): código fonte do programa.
+    RETURNS:
+    - (std::string): o arquivo .mlast.
+    */
+    std::string serializar_ast(const node::Program& program, std::string_view src);
+
+    /*
+    AST binária mapeada em memória. abrir() só mapeia o arquivo e
+    confere o cabeçalho e o tamanho das seções, então custa o mesmo
+    para qualquer tamanho de programa; os nós são conferidos um a
+    um por materializar(), na mesma passada que os constrói.
+    */
+    class AstBinaria {
+        public:
+            AstBinaria() = default;
+            ~AstBinaria();
+
+            /*
+            Mapeia o arquivo 'arquivo' (somente leitura).
+            PARÂMETROS:
+            - arquivo (const std::string&): caminho do .mlast.
+            RETURNS:
+            - (std::optional<std::string>): mensagem de erro, caso o
+            arquivo não exista ou não seja uma AST desta versão.
+            */
+            std::optional<std::string> abrir(const std::string& arquivo);
+
+            /*
+            Constrói, na arena 'alloc', os nós do programa mapeado,
+            numa única passada pelo vetor de nós (sem recursão: os
+            filhos de cada nó já foram construídos). Lança um
+            ErroCompilacao se o arquivo estiver corrompido.
+            PARÂMETROS:
+            - program (node::Program&): recebe os statements, as
+            funções e os campos do programa.
+            - alloc (ArenaAlloc&): arena onde os nós são construídos.
+            - base_contador (uint32_t): somado ao contador dos escopos
+            e 'ifs', para que eles continuem únicos quando a AST é
+            juntada a outro programa (checar Options::prelude).
+            - base_offset (uint32_t): somado ao offset dos tokens, pelo
+            mesmo motivo.
+            */
+            void materializar(node::Program& program, ArenaAlloc& alloc, uint32_t base_contador = 0, uint32_t base_offset = 0) const;
+
+            /*
+            Linha e coluna de um offset do código fonte original.
+            */
+            Posicao localizar(uint32_t offset) const;
+
+            uint64_t hash_fonte() const;
+            uint32_t tamanho_fonte() const;
+            uint32_t num_contadores() const;
+
+            AstBinaria(const AstBinaria&) = delete;
+            AstBinaria& operator=(const AstBinaria&) = delete;
+
+        private:
+            const unsigned char* m_dados = nullptr;
+            size_t m_tamanho = 0;
+            CabecalhoAst m_cabecalho {};
+            const unsigned char* m_nos = nullptr;
+            const uint32_t* m_listas = nullptr;
+            const uint32_t* m_linhas = nullptr;
+            const char* m_nomes = nullptr;
+    };
+}
@@ -0,0 +1,428 @@
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#include "./compilador.hpp"
+#include "./ferramentas.hpp"
+#include "./montador.hpp"
+
+/*
+Benchmark da qualidade do código gerado. Compila um corpus fixo de
+kernels .ml (checar bench/), executa cada programa gerado contando
+eventos com perf_event_open(2) e compara as contagens com uma
+baseline em JSON:
+- instrucoes, ciclos, desvios_errados, falhas_l1d: contadores de
+hardware, quando a PMU está visível e o kernel permite medir o
+próprio usuário (perf_event_paranoid <= 2). VMs e containers
+frequentemente não expõem a PMU.
+- tempo_tarefa_ns, falhas_pagina: contadores de software do kernel,
+que não dependem da PMU. Se nem eles puderem ser abertos
+(perf_event_paranoid = 3, seccomp), tempo_tarefa_ns vem do rusage.
+Cada kernel roda --repeticoes vezes e fica o menor valor de cada
+métrica. As métricas de tempo (ciclos e tempo_tarefa_ns) variam de
+uma execução para outra, principalmente em VMs, e por isso têm um
+limite de regressão próprio (--limite-tempo). Só são comparadas as métricas presentes nas duas medições,
+então uma baseline gravada numa máquina sem PMU continua valendo
+numa máquina com PMU, só que com menos métricas.
+USO: bench_codigo [--baseline <base.json>] [--gravar <base.json>] [--limite porcentagem]
+    [--limite-tempo porcentagem] [--repeticoes n] [--avx2] [--sem-otimizacao] <diretório | arquivo.ml>...
+Retorna 0 sem regressões, 1 quando alguma métrica piorou mais que
+o seu limite (ou algum kernel falhou) e CODIGO_PULADO (77) sem nasm ou ld.
+*/
+
+static constexpr uint64_t VERSAO_BASELINE = 1;
+static constexpr unsigned TEMPO_LIMITE_S = 60; // por execução de um kernel
+
+struct Metrica {
+    const char* nome;
+    uint32_t tipo;
+    uint64_t config;
+    bool tempo = false; // usa o limite de --limite-tempo
+};
+
+static constexpr Metrica METRICAS[] = {
+    {"instrucoes", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"ciclos", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, true},
+    {"desvios_errados", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"falhas_l1d", PERF_TYPE_HW_CACHE,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {"tempo_tarefa_ns", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, true},
+    {"falhas_pagina", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+};
+static constexpr size_t NUM_METRICAS = std::size(METRICAS);
+static constexpr size_t METRICA_TEMPO = 4; // índice de tempo_tarefa_ns, que tem o fallback do rusage
+
+using Medicao = std::array<std::optional<uint64_t>, NUM_METRICAS>;
+using Baseline = std::map<std::string, std::map<std::string, uint64_t>>; // kernel -> métrica -> valor
+
+struct Kernel {
+    std::filesystem::path arquivo;
+    std::string nome;
+    std::string src;
+    std::optional<int> exit_esperado;
+};
+
+/*
+Lê os kernels .ml dos diretórios (ou arquivos) recebidos, com o
+código de saída anotado com '// exit: N', como nos testes.
+*/
+static std::vector<Kernel> buscar_kernels(const std::vector<std::filesystem::path>& caminhos) {
+    std::vector<std::filesystem::path> arquivos;
+    for (const auto& caminho : caminhos) {
+        if (std::filesystem::is_directory(caminho)) {
+            for (const auto& entrada : std::filesystem::directory_iterator(caminho)) {
+                if (entrada.path().extension() == ".ml") {
+                    arquivos.push_back(entrada.path());
+                }
+            }
+        } else {
+            arquivos.push_back(caminho);
+        }
+    }
+    std::sort(arquivos.begin(), arquivos.end());
+    std::vector<Kernel> kernels;
+    for (const auto& arquivo : arquivos) {
+        std::ifstream fs_kernel (arquivo);
+        if (!fs_kernel) {
+            std::fprintf(stderr, "Não foi possível ler '%s'.\n", arquivo.c_str());
+            continue;
+        }
+        Kernel kernel {.arquivo = arquivo, .nome = arquivo.stem().string(), .src = {}, .exit_esperado = std::nullopt};
+        kernel.src.assign(std::istreambuf_iterator<char>(fs_kernel), std::istreambuf_iterator<char>());
+        size_t anotacao = kernel.src.find("// exit:");
+        if (anotacao != std::string::npos) {
+            kernel.exit_esperado = std::atoi(kernel.src.c_str() + anotacao + 8);
+        }
+        kernels.push_back(std::move(kernel));
+    }
+    return kernels;
+}
+
+/*
+Abre o contador 'metrica' para o processo 'pid'. O contador começa
+desligado e é ligado pelo kernel no execve do processo, de modo que
+o fork e o código do harness não entram na contagem.
+*/
+static int abrir_contador(const Metrica& metrica, pid_t pid) {
+    perf_event_attr attr {};
+    attr.size = sizeof(attr);
+    attr.type = metrica.tipo;
+    attr.config = metrica.config;
+    attr.disabled = 1;
+    attr.enable_on_exec = 1;
+    attr.exclude_kernel = 1; // exigido com perf_event_paranoid = 2
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, pid, -1, -1, PERF_FLAG_FD_CLOEXEC));
+}
+
+/*
+Executa 'executavel' uma vez, com stdin e stdout em /dev/null, e
+lê os contadores que puderam ser abertos.
+PARÂMETROS:
+- executavel (const std::string&): programa gerado.
+- codigo (int&): recebe o código de saída do programa.
+- motivo (std::string&): recebe a descrição da falha, se houver.
+RETURNS:
+- (std::optional<Medicao>): as contagens, ou vazio se o programa
+não pôde ser executado ou não terminou normalmente.
+*/
+static std::optional<Medicao> medir(const std::string& executavel, int& codigo, std::string& motivo) {
+    int sincronia[2];
+    if (pipe2(sincronia, O_CLOEXEC) < 0) {
+        motivo = std::string("pipe2: ") + strerror(errno);
+        return {};
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        motivo = std::string("fork: ") + strerror(errno);
+        close(sincronia[0]);
+        close(sincronia[1]);
+        return {};
+    }
+    if (pid == 0) {
+        //o filho espera os contadores serem abertos antes do execve
+        close(sincronia[1]);
+        char byte;
+        while (read(sincronia[0], &byte, 1) < 0 && errno == EINTR) {}
+        int nulo = open("/dev/null", O_RDWR);
+        dup2(nulo, STDIN_FILENO);
+        dup2(nulo, STDOUT_FILENO);
+        alarm(TEMPO_LIMITE_S); // o alarme sobrevive ao execve
+        char* const argv[] = {const_cast<char*>(executavel.c_str()), nullptr};
+        execv(executavel.c_str(), argv);
+        _exit(127);
+    }
+    close(sincronia[0]);
+    std::array<int, NUM_METRICAS> fds;
+    for (size_t m = 0; m < NUM_METRICAS; m++) {
+        fds[m] = abrir_contador(METRICAS[m], pid);
+    }
+    close(sincronia[1]); // libera o filho
+
+    int status = 0;
+    rusage uso {};
+    while (wait4(pid, &status, 0, &uso) < 0 && errno == EINTR) {}
+    Medicao medicao;
+    for (size_t m = 0; m < NUM_METRICAS; m++) {
+        uint64_t valor;
+        if (fds[m] >= 0 && read(fds[m], &valor, sizeof(valor)) == sizeof(valor)) {
+            medicao[m] = valor;
+        }
+        if (fds[m] >= 0) {
+            close(fds[m]);
+        }
+    }
+    if (!medicao[METRICA_TEMPO].has_value()) {
+        auto ns = [](timeval tempo) {
+            return static_cast<uint64_t>(tempo.tv_sec) * 1000000000 + static_cast<uint64_t>(tempo.tv_usec) * 1000;
+        };
+        medicao[METRICA_TEMPO] = ns(uso.ru_utime) + ns(uso.ru_stime);
+    }
+    if (WIFSIGNALED(status)) {
+        int sinal = WTERMSIG(status);
+        motivo = sinal == SIGALRM ? "tempo esgotado (" + std::to_string(TEMPO_LIMITE_S) + " s)" : "terminou com o sinal " + std::string(strsignal(sinal));
+        return {};
+    }
+    codigo = WEXITSTATUS(status);
+    if (codigo == 127) {
+        motivo = "não foi possível executar o programa";
+        return {};
+    }
+    return medicao;
+}
+
+/*
+Lê uma baseline gravada por escrever_baseline. O formato é fixo
+(um objeto "kernels" com um objeto de métricas inteiras por kernel),
+então a leitura só acompanha a profundidade das chaves e guarda
+os números do terceiro nível.
+RETURNS:
+- (std::optional<Baseline>): a baseline, ou vazio caso o arquivo não
+exista, esteja malformado ou seja de outra versão.
+*/
+static std::optional<Baseline> ler_baseline(const std::string& arquivo) {
+    std::ifstream fs_baseline (arquivo);
+    if (!fs_baseline) {
+        return {};
+    }
+    std::string json {std::istreambuf_iterator<char>(fs_baseline), std::istreambuf_iterator<char>()};
+    Baseline baseline;
+    int profundidade = 0;
+    std::string chave;
+    std::string kernel;
+    bool versao_lida = false;
+    size_t i = 0;
+    while (i < json.size()) {
+        char c = json[i];
+        if (c == '{') {
+            profundidade++;
+            if (profundidade == 3) {
+                kernel = chave;
+            }
+            i++;
+        } else if (c == '}') {
+            profundidade--;
+            i++;
+        } else if (c == '"') {
+            chave.clear();
+            for (i++; i < json.size() && json[i] != '"'; i++) {
+                if (json[i] == '\\' && i + 1 < json.size()) {
+                    i++;
+                }
+                chave.push_back(json[i]);
+            }
+            i++;
+        } else if (c >= '0' && c <= '9') {
+            uint64_t valor = 0;
+            auto [fim, erro] = std::from_chars(json.data() + i, json.data() + json.size(), valor);
+            if (erro != std::errc()) {
+                return {};
+            }
+            i = static_cast<size_t>(fim - json.data());
+            if (profundidade == 3) {
+                baseline[kernel][chave] = valor;
+            } else if (profundidade == 1 && chave == "versao") {
+                versao_lida = valor == VERSAO_BASELINE;
+            }
+        } else {
+            i++;
+        }
+    }
+    if (profundidade != 0 || !versao_lida) {
+        return {};
+    }
+    return baseline;
+}
+
+static bool escrever_baseline(const std::string& arquivo, const Baseline& baseline) {
+    std::ofstream fs_baseline (arquivo);
+    fs_baseline << "{\n    \"versao\": " << VERSAO_BASELINE << ",\n    \"kernels\": {";
+    const char* separador_kernel = "\n";
+    for (const auto& [kernel, metricas] : baseline) {
+        fs_baseline << separador_kernel << "        \"" << kernel << "\": {";
+        const char* separador = "\n";
+        for (const auto& [metrica, valor] : metricas) {
+            fs_baseline << separador << "            \"" << metrica << "\": " << valor;
+            separador = ",\n";
+        }
+        fs_baseline << "\n        }";
+        separador_kernel = ",\n";
+    }
+    fs_baseline << "\n    }\n}\n";
+    return static_cast<bool>(fs_baseline);
+}
+
+int main(int argc, char* argv[]) {
+    const char* arquivo_baseline = nullptr;
+    const char* arquivo_gravar = nullptr;
+    double limite = 2.0;
+    double limite_tempo = 10.0;
+    int repeticoes = 5;
+    mlc::Options opts;
+    std::vector<std::filesystem::path> caminhos;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "--baseline" && i + 1 < argc) {
+            arquivo_baseline = argv[++i];
+        } else if (arg == "--gravar" && i + 1 < argc) {
+            arquivo_gravar = argv[++i];
+        } else if (arg == "--limite" && i + 1 < argc) {
+            limite = std::max(0.0, std::atof(argv[++i]));
+        } else if (arg == "--limite-tempo" && i + 1 < argc) {
+            limite_tempo = std::max(0.0, std::atof(argv[++i]));
+        } else if (arg == "--repeticoes" && i + 1 < argc) {
+            repeticoes = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--avx2") {
+            opts.avx2 = true;
+        } else if (arg == "--sem-otimizacao") {
+            opts.otimizar = false;
+        } else if (!arg.starts_with("-")) {
+            caminhos.emplace_back(argv[i]);
+        } else {
+            caminhos.clear();
+            break;
+        }
+    }
+    if (caminhos.empty()) {
+        std::fprintf(stderr, "Uso: bench_codigo [--baseline <base.json>] [--gravar <base.json>] [--limite porcentagem] "
+            "[--limite-tempo porcentagem] [--repeticoes n] [--avx2] [--sem-otimizacao] <diretório | arquivo.ml>...\n");
+        return EXIT_FAILURE;
+    }
+    if (!mlc::no_path("nasm") || !mlc::no_path("ld")) {
+        std::fprintf(stderr, "nasm ou ld não encontrados no PATH; benchmark pulado.\n");
+        return mlc::CODIGO_PULADO;
+    }
+    std::optional<Baseline> baseline;
+    if (arquivo_baseline != nullptr) {
+        baseline = ler_baseline(arquivo_baseline);
+        if (!baseline.has_value()) {
+            std::fprintf(stderr, "Não foi possível ler a baseline '%s'.\n", arquivo_baseline);
+            return EXIT_FAILURE;
+        }
+    }
+    char modelo[] = "/tmp/mlc-bench-XXXXXX";
+    if (mkdtemp(modelo) == nullptr) {
+        std::fprintf(stderr, "Não foi possível criar o diretório temporário: %s\n", strerror(errno));
+        return EXIT_FAILURE;
+    }
+    std::string executavel = std::string(modelo) + "/kernel";
+
+    mlc::Compiler compiler(opts);
+    Baseline atual;
+    size_t num_falhas = 0;
+    size_t num_regressoes = 0;
+    bool avisou_hardware = false;
+    for (const Kernel& kernel : buscar_kernels(caminhos)) {
+        mlc::Montador montador;
+        mlc::Result result = compiler.compile(kernel.src, [&](std::string_view chunk) {
+            montador.escrever(chunk);
+        });
+        std::optional<std::string> erro = result.ok() ? montador.finalizar(executavel) : result.erro->mensagem;
+        Medicao minimo;
+        for (int r = 0; r < repeticoes && !erro.has_value(); r++) {
+            int codigo = 0;
+            std::string motivo;
+            std::optional<Medicao> medicao = medir(executavel, codigo, motivo);
+            if (!medicao.has_value()) {
+                erro = motivo;
+            } else if (kernel.exit_esperado.has_value() && codigo != kernel.exit_esperado.value()) {
+                // um programa mais rápido e errado não conta como melhora
+                erro = "código de saída " + std::to_string(codigo) + ", esperava-se " + std::to_string(kernel.exit_esperado.value());
+            } else {
+                for (size_t m = 0; m < NUM_METRICAS; m++) {
+                    if (medicao->at(m).has_value()) {
+                        minimo[m] = std::min(minimo[m].value_or(UINT64_MAX), medicao->at(m).value());
+                    }
+                }
+            }
+        }
+        unlink(executavel.c_str());
+        if (erro.has_value()) {
+            std::printf("%-20s FALHOU: %s\n", kernel.nome.c_str(), erro->c_str());
+            num_falhas++;
+            continue;
+        }
+        if (!minimo[0].has_value() && !avisou_hardware) {
+            std::printf("Contadores de hardware indisponíveis (sem PMU ou perf_event_paranoid > 2); usando contadores de software.\n");
+            avisou_hardware = true;
+        }
+
+        std::printf("%s\n", kernel.nome.c_str());
+        const std::map<std::string, uint64_t>* base = nullptr;
+        if (baseline.has_value() && baseline->contains(kernel.nome)) {
+            base = &baseline->at(kernel.nome);
+        }
+        for (size_t m = 0; m < NUM_METRICAS; m++) {
+            if (!minimo[m].has_value()) {
+                continue;
+            }
+            uint64_t valor = minimo[m].value();
+            atual[kernel.nome][METRICAS[m].nome] = valor;
+            std::printf("    %-18s %16llu", METRICAS[m].nome, static_cast<unsigned long long>(valor));
+            std::optional<uint64_t> referencia;
+            if (base != nullptr) {
+                if (auto it = base->find(METRICAS[m].nome); it != base->end()) {
+                    referencia = it->second;
+                }
+            }
+            if (referencia.has_value()) {
+                double variacao = referencia.value() == 0 ? 0.0 : (static_cast<double>(valor) / static_cast<double>(referencia.value()) - 1.0) * 100.0;
+                double limite_metrica = METRICAS[m].tempo ? limite_tempo : limite;
+                bool regressao = static_cast<double>(valor) > static_cast<double>(referencia.value()) * (1.0 + limite_metrica / 100.0);
+                std::printf("   base %16llu  %+7.2f%%%s", static_cast<unsigned long long>(referencia.value()), variacao, regressao ? "  REGRESSÃO" : "");
+                num_regressoes += regressao;
+            }
+            std::printf("\n");
+        }
+    }
+    rmdir(modelo);
+
+    if (arquivo_gravar != nullptr && !escrever_baseline(arquivo_gravar, atual)) {
+        std::fprintf(stderr, "Não foi possível escrever a baseline '%s'.\n", arquivo_gravar);
+        return EXIT_FAILURE;
+    }
+    if (baseline.has_value()) {
+        std::printf("%zu regressões (limites: %.1f%%, %.1f%% para tempo), %zu kernels falharam\n", num_regressoes, limite, limite_tempo, num_falhas);
+    }
+    return num_falhas == 0 && num_regressoes == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,38 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "./tokenization.hpp"
+#include "./parser.hpp"
+
+/*
+Benchmark do parser de expressões. Gera um programa com muitas
+expressões aritméticas e mede o tempo de parsing e o número de
+nós alocados na arena por termo e por operador.
+USO: bench_expressoes [num_statements]
+*/
+
+int main(int argc, char* argv[]) {
+    size_t num_statmts = argc > 1 ? std::stoul(argv[1]) : 100000;
+    std::string src = "var a = 1;\nvar b = 2;\nvar c = 3;\n";
+    for (size_t i = 0; i < num_statmts; i++) {
+        src += "c = (a + b) * c - a / 2 + b * (c - 1) > a + " + std::to_string(i) + ";\n";
+    }
+    // cada statement acima tem 10 termos simples, 2 termos entre parênteses e 9 operadores
+
+    Tokenizer tokenizer(src);
+    std::vector<Token> tokens = tokenizer.tokenize();
+    ArenaAlloc alloc(1024 * 1024 * 4);
+    Parser parser(std::move(tokens), alloc);
+    auto inicio = std::chrono::steady_clock::now();
+    std::optional<node::Program> program = parser.parse_program();
+    auto fim = std::chrono::steady_clock::now();
+
+    double ms = std::chrono::duration<double, std::milli>(fim - inicio).count();
+    std::printf("statements:          %zu\n", program.value().statmts.size());
+    std::printf("tempo de parsing:    %.2f ms\n", ms);
+    std::printf("nós alocados:        %zu\n", alloc.num_allocs());
+    std::printf("nós por statement:   %.2f\n", static_cast<double>(alloc.num_allocs()) / static_cast<double>(program.value().statmts.size()));
+    return 0;
+}
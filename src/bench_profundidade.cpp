@@ -0,0 +1,79 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <functional>
+
+#include "./compilador.hpp"
+
+/*
+Benchmark de profundidade de aninhamento. Gera programas com
+parênteses, escopos e 'ifs' aninhados em profundidades de 10^3
+a 10^6 e mede o tempo de compilação (tokenização, parsing e
+geração) por nível. Como o parser e o Generator usam pilhas
+explícitas, o tempo por nível deve permanecer estável conforme
+a profundidade cresce.
+USO: bench_profundidade [profundidade_maxima]
+*/
+
+static std::string gerar_parenteses(size_t profundidade) {
+    std::string src = "exit(";
+    src.append(profundidade, '(');
+    src += "1";
+    src.append(profundidade, ')');
+    src += ");";
+    return src;
+}
+
+static std::string gerar_escopos(size_t profundidade) {
+    std::string src;
+    src.append(profundidade, '{');
+    src += "exit(1);";
+    src.append(profundidade, '}');
+    return src;
+}
+
+static std::string gerar_ifs(size_t profundidade) {
+    std::string src = "var x = 1;\n";
+    for (size_t i = 0; i < profundidade; i++) {
+        src += "if (x) {";
+    }
+    src += "x = 2;";
+    src.append(profundidade, '}');
+    src += "exit(x);";
+    return src;
+}
+
+int main(int argc, char* argv[]) {
+    size_t profundidade_maxima = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    struct Caso {
+        const char* nome;
+        std::function<std::string(size_t)> gerar;
+    };
+    Caso casos[] = {
+        {"parenteses", gerar_parenteses},
+        {"escopos", gerar_escopos},
+        {"ifs", gerar_ifs},
+    };
+
+    mlc::Compiler compiler;
+    std::printf("%-12s %12s %12s %12s %12s\n", "caso", "profundidade", "ms", "ns/nivel", "MB/s");
+    for (const Caso& caso : casos) {
+        for (size_t profundidade = 1000; profundidade <= profundidade_maxima; profundidade *= 10) {
+            std::string src = caso.gerar(profundidade);
+            size_t bytes_asm = 0;
+            auto inicio = std::chrono::steady_clock::now();
+            mlc::Result result = compiler.compile(src, [&](std::string_view chunk) {
+                bytes_asm += chunk.size();
+            });
+            auto fim = std::chrono::steady_clock::now();
+            if (!result.ok()) {
+                std::fprintf(stderr, "%s (%zu): %s\n", caso.nome, profundidade, result.erro->mensagem.c_str());
+                return 1;
+            }
+            double ns = std::chrono::duration<double, std::nano>(fim - inicio).count();
+            std::printf("%-12s %12zu %12.2f %12.1f %12.1f\n", caso.nome, profundidade, ns / 1e6,
+                ns / static_cast<double>(profundidade), static_cast<double>(src.size()) / (ns / 1e9) / 1e6);
+        }
+    }
+    return 0;
+}
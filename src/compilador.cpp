@@ -0,0 +1,155 @@
+#include <vector>
+
+#include "./compilador.hpp"
+#include "./tokenization.hpp"
+#include "./parser.hpp"
+#include "./otimizador.hpp"
+#include "./gerador.hpp"
+#include "./diagnostico.hpp"
+#include "./trace.hpp"
+
+
+namespace mlc {
+    /*
+    Tokeniza e parseia o código fonte 'src', com os nós na arena 'alloc'.
+    */
+    static node::Program parsear(std::string_view src, ArenaAlloc& alloc) {
+        std::vector<Token> tokens;
+        {
+            MLC_TRACE_SCOPE("tokenize");
+            Tokenizer tokenizer(src);
+            tokens = tokenizer.tokenize();
+        }
+        std::optional<node::Program> program;
+        {
+            MLC_TRACE_SCOPE("parse");
+            Parser parser(std::move(tokens), alloc);
+            program = parser.parse_program();
+        }
+        if (!program.has_value()) {
+            throw ErroCompilacao {.mensagem = "Nenhuma operação de saída.", .offset = 0};
+        }
+        return std::move(program.value());
+    }
+
+    /*
+    Otimiza 'program' e gera o seu código. Com um prelúdio, os nós
+    dele são construídos a partir da AST mapeada e colocados antes
+    dos do programa; os seus offsets começam depois do fim do código
+    fonte (em 'tamanho_fonte' + 1), para que os erros encontrados
+    nele possam ser reconhecidos (checar localizar_erro).
+    PARÂMETROS:
+    - program (node::Program&): AST do programa.
+    - hash (uint64_t): hash do código fonte (checar hash_fonte).
+    - tamanho_fonte (uint32_t): tamanho do código fonte.
+    - opts (const Options&): opções da compilação.
+    - alloc (ArenaAlloc&): arena da AST.
+    - sink (const Sink&): destino do assembly em streaming.
+    RETURNS:
+    - (std::string): o assembly (vazio em streaming).
+    */
+    static std::string gerar(node::Program& program, uint64_t hash, uint32_t tamanho_fonte, const Options& opts, ArenaAlloc& alloc, const Sink& sink) {
+        if (opts.prelude != nullptr) {
+            node::Program prelude;
+            opts.prelude->materializar(prelude, alloc, program.num_contadores, tamanho_fonte + 1);
+            program.statmts.insert(program.statmts.begin(), prelude.statmts.begin(), prelude.statmts.end());
+            program.funcoes.insert(program.funcoes.begin(), prelude.funcoes.begin(), prelude.funcoes.end());
+            program.usa_print = program.usa_print || prelude.usa_print;
+            program.num_contadores += prelude.num_contadores;
+            hash = misturar_hash(hash, opts.prelude->hash_fonte());
+        }
+        if (opts.perfil.has_value() && (opts.perfil->hash_fonte != hash || opts.perfil->contadores.size() != program.num_contadores)) {
+            throw ErroCompilacao {.mensagem = "O perfil não corresponde a este código fonte. Gere-o novamente com o programa instrumentado.", .offset = 0};
+        }
+        if (opts.otimizar) {
+            Otimizador otimizador(program, alloc);
+            otimizador.otimizar();
+        }
+        MLC_TRACE_SCOPE("generate");
+        OpcoesPerfil opcoes_perfil = {
+            .arquivo_saida = opts.gerar_perfil,
+            .hash_fonte = hash,
+            .perfil = opts.perfil.has_value() ? &opts.perfil.value() : nullptr
+        };
+        Generator generator(program, sink, opts.avx2, std::move(opcoes_perfil));
+        return generator.generate_program();
+    }
+
+    /*
+    Executa 'etapas' devolvendo os erros como valor, com linha e
+    coluna. 'localizar' converte um offset do código fonte em
+    Posicao; offsets depois de 'tamanho_fonte' pertencem ao prelúdio.
+    */
+    template <typename Etapas, typename Localizar>
+    static Result executar(const Options& opts, uint32_t tamanho_fonte, Etapas etapas, Localizar localizar) {
+        Result result;
+        try {
+            etapas(result);
+        } catch (ErroCompilacao& erro) {
+            result.erro = std::move(erro);
+        } catch (std::bad_alloc&) {
+            result.erro = ErroCompilacao {.mensagem = "Memória insuficiente para a AST.", .offset = 0};
+        }
+        if (result.erro.has_value()) {
+            // o índice de linhas só é construído quando existe um erro para mostrar
+            Posicao posicao;
+            if (opts.prelude != nullptr && result.erro->offset > tamanho_fonte) {
+                posicao = opts.prelude->localizar(result.erro->offset - tamanho_fonte - 1);
+                result.erro->mensagem = "No prelúdio: " + result.erro->mensagem;
+            } else {
+                posicao = localizar(result.erro->offset);
+            }
+            result.erro->linha = posicao.linha;
+            result.erro->coluna = posicao.coluna;
+        }
+        return result;
+    }
+
+    Compiler::Compiler(Options opts)
+        : m_opts(opts), m_alloc(opts.arena_bytes)
+    {}
+
+    Result Compiler::compile(std::string_view src) {
+        return compile(src, Sink {});
+    }
+
+    Result Compiler::compile(std::string_view src, const Sink& sink) {
+        MLC_TRACE_SCOPE("compile");
+        m_alloc.reset();
+        uint32_t tamanho_fonte = static_cast<uint32_t>(src.size());
+        return executar(m_opts, tamanho_fonte, [&](Result& result) {
+            node::Program program = parsear(src, m_alloc);
+            result.assembly = gerar(program, hash_fonte(src), tamanho_fonte, m_opts, m_alloc, sink);
+        }, [&](uint32_t offset) {
+            return IndiceLinhas(src).localizar(offset);
+        });
+    }
+
+    Result Compiler::compile_ast(const AstBinaria& ast, const Sink& sink) {
+        MLC_TRACE_SCOPE("compile_ast");
+        m_alloc.reset();
+        return executar(m_opts, ast.tamanho_fonte(), [&](Result& result) {
+            node::Program program;
+            ast.materializar(program, m_alloc);
+            result.assembly = gerar(program, ast.hash_fonte(), ast.tamanho_fonte(), m_opts, m_alloc, sink);
+        }, [&](uint32_t offset) {
+            return ast.localizar(offset);
+        });
+    }
+
+    Result Compiler::emit_ast(std::string_view src) {
+        MLC_TRACE_SCOPE("emit_ast");
+        m_alloc.reset();
+        return executar(Options {}, static_cast<uint32_t>(src.size()), [&](Result& result) {
+            node::Program program = parsear(src, m_alloc);
+            result.ast = serializar_ast(program, src);
+        }, [&](uint32_t offset) {
+            return IndiceLinhas(src).localizar(offset);
+        });
+    }
+
+    Result compile(std::string_view src, Options opts) {
+        Compiler compiler(opts);
+        return compiler.compile(src);
+    }
+}
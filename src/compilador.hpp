@@ -0,0 +1,118 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <optional>
+#include <functional>
+#include <memory>
+
+#include "./arena.hpp"
+#include "./ast_binaria.hpp"
+#include "./erro.hpp"
+#include "./perfil.hpp"
+
+/*
+Interface da biblioteca do compilador (libmlc). Permite compilar
+vários programas .ml dentro de um mesmo processo: nenhuma etapa
+chama exit() e nenhum estado global é mantido. Erros são
+devolvidos como valores, junto com o offset no código fonte.
+*/
+namespace mlc {
+    /*
+    Opções de compilação.
+    - arena_bytes (size_t): tamanho da arena usada para os nós da AST.
+    - otimizar (bool): aplica as otimizações da AST (checar otimizador.hpp)
+    antes da geração de código.
+    - avx2 (bool): loops vetorizados usam registradores ymm de 256 bits
+    (AVX2) em vez de xmm de 128 bits (SSE2, presente em todo x86-64).
+    O programa gerado só roda em processadores com AVX2.
+    - gerar_perfil (std::string): se não vazio, o programa gerado conta
+    as execuções de cada escopo e 'if' e grava o perfil nesse arquivo
+    ao terminar (checar perfil.hpp).
+    - perfil (std::optional<Perfil>): perfil gravado por uma execução
+    do mesmo código fonte. Orienta a disposição dos 'ifs' e loops
+    (checar Generator::generate_if).
+    - prelude (std::shared_ptr<const AstBinaria>): AST binária (checar
+    ast_binaria.hpp) de um prelúdio comum a vários programas. Os seus
+    statements são executados antes dos do programa e as suas funções
+    e variáveis podem ser usadas por ele, sem que o prelúdio seja
+    tokenizado e parseado a cada compilação.
+    */
+    struct Options {
+        size_t arena_bytes = 1024 * 1024 * 4;
+        bool otimizar = true;
+        bool avx2 = false;
+        std::string gerar_perfil;
+        std::optional<Perfil> perfil;
+        std::shared_ptr<const AstBinaria> prelude;
+    };
+
+    /*
+    Destino do assembly para compilações em streaming: recebe o
+    código em pedaços, na ordem em que são gerados.
+    */
+    using Sink = std::function<void(std::string_view)>;
+
+    /*
+    Resultado de uma compilação. Em caso de sucesso, 'assembly'
+    contêm o código assembly (nasm, elf64) do programa. Em caso
+    de erro, 'erro' contêm a mensagem e o offset do problema.
+    'ast' contêm a AST binária gerada por Compiler::emit_ast.
+    */
+    struct Result {
+        std::string assembly;
+        std::string ast;
+        std::optional<ErroCompilacao> erro;
+
+        inline bool ok() const {
+            return !erro.has_value();
+        }
+    };
+
+    /*
+    Compilador reutilizável. Mantém a arena da AST entre
+    compilações, de modo que compilações repetidas no mesmo
+    objeto não pagam novamente o custo de alocação inicial.
+    Uma instância não deve ser usada por várias threads ao
+    mesmo tempo; use uma instância por thread.
+    */
+    class Compiler {
+        public:
+            explicit Compiler(Options opts = {});
+
+            Result compile(std::string_view src);
+
+            /*
+            Compila 'src' entregando o assembly em chunks para 'sink'
+            enquanto ele é gerado; Result::assembly fica vazio. Em
+            caso de erro, o que já foi entregue deve ser descartado.
+            */
+            Result compile(std::string_view src, const Sink& sink);
+
+            /*
+            Compila um programa a partir da sua AST binária, sem passar
+            pelo Tokenizer e pelo Parser. Erros são localizados no código
+            fonte original, com a tabela de linhas guardada na AST.
+            */
+            Result compile_ast(const AstBinaria& ast, const Sink& sink = {});
+
+            /*
+            Tokeniza e parseia 'src' e devolve, em Result::ast, a sua AST
+            binária (checar serializar_ast). O prelúdio não é incluído.
+            */
+            Result emit_ast(std::string_view src);
+
+            Compiler(const Compiler&) = delete;
+            Compiler& operator=(const Compiler&) = delete;
+
+        private:
+            Options m_opts;
+            ArenaAlloc m_alloc;
+    };
+
+    /*
+    Compila o código fonte 'src' com as opções 'opts'. Atalho
+    para uma compilação única com um mlc::Compiler temporário.
+    */
+    Result compile(std::string_view src, Options opts = {});
+}
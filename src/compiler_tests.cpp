@@ -0,0 +1,709 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#include "./compilador.hpp"
+#include "./ferramentas.hpp"
+#include "./fila_es.hpp"
+#include "./incremental.hpp"
+#include "./montador.hpp"
+
+extern char** environ;
+
+/*
+Executor dos testes de conformidade. Procura arquivos .ml nos
+diretórios (ou arquivos) recebidos e lê as anotações escritas
+em comentários no próprio programa:
+- '// exit: N': código de saída esperado (0 a 255).
+- '// saida: texto': próxima linha esperada no stdout. Sem essa
+anotação, o programa não deve escrever nada.
+- '// erro: texto': a compilação deve falhar com uma mensagem que
+contenha 'texto'.
+Arquivos sem 'exit' nem 'erro' não são testes e são ignorados.
+Cada thread compila com o seu próprio mlc::Compiler, monta e liga
+com o mlc::Montador e executa o programa com um tempo limite. O
+resultado de cada teste sai com os tempos de compilação (libmlc),
+de montagem (nasm e ld) e de execução. Cada teste também é
+compilado a partir da sua AST binária (checar conferir_ast), sem
+otimizações (checar conferir_sem_otimizacao), com o perfil de
+execução (checar conferir_perfil) e, em versões editadas, pela
+compilação incremental (checar conferir_incremental). Os arquivos
+dos testes também passam pela fila de E/S do compilador (checar
+conferir_fila_es).
+USO: compiler_tests [-j threads] [--timeout ms] [-q] <diretório | arquivo.ml>...
+Retorna 0 quando todos os testes passam, 1 quando algum falha e
+CODIGO_PULADO quando nasm ou ld não estão instalados.
+*/
+
+struct Teste {
+    std::filesystem::path arquivo;
+    std::string src;
+    std::optional<int> exit_esperado;
+    std::string saida_esperada;
+    std::optional<std::string> erro_esperado;
+};
+
+struct Resultado {
+    bool passou = false;
+    std::string motivo;
+    double ms_compilacao = 0;
+    double ms_montagem = 0;
+    double ms_execucao = 0;
+};
+
+struct Execucao {
+    std::optional<int> codigo; // vazio quando o programa não terminou normalmente
+    std::string saida;
+    std::string erro;
+};
+
+using Relogio = std::chrono::steady_clock;
+
+static double ms_desde(Relogio::time_point inicio) {
+    return std::chrono::duration<double, std::milli>(Relogio::now() - inicio).count();
+}
+
+/*
+Lê as anotações de um arquivo .ml. Retorna vazio caso ele não
+seja um teste.
+*/
+static std::optional<Teste> ler_teste(const std::filesystem::path& arquivo) {
+    std::ifstream fs_teste (arquivo, std::ios::in | std::ios::binary);
+    std::stringstream conteudo;
+    conteudo << fs_teste.rdbuf();
+    Teste teste {.arquivo = arquivo, .src = conteudo.str(), .exit_esperado = std::nullopt, .saida_esperada = {}, .erro_esperado = std::nullopt};
+    std::istringstream linhas (teste.src);
+    std::string linha;
+    while (std::getline(linhas, linha)) {
+        if (!linha.empty() && linha.back() == '\r') {
+            linha.pop_back();
+        }
+        size_t comentario = linha.find("//");
+        if (comentario == std::string::npos) {
+            continue;
+        }
+        std::string_view anotacao = std::string_view(linha).substr(comentario + 2);
+        anotacao.remove_prefix(std::min(anotacao.find_first_not_of(' '), anotacao.size()));
+        auto valor = [&](std::string_view chave) -> std::optional<std::string> {
+            if (!anotacao.starts_with(chave)) {
+                return {};
+            }
+            std::string_view resto = anotacao.substr(chave.size());
+            if (!resto.empty() && resto.front() == ' ') {
+                resto.remove_prefix(1);
+            }
+            return std::string(resto);
+        };
+        if (auto codigo = valor("exit:")) {
+            teste.exit_esperado = std::atoi(codigo->c_str());
+        } else if (auto saida = valor("saida:")) {
+            teste.saida_esperada += saida.value() + '\n';
+        } else if (auto erro = valor("erro:")) {
+            teste.erro_esperado = erro.value();
+        }
+    }
+    if (!teste.exit_esperado.has_value() && !teste.erro_esperado.has_value()) {
+        return {};
+    }
+    return teste;
+}
+
+/*
+Procura os testes em cada caminho (recursivamente nos diretórios),
+em ordem alfabética.
+*/
+static std::vector<Teste> buscar_testes(const std::vector<std::filesystem::path>& caminhos) {
+    std::vector<std::filesystem::path> arquivos;
+    for (const std::filesystem::path& caminho : caminhos) {
+        if (std::filesystem::is_directory(caminho)) {
+            for (const auto& entrada : std::filesystem::recursive_directory_iterator(caminho)) {
+                if (entrada.is_regular_file() && entrada.path().extension() == ".ml") {
+                    arquivos.push_back(entrada.path());
+                }
+            }
+        } else {
+            arquivos.push_back(caminho);
+        }
+    }
+    std::sort(arquivos.begin(), arquivos.end());
+    std::vector<Teste> testes;
+    for (const std::filesystem::path& arquivo : arquivos) {
+        if (auto teste = ler_teste(arquivo)) {
+            testes.push_back(std::move(teste.value()));
+        }
+    }
+    return testes;
+}
+
+static std::string ler_memfd(int fd) {
+    std::string conteudo;
+    lseek(fd, 0, SEEK_SET);
+    char buffer[4096];
+    ssize_t lidos;
+    while ((lidos = read(fd, buffer, sizeof(buffer))) > 0) {
+        conteudo.append(buffer, static_cast<size_t>(lidos));
+    }
+    return conteudo;
+}
+
+/*
+Espera o processo 'pid' terminar por até 'timeout_ms'. Usa um
+pidfd quando o kernel oferece (Linux 5.3+), e, caso contrário,
+consulta o processo a cada milissegundo. Retorna o status do
+waitpid, ou vazio se o tempo acabou (o processo é morto).
+*/
+static std::optional<int> esperar(pid_t pid, int timeout_ms) {
+    int status;
+    int pidfd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+    if (pidfd >= 0) {
+        pollfd evento {.fd = pidfd, .events = POLLIN, .revents = 0};
+        int pronto;
+        Relogio::time_point limite = Relogio::now() + std::chrono::milliseconds(timeout_ms);
+        do {
+            int restante = static_cast<int>(std::max<double>(0, -ms_desde(limite)));
+            pronto = poll(&evento, 1, restante);
+        } while (pronto < 0 && errno == EINTR);
+        close(pidfd);
+        if (pronto == 0) {
+            kill(pid, SIGKILL);
+            waitpid(pid, &status, 0);
+            return {};
+        }
+        waitpid(pid, &status, 0);
+        return status;
+    }
+    Relogio::time_point inicio = Relogio::now();
+    while (waitpid(pid, &status, WNOHANG) == 0) {
+        if (ms_desde(inicio) > timeout_ms) {
+            kill(pid, SIGKILL);
+            waitpid(pid, &status, 0);
+            return {};
+        }
+        usleep(1000);
+    }
+    return status;
+}
+
+/*
+Executa o programa 'executavel' com stdin vazio, guardando o
+stdout e o stderr (em memfds, para que nenhum pipe encha).
+*/
+static std::optional<Execucao> executar(const std::string& executavel, int timeout_ms, std::string& motivo) {
+    int fd_saida = memfd_create("mlc-teste-saida", MFD_CLOEXEC);
+    int fd_erro = memfd_create("mlc-teste-erro", MFD_CLOEXEC);
+    posix_spawn_file_actions_t acoes;
+    posix_spawn_file_actions_init(&acoes);
+    posix_spawn_file_actions_addopen(&acoes, 0, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_adddup2(&acoes, fd_saida, 1);
+    posix_spawn_file_actions_adddup2(&acoes, fd_erro, 2);
+    const char* argv[] = {executavel.c_str(), nullptr};
+    pid_t pid;
+    int status_spawn = posix_spawn(&pid, executavel.c_str(), &acoes, nullptr, const_cast<char* const*>(argv), environ);
+    posix_spawn_file_actions_destroy(&acoes);
+    std::optional<Execucao> execucao;
+    if (status_spawn != 0) {
+        motivo = std::string("não foi possível executar o programa: ") + strerror(status_spawn);
+    } else if (std::optional<int> status = esperar(pid, timeout_ms)) {
+        execucao = Execucao {
+            .codigo = WIFEXITED(status.value()) ? std::optional<int>(WEXITSTATUS(status.value())) : std::nullopt,
+            .saida = ler_memfd(fd_saida),
+            .erro = ler_memfd(fd_erro)
+        };
+        if (!execucao->codigo.has_value()) {
+            motivo = "terminou com o sinal " + std::to_string(WTERMSIG(status.value()));
+        }
+    } else {
+        motivo = "tempo limite de " + std::to_string(timeout_ms) + " ms excedido";
+    }
+    close(fd_saida);
+    close(fd_erro);
+    return execucao;
+}
+
+/*
+Abre 'dados' como uma AST binária, passando por um memfd para que
+ela seja mapeada como um arquivo de verdade.
+*/
+static std::optional<std::string> abrir_ast(std::string_view dados, mlc::AstBinaria& ast) {
+    int fd = memfd_create("mlc-teste-ast", MFD_CLOEXEC);
+    if (fd < 0) {
+        return std::string("memfd_create: ") + strerror(errno);
+    }
+    for (size_t escritos = 0; escritos < dados.size();) {
+        ssize_t n = write(fd, dados.data() + escritos, dados.size() - escritos);
+        if (n <= 0) {
+            close(fd);
+            return std::string("write: ") + strerror(errno);
+        }
+        escritos += static_cast<size_t>(n);
+    }
+    std::optional<std::string> erro = ast.abrir("/proc/self/fd/" + std::to_string(fd));
+    close(fd);
+    return erro;
+}
+
+/*
+Confere que uma AST binária danificada, usada como prelúdio, é
+recusada sem derrubar o compilador: truncada, ela não é aberta; com
+o tipo de um nó inválido, ela é aberta mas a compilação falha com
+"AST binária corrompida."; com o primeiro filho de um nó apontando
+para o próprio nó, a compilação pode até funcionar (se o tipo não
+usa o campo), mas nunca lê fora do arquivo.
+*/
+static std::optional<std::string> conferir_ast_corrompida(const std::string& dados) {
+    mlc::AstBinaria truncada;
+    if (!abrir_ast(std::string_view(dados).substr(0, dados.size() - 1), truncada).has_value()) {
+        return std::string("uma AST binária truncada foi aberta como prelúdio");
+    }
+    mlc::CabecalhoAst cabecalho;
+    std::memcpy(&cabecalho, dados.data(), sizeof(cabecalho));
+    for (uint32_t i = 0; i < cabecalho.num_nos; i++) {
+        size_t posicao = sizeof(mlc::CabecalhoAst) + size_t(i) * sizeof(mlc::NoAst);
+        for (bool tipo_invalido : {true, false}) {
+            std::string corrompidos = dados;
+            if (tipo_invalido) {
+                corrompidos[posicao + offsetof(mlc::NoAst, tipo)] = static_cast<char>(0xFF);
+            } else {
+                std::memcpy(corrompidos.data() + posicao + offsetof(mlc::NoAst, a), &i, sizeof(i));
+            }
+            auto prelude = std::make_shared<mlc::AstBinaria>();
+            if (std::optional<std::string> erro = abrir_ast(corrompidos, *prelude)) {
+                return "AST binária: " + erro.value();
+            }
+            mlc::Options opts;
+            opts.prelude = prelude;
+            mlc::Result resultado = mlc::compile("exit(0);", opts);
+            if (tipo_invalido && (resultado.ok() || resultado.erro->mensagem != "AST binária corrompida.")) {
+                return "um prelúdio com o nó " + std::to_string(i) + " inválido não foi recusado";
+            }
+        }
+    }
+    return {};
+}
+
+/*
+Confere a AST binária do teste: o programa compilado a partir
+dela deve gerar o mesmo assembly, ou o mesmo erro na mesma linha
+e coluna, que o compilado a partir do código fonte, e versões
+danificadas dela devem ser recusadas (checar conferir_ast_corrompida).
+*/
+static std::optional<std::string> conferir_ast(const Teste& teste, mlc::Compiler& compiler) {
+    mlc::Result emissao = compiler.emit_ast(teste.src);
+    if (!emissao.ok()) {
+        return {}; // erros de sintaxe não chegam a gerar uma AST
+    }
+    mlc::AstBinaria ast;
+    if (std::optional<std::string> erro = abrir_ast(emissao.ast, ast)) {
+        return "AST binária: " + erro.value();
+    }
+    if (std::optional<std::string> erro = conferir_ast_corrompida(emissao.ast)) {
+        return erro;
+    }
+    mlc::Result fonte = compiler.compile(teste.src);
+    mlc::Result binaria = compiler.compile_ast(ast);
+    bool iguais = fonte.ok() == binaria.ok() && fonte.assembly == binaria.assembly;
+    if (iguais && !fonte.ok()) {
+        iguais = fonte.erro->mensagem == binaria.erro->mensagem && fonte.erro->linha == binaria.erro->linha && fonte.erro->coluna == binaria.erro->coluna;
+    }
+    if (!iguais) {
+        return std::string("a compilação a partir da AST binária difere da compilação do código fonte");
+    }
+    return {};
+}
+
+/*
+Confere que as otimizações não mudam a validade do teste: a
+compilação sem otimizações (como no modo --watch e com
+--sem-otimizacao) deve falhar com o mesmo erro, na mesma linha, que
+'compilacao', ou compilar caso ela tenha compilado.
+*/
+static std::optional<std::string> conferir_sem_otimizacao(const Teste& teste, const mlc::Result& compilacao) {
+    mlc::Options opts;
+    opts.otimizar = false;
+    mlc::Compiler compiler (opts);
+    mlc::Result resultado = compiler.compile(teste.src);
+    if (resultado.ok() && !compilacao.ok()) {
+        return "compilou sem otimizações, mas a compilação otimizada falhou: " + compilacao.erro->mensagem;
+    }
+    if (!resultado.ok() && (compilacao.ok() || resultado.erro->mensagem != compilacao.erro->mensagem || resultado.erro->linha != compilacao.erro->linha)) {
+        return "erro de compilação sem otimizações na linha " + std::to_string(resultado.erro->linha) + ": " + resultado.erro->mensagem;
+    }
+    return {};
+}
+
+/*
+Confere o perfil de execução do teste: o programa instrumentado
+(Options::gerar_perfil) e o compilado com o perfil que ele gravou
+(Options::perfil) devem ter o resultado esperado pelas anotações.
+O mesmo perfil deve ser recusado para outra versão do código fonte,
+e um perfil truncado não deve ser lido.
+*/
+static std::optional<std::string> conferir_perfil(const Teste& teste, const std::string& executavel, int timeout_ms) {
+    std::string arquivo_perfil = executavel + ".perfil";
+    auto rodar = [&](const mlc::Options& opts, std::string_view etapa) -> std::optional<std::string> {
+        mlc::Compiler compiler (opts);
+        mlc::Montador montador;
+        mlc::Result compilacao = compiler.compile(teste.src, [&](std::string_view chunk) {
+            montador.escrever(chunk);
+        });
+        if (!compilacao.ok()) {
+            return std::string(etapa) + ": erro de compilação: " + compilacao.erro->mensagem;
+        }
+        if (std::optional<std::string> erro = montador.finalizar(executavel)) {
+            return std::string(etapa) + ": " + erro.value();
+        }
+        std::string motivo;
+        std::optional<Execucao> execucao = executar(executavel, timeout_ms, motivo);
+        unlink(executavel.c_str());
+        if (!execucao.has_value() || !execucao->codigo.has_value()) {
+            return std::string(etapa) + ": " + motivo;
+        }
+        if (execucao->codigo.value() != teste.exit_esperado.value() || execucao->saida != teste.saida_esperada) {
+            return std::string(etapa) + ": código de saída " + std::to_string(execucao->codigo.value()) + " ou stdout diferente do esperado";
+        }
+        return {};
+    };
+
+    mlc::Options opts;
+    opts.gerar_perfil = arquivo_perfil;
+    std::optional<std::string> erro = rodar(opts, "programa instrumentado");
+    opts.gerar_perfil.clear();
+    opts.perfil = mlc::ler_perfil(arquivo_perfil);
+    if (!erro.has_value() && !opts.perfil.has_value()) {
+        erro = "o programa instrumentado não gravou o perfil";
+    }
+    if (!erro.has_value()) {
+        erro = rodar(opts, "compilação com o perfil");
+    }
+    if (!erro.has_value()) {
+        mlc::Result outra_versao = mlc::compile(teste.src + "\n", opts);
+        if (outra_versao.ok() || outra_versao.erro->mensagem.find("O perfil não corresponde") == std::string::npos) {
+            erro = "o perfil foi aceito para outra versão do código fonte";
+        }
+    }
+    if (!erro.has_value()) {
+        std::filesystem::resize_file(arquivo_perfil, std::filesystem::file_size(arquivo_perfil) - 8);
+        if (mlc::ler_perfil(arquivo_perfil).has_value()) {
+            erro = "um perfil truncado foi lido";
+        }
+    }
+    unlink(arquivo_perfil.c_str());
+    return erro;
+}
+
+/*
+Versões do teste usadas por conferir_incremental, cada uma com uma
+edição sobre o código original (que também é a primeira e a última):
+- uma linha em branco no meio, que só desloca os offsets;
+- uma declaração nova no meio, que desloca a stack de tudo o que vem
+depois (ou muda o corpo de uma função, se o meio estiver numa);
+- o valor da primeira declaração 'var x = ...;' somado de 1;
+- o valor do primeiro 'return' da primeira função somado de 1, que
+muda o corpo de uma função (expandida no local, se for pequena).
+Edições que não se aplicam ao teste (sem 'var' ou sem funções) são
+omitidas.
+*/
+static std::vector<std::string> editar(const std::string& src) {
+    size_t meio = src.find('\n', src.size() / 2);
+    meio = meio == std::string::npos ? src.size() : meio + 1;
+    std::vector<std::string> versoes {src};
+    versoes.push_back(src.substr(0, meio) + "\n" + src.substr(meio));
+    versoes.push_back(src.substr(0, meio) + "var mlcextra = 7;\n" + src.substr(meio));
+    //envolve o valor entre 'inicio' e o próximo ';' da mesma linha com '(...) + 1'
+    auto somar_1 = [&](size_t inicio) {
+        size_t fim = src.find(';', inicio);
+        if (inicio == std::string::npos || fim == std::string::npos || src.find('\n', inicio) < fim) {
+            return;
+        }
+        versoes.push_back(src.substr(0, inicio) + "(" + src.substr(inicio, fim - inicio) + ") + 1" + src.substr(fim));
+    };
+    for (size_t var = src.find("var "); var != std::string::npos; var = src.find("var ", var + 1)) {
+        size_t igual = src.find(" = ", var);
+        if (igual != std::string::npos && igual < src.find(';', var)) {
+            somar_1(igual + 3);
+            break;
+        }
+    }
+    if (size_t fn = src.find("fn "); fn != std::string::npos) {
+        if (size_t ret = src.find("return ", fn); ret != std::string::npos) {
+            somar_1(ret + 7);
+        }
+    }
+    versoes.push_back(src);
+    return versoes;
+}
+
+/*
+Confere a compilação incremental (modo --watch) do teste: cada versão
+de editar() é compilada, em sequência, pela mesma
+mlc::CompilacaoIncremental e ligada pelo mlc::MontadorIncremental, e
+deve ter o mesmo erro, ou o mesmo código de saída e stdout, que uma
+compilação completa da mesma versão (sem otimizações, como no modo
+--watch). Versões cuja compilação completa não termina no tempo
+limite não são comparadas.
+*/
+static std::optional<std::string> conferir_incremental(const Teste& teste, const std::string& executavel, int timeout_ms) {
+    mlc::Options opts;
+    opts.otimizar = false;
+    mlc::CompilacaoIncremental compilacao (opts);
+    mlc::MontadorIncremental montador;
+    mlc::Compiler completo (opts);
+    std::string executavel_completo = executavel + ".completo";
+    std::vector<std::string> versoes = editar(teste.src);
+    for (size_t v = 0; v < versoes.size(); v++) {
+        std::string prefixo = "compilação incremental (versão " + std::to_string(v + 1) + "): ";
+        mlc::Result resultado = compilacao.atualizar(versoes[v]);
+        mlc::Montador montador_completo;
+        mlc::Result esperado = completo.compile(versoes[v], [&](std::string_view chunk) {
+            montador_completo.escrever(chunk);
+        });
+        if (resultado.ok() != esperado.ok()) {
+            return prefixo + (resultado.ok() ? "compilou, mas a compilação completa falhou: " + esperado.erro->mensagem
+                : "erro na linha " + std::to_string(resultado.erro->linha) + ": " + resultado.erro->mensagem);
+        }
+        if (!esperado.ok()) {
+            if (resultado.erro->mensagem != esperado.erro->mensagem || resultado.erro->linha != esperado.erro->linha) {
+                return prefixo + "erro diferente da compilação completa: " + resultado.erro->mensagem;
+            }
+            continue;
+        }
+        if (std::optional<std::string> erro = montador_completo.finalizar(executavel_completo)) {
+            return prefixo + "compilação completa: " + erro.value();
+        }
+        std::string motivo;
+        std::optional<Execucao> execucao_completa = executar(executavel_completo, timeout_ms, motivo);
+        unlink(executavel_completo.c_str());
+        if (!execucao_completa.has_value()) {
+            continue;
+        }
+        if (std::optional<std::string> erro = montador.atualizar(compilacao.blocos(), executavel)) {
+            return prefixo + erro.value();
+        }
+        std::optional<Execucao> execucao = executar(executavel, timeout_ms, motivo);
+        unlink(executavel.c_str());
+        if (!execucao.has_value()) {
+            return prefixo + motivo;
+        }
+        if (execucao->codigo != execucao_completa->codigo || execucao->saida != execucao_completa->saida) {
+            return prefixo + "código de saída ou stdout diferente da compilação completa";
+        }
+    }
+    return {};
+}
+
+/*
+Confere a mlc::FilaES, usada pelo compilador quando recebe vários
+arquivos: os testes são lidos e escritos de novo no diretório
+temporário pela fila com io_uring (quando o kernel oferece) e com
+pread/pwrite, e o conteúdo deve ser o mesmo lido por ler_teste. A
+SQ pequena faz com que os lotes tenham mais operações do que cabem
+em voo ao mesmo tempo.
+*/
+static std::optional<std::string> conferir_fila_es(const std::vector<Teste>& testes, const std::string& diretorio) {
+    std::optional<std::string> erro;
+    for (bool io_uring : {true, false}) {
+        mlc::FilaES fila (4, io_uring);
+        if (io_uring && !fila.usa_io_uring()) {
+            continue; // kernel sem io_uring: só o fallback é conferido
+        }
+        std::string modo = io_uring ? "io_uring" : "pread/pwrite";
+        std::vector<size_t> leituras;
+        for (const Teste& teste : testes) {
+            leituras.push_back(fila.ler(teste.arquivo.string()));
+        }
+        fila.enviar();
+        std::vector<std::pair<size_t, size_t>> escritas; // operação e teste
+        for (size_t k = 0; k < testes.size(); k++) {
+            mlc::ResultadoES lido = fila.esperar(leituras[k]);
+            if (lido.erro.has_value() || lido.conteudo != testes[k].src) {
+                erro = erro.value_or("fila de E/S (" + modo + "): leitura diferente de " + testes[k].arquivo.string());
+                continue;
+            }
+            escritas.emplace_back(fila.escrever(diretorio + "/fila" + std::to_string(k), std::move(lido.conteudo)), k);
+        }
+        fila.enviar();
+        for (const auto& [escrita, k] : escritas) {
+            mlc::ResultadoES escrito = fila.esperar(escrita);
+            std::string copia = diretorio + "/fila" + std::to_string(k);
+            std::ifstream fs_copia (copia, std::ios::in | std::ios::binary);
+            std::stringstream conteudo;
+            conteudo << fs_copia.rdbuf();
+            if (escrito.erro.has_value() || conteudo.str() != testes[k].src) {
+                erro = erro.value_or("fila de E/S (" + modo + "): escrita diferente de " + testes[k].arquivo.string());
+            }
+            unlink(copia.c_str());
+        }
+    }
+    return erro;
+}
+
+/*
+Compila, monta e executa um teste, comparando o resultado com
+as anotações.
+*/
+static Resultado rodar_teste(const Teste& teste, mlc::Compiler& compiler, const std::string& executavel, int timeout_ms) {
+    Resultado resultado;
+    mlc::Montador montador;
+    Relogio::time_point inicio = Relogio::now();
+    mlc::Result compilacao = compiler.compile(teste.src, [&](std::string_view chunk) {
+        montador.escrever(chunk);
+    });
+    resultado.ms_compilacao = ms_desde(inicio);
+    if (std::optional<std::string> motivo = conferir_ast(teste, compiler)) {
+        resultado.motivo = motivo.value();
+        return resultado;
+    }
+    if (std::optional<std::string> motivo = conferir_sem_otimizacao(teste, compilacao)) {
+        resultado.motivo = motivo.value();
+        return resultado;
+    }
+    if (teste.erro_esperado.has_value()) {
+        if (compilacao.ok()) {
+            resultado.motivo = "compilou, mas esperava-se o erro '" + teste.erro_esperado.value() + "'";
+        } else if (compilacao.erro->mensagem.find(teste.erro_esperado.value()) == std::string::npos) {
+            resultado.motivo = "erro de compilação diferente: " + compilacao.erro->mensagem;
+        } else if (std::optional<std::string> motivo = conferir_incremental(teste, executavel, timeout_ms)) {
+            resultado.motivo = motivo.value();
+        } else {
+            resultado.passou = true;
+        }
+        return resultado;
+    }
+    if (!compilacao.ok()) {
+        resultado.motivo = "erro de compilação na linha " + std::to_string(compilacao.erro->linha) + ": " + compilacao.erro->mensagem;
+        return resultado;
+    }
+    inicio = Relogio::now();
+    std::optional<std::string> erro_montagem = montador.finalizar(executavel);
+    resultado.ms_montagem = ms_desde(inicio);
+    if (erro_montagem.has_value()) {
+        resultado.motivo = erro_montagem.value();
+        return resultado;
+    }
+    inicio = Relogio::now();
+    std::optional<Execucao> execucao = executar(executavel, timeout_ms, resultado.motivo);
+    resultado.ms_execucao = ms_desde(inicio);
+    unlink(executavel.c_str());
+    if (!execucao.has_value() || !execucao->codigo.has_value()) {
+        return resultado;
+    }
+    if (execucao->codigo.value() != teste.exit_esperado.value()) {
+        resultado.motivo = "código de saída " + std::to_string(execucao->codigo.value()) + ", esperava-se " + std::to_string(teste.exit_esperado.value());
+        if (!execucao->erro.empty()) {
+            resultado.motivo += " (stderr: " + execucao->erro.substr(0, execucao->erro.find('\n')) + ")";
+        }
+    } else if (execucao->saida != teste.saida_esperada) {
+        resultado.motivo = "stdout diferente do esperado:\n--- esperado\n" + teste.saida_esperada + "--- obtido\n" + execucao->saida.substr(0, 4096);
+    } else if (std::optional<std::string> motivo = conferir_perfil(teste, executavel, timeout_ms)) {
+        resultado.motivo = motivo.value();
+    } else if (std::optional<std::string> motivo = conferir_incremental(teste, executavel, timeout_ms)) {
+        resultado.motivo = motivo.value();
+    } else {
+        resultado.passou = true;
+    }
+    return resultado;
+}
+
+int main(int argc, char* argv[]) {
+    unsigned num_threads = std::max(1u, std::thread::hardware_concurrency());
+    int timeout_ms = 10000;
+    bool silencioso = false;
+    std::vector<std::filesystem::path> caminhos;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            num_threads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--timeout" && i + 1 < argc) {
+            timeout_ms = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-q") {
+            silencioso = true;
+        } else if (!arg.starts_with("-")) {
+            caminhos.emplace_back(argv[i]);
+        } else {
+            caminhos.clear();
+            break;
+        }
+    }
+    if (caminhos.empty()) {
+        std::fprintf(stderr, "Uso: compiler_tests [-j threads] [--timeout ms] [-q] <diretório | arquivo.ml>...\n");
+        return EXIT_FAILURE;
+    }
+    if (!mlc::no_path("nasm") || !mlc::no_path("ld")) {
+        std::fprintf(stderr, "nasm ou ld não encontrados no PATH; testes pulados.\n");
+        return mlc::CODIGO_PULADO;
+    }
+
+    std::vector<Teste> testes = buscar_testes(caminhos);
+    std::vector<Resultado> resultados (testes.size());
+    char modelo[] = "/tmp/mlc-testes-XXXXXX";
+    if (mkdtemp(modelo) == nullptr) {
+        std::fprintf(stderr, "Não foi possível criar o diretório temporário: %s\n", strerror(errno));
+        return EXIT_FAILURE;
+    }
+    std::string diretorio = modelo;
+    std::optional<std::string> erro_fila = conferir_fila_es(testes, diretorio);
+
+    //cada thread pega o próximo teste da fila até que ela acabe
+    Relogio::time_point inicio = Relogio::now();
+    std::atomic<size_t> proximo = 0;
+    std::vector<std::thread> threads;
+    num_threads = static_cast<unsigned>(std::min<size_t>(num_threads, std::max<size_t>(testes.size(), 1)));
+    for (unsigned t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t]() {
+            mlc::Compiler compiler;
+            std::string executavel = diretorio + "/t" + std::to_string(t);
+            for (size_t k = proximo++; k < testes.size(); k = proximo++) {
+                resultados[k] = rodar_teste(testes[k], compiler, executavel, timeout_ms);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    double ms_total = ms_desde(inicio);
+    rmdir(diretorio.c_str());
+
+    size_t num_falhas = 0;
+    for (size_t k = 0; k < testes.size(); k++) {
+        const Resultado& resultado = resultados[k];
+        num_falhas += !resultado.passou;
+        if (silencioso && resultado.passou) {
+            continue;
+        }
+        std::printf("%s  %-40s  compilação %8.3f ms  montagem %8.3f ms  execução %8.3f ms\n",
+            resultado.passou ? "PASSOU" : "FALHOU", testes[k].arquivo.string().c_str(),
+            resultado.ms_compilacao, resultado.ms_montagem, resultado.ms_execucao);
+        if (!resultado.passou) {
+            std::printf("        %s\n", resultado.motivo.c_str());
+        }
+    }
+    if (erro_fila.has_value()) {
+        std::printf("FALHOU  %s\n", erro_fila->c_str());
+    }
+    std::printf("%zu testes, %zu passaram, %zu falharam (%.1f ms, %u threads)\n",
+        testes.size(), testes.size() - num_falhas, num_falhas, ms_total, num_threads);
+    return num_falhas == 0 && !erro_fila.has_value() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+#include <string_view>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+/*
+Linha e coluna (ambas começando em 1) de uma posição no código fonte.
+*/
+struct Posicao {
+    uint32_t linha;
+    uint32_t coluna;
+};
+
+/*
+Índice com o offset do início de cada linha do código fonte. Os
+tokens guardam apenas o offset em bytes, então o tokenizador não
+precisa contar linhas e colunas a cada caracter; o índice só é
+construído quando um diagnóstico precisa ser mostrado.
+*/
+class IndiceLinhas {
+    public:
+        /*
+        Constrói o índice em uma única passada pelo código fonte,
+        procurando os '\n' com memchr (que a libc implementa com
+        instruções vetoriais).
+        PARÂMETROS:
+        - src (std::string_view): código fonte.
+        */
+        inline explicit IndiceLinhas(std::string_view src) {
+            m_inicios.push_back(0);
+            const char* inicio = src.data();
+            const char* fim = src.data() + src.size();
+            const char* atual = inicio;
+            while (atual < fim) {
+                const void* quebra = std::memchr(atual, '\n', static_cast<size_t>(fim - atual));
+                if (quebra == nullptr) {
+                    break;
+                }
+                atual = static_cast<const char*>(quebra) + 1;
+                m_inicios.push_back(static_cast<uint32_t>(atual - inicio));
+            }
+        }
+
+        /*
+        Método que converte um offset em linha e coluna, através
+        de uma busca binária no índice.
+        PARÂMETROS:
+        - offset (uint32_t): posição, em bytes, no código fonte.
+        RETURNS:
+        - (Posicao): linha e coluna da posição.
+        */
+        inline Posicao localizar(uint32_t offset) const {
+            auto it = std::upper_bound(m_inicios.begin(), m_inicios.end(), offset);
+            size_t linha = static_cast<size_t>(it - m_inicios.begin()); // 'it' aponta para a linha seguinte
+            return {.linha = static_cast<uint32_t>(linha), .coluna = offset - m_inicios[linha - 1] + 1};
+        }
+
+        /*
+        Offsets do início de cada linha, em ordem (checar serializar_ast).
+        */
+        inline const std::vector<uint32_t>& inicios() const {
+            return m_inicios;
+        }
+
+    private:
+        std::vector<uint32_t> m_inicios; // offset do primeiro byte de cada linha
+};
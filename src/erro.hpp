@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+/*
+Erro de compilação. As etapas internas (tokenização, parsing
+e geração de código) lançam um ErroCompilacao quando encontram
+um problema, e a fronteira da biblioteca (mlc::Compiler) o
+captura e devolve como valor dentro de mlc::Result. Assim,
+nenhuma etapa encerra o processo com exit().
+- mensagem (std::string): descrição do erro.
+- offset (uint32_t): posição, em bytes, no código fonte onde
+o erro foi encontrado.
+- linha, coluna (uint32_t): posição do erro em linhas e colunas,
+preenchidas apenas na fronteira da biblioteca (checar IndiceLinhas).
+*/
+struct ErroCompilacao {
+    std::string mensagem;
+    uint32_t offset = 0;
+    uint32_t linha = 0;
+    uint32_t coluna = 0;
+};
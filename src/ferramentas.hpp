@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+#include <unistd.h>
+
+/*
+Utilitários comuns às ferramentas que montam e executam os
+programas gerados (compiler_tests e bench_codigo).
+*/
+namespace mlc {
+    inline constexpr int CODIGO_PULADO = 77; // "teste pulado" para o ctest (SKIP_RETURN_CODE)
+
+    /*
+    Verifica se 'programa' é um executável em algum diretório do PATH.
+    PARÂMETROS:
+    - programa (const char*): nome do executável (ex.: "nasm").
+    RETURNS:
+    - (bool): true se ele foi encontrado.
+    */
+    inline bool no_path(const char* programa) {
+        const char* path = std::getenv("PATH");
+        std::istringstream diretorios (path != nullptr ? path : "");
+        std::string diretorio;
+        while (std::getline(diretorios, diretorio, ':')) {
+            std::string candidato = (diretorio.empty() ? "." : diretorio) + "/" + programa;
+            if (access(candidato.c_str(), X_OK) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
@@ -0,0 +1,328 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "./fila_es.hpp"
+#include "./trace.hpp"
+
+
+namespace mlc {
+    /*
+    Maior transferência pedida numa única operação; arquivos
+    maiores são lidos ou escritos em várias partes.
+    */
+    static constexpr size_t MAXIMO_POR_OPERACAO = size_t(1) << 30;
+
+    static std::string descrever_erro(const char* acao, int codigo) {
+        return std::string(acao) + ": " + strerror(codigo);
+    }
+
+    FilaES::FilaES(unsigned entradas, bool io_uring) {
+        if (io_uring) {
+            abrir_anel(entradas);
+        }
+    }
+
+    FilaES::~FilaES() {
+        // o kernel ainda pode escrever nos buffers das operações em voo
+        while (m_em_voo > 0) {
+            colher(1);
+        }
+        for (Operacao& op : m_ops) {
+            if (op.fd >= 0) {
+                close(op.fd);
+            }
+        }
+        fechar_anel();
+    }
+
+    bool FilaES::usa_io_uring() const {
+        return m_anel.fd >= 0;
+    }
+
+    /*
+    Cria o io_uring e mapeia os seus anéis. Em caso de falha, a
+    fila continua com m_anel.fd = -1 e usa pread/pwrite.
+    */
+    void FilaES::abrir_anel(unsigned entradas) {
+        io_uring_params params {};
+        int fd = static_cast<int>(syscall(__NR_io_uring_setup, entradas, &params));
+        if (fd < 0) {
+            return;
+        }
+        m_anel.fd = fd;
+        // IORING_OP_READ e IORING_OP_WRITE chegaram no Linux 5.6, junto com IORING_FEAT_RW_CUR_POS
+        if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+            fechar_anel();
+            return;
+        }
+        m_anel.entradas = params.sq_entries;
+        m_anel.tamanho_sq = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        m_anel.tamanho_cq = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool mapa_unico = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (mapa_unico) {
+            m_anel.tamanho_sq = std::max(m_anel.tamanho_sq, m_anel.tamanho_cq);
+        }
+        m_anel.mapa_sq = mmap(nullptr, m_anel.tamanho_sq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (m_anel.mapa_sq == MAP_FAILED) {
+            m_anel.mapa_sq = nullptr;
+            fechar_anel();
+            return;
+        }
+        if (mapa_unico) {
+            m_anel.mapa_cq = m_anel.mapa_sq;
+        } else {
+            m_anel.mapa_cq = mmap(nullptr, m_anel.tamanho_cq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        }
+        m_anel.tamanho_sqes = params.sq_entries * sizeof(io_uring_sqe);
+        m_anel.sqes = mmap(nullptr, m_anel.tamanho_sqes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (m_anel.mapa_cq == MAP_FAILED || m_anel.sqes == MAP_FAILED) {
+            m_anel.mapa_cq = m_anel.mapa_cq == MAP_FAILED ? nullptr : m_anel.mapa_cq;
+            m_anel.sqes = m_anel.sqes == MAP_FAILED ? nullptr : m_anel.sqes;
+            fechar_anel();
+            return;
+        }
+        char* sq = static_cast<char*>(m_anel.mapa_sq);
+        char* cq = static_cast<char*>(m_anel.mapa_cq);
+        m_anel.sq_cabeca = reinterpret_cast<uint32_t*>(sq + params.sq_off.head);
+        m_anel.sq_cauda = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+        m_anel.sq_mascara = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+        m_anel.sq_indices = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+        m_anel.cq_cabeca = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+        m_anel.cq_cauda = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+        m_anel.cq_mascara = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+        m_anel.cqes = cq + params.cq_off.cqes;
+    }
+
+    void FilaES::fechar_anel() {
+        if (m_anel.sqes != nullptr) {
+            munmap(m_anel.sqes, m_anel.tamanho_sqes);
+        }
+        if (m_anel.mapa_cq != nullptr && m_anel.mapa_cq != m_anel.mapa_sq) {
+            munmap(m_anel.mapa_cq, m_anel.tamanho_cq);
+        }
+        if (m_anel.mapa_sq != nullptr) {
+            munmap(m_anel.mapa_sq, m_anel.tamanho_sq);
+        }
+        if (m_anel.fd >= 0) {
+            close(m_anel.fd);
+        }
+        m_anel = Anel {};
+    }
+
+    size_t FilaES::ler(const std::string& caminho) {
+        size_t id = m_ops.size();
+        Operacao& op = m_ops.emplace_back(Operacao {.escrita = false, .dados = {}, .erro = std::nullopt});
+        op.fd = open(caminho.c_str(), O_RDONLY | O_CLOEXEC);
+        if (op.fd < 0) {
+            concluir(op, descrever_erro("Não foi possível abrir o arquivo", errno));
+            return id;
+        }
+        struct stat info;
+        if (fstat(op.fd, &info) < 0) {
+            concluir(op, descrever_erro("Não foi possível ler o arquivo", errno));
+            return id;
+        }
+        op.dados.resize(static_cast<size_t>(info.st_size));
+        if (op.dados.empty()) {
+            concluir(op);
+            return id;
+        }
+        m_agendadas.push_back(id);
+        return id;
+    }
+
+    size_t FilaES::escrever(const std::string& caminho, std::string conteudo) {
+        size_t id = m_ops.size();
+        Operacao& op = m_ops.emplace_back(Operacao {.escrita = true, .dados = std::move(conteudo), .erro = std::nullopt});
+        op.fd = open(caminho.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (op.fd < 0) {
+            concluir(op, descrever_erro("Não foi possível criar o arquivo", errno));
+            return id;
+        }
+        if (op.dados.empty()) {
+            concluir(op);
+            return id;
+        }
+        m_agendadas.push_back(id);
+        return id;
+    }
+
+    /*
+    Preenche uma SQE por operação agendada e as submete com um único
+    io_uring_enter. O número de operações em voo nunca passa do
+    tamanho da SQ, de modo que a CQ (com o dobro de entradas) não
+    transborda. Se o kernel consumir só parte do lote, o restante é
+    submetido de novo; se ele parar de consumir, as SQEs que sobraram
+    são retiradas da SQ e as suas operações feitas com pread/pwrite.
+    */
+    void FilaES::enviar() {
+        MLC_TRACE_SCOPE("fila_es_enviar");
+        if (!usa_io_uring()) {
+            for (size_t id : m_agendadas) {
+                executar_sincrono(m_ops[id]);
+            }
+            m_agendadas.clear();
+            return;
+        }
+        std::vector<size_t> agendadas = std::move(m_agendadas);
+        m_agendadas.clear();
+        size_t k = 0;
+        while (k < agendadas.size()) {
+            if (m_em_voo >= m_anel.entradas) {
+                colher(1);
+                continue;
+            }
+            uint32_t cauda = *m_anel.sq_cauda;
+            unsigned lote = 0;
+            while (k < agendadas.size() && m_em_voo + lote < m_anel.entradas) {
+                Operacao& op = m_ops[agendadas[k]];
+                uint32_t indice = cauda & m_anel.sq_mascara;
+                io_uring_sqe* sqe = static_cast<io_uring_sqe*>(m_anel.sqes) + indice;
+                std::memset(sqe, 0, sizeof(io_uring_sqe));
+                sqe->opcode = op.escrita ? IORING_OP_WRITE : IORING_OP_READ;
+                sqe->fd = op.fd;
+                sqe->off = op.feitos;
+                sqe->addr = reinterpret_cast<uint64_t>(op.dados.data() + op.feitos);
+                sqe->len = static_cast<uint32_t>(std::min(op.dados.size() - op.feitos, MAXIMO_POR_OPERACAO));
+                sqe->user_data = agendadas[k];
+                m_anel.sq_indices[indice] = indice;
+                cauda++;
+                lote++;
+                k++;
+            }
+            std::atomic_ref<uint32_t>(*m_anel.sq_cauda).store(cauda, std::memory_order_release);
+            unsigned enviadas = 0;
+            while (enviadas < lote) {
+                long consumidas = syscall(__NR_io_uring_enter, m_anel.fd, lote - enviadas, 0, 0, nullptr, 0);
+                if (consumidas < 0) {
+                    if (errno == EBUSY || errno == EAGAIN) {
+                        colher(0);
+                    } else if (errno != EINTR) {
+                        throw std::system_error(errno, std::generic_category(), "io_uring_enter");
+                    }
+                    continue;
+                }
+                if (consumidas == 0) {
+                    break;
+                }
+                enviadas += static_cast<unsigned>(consumidas);
+                m_em_voo += static_cast<size_t>(consumidas);
+            }
+            if (enviadas < lote) {
+                // sem SQPOLL, só o io_uring_enter consome a SQ: as SQEs que sobraram podem ser retiradas
+                unsigned restantes = lote - enviadas;
+                std::atomic_ref<uint32_t>(*m_anel.sq_cauda).store(cauda - restantes, std::memory_order_release);
+                for (size_t j = k - restantes; j < k; j++) {
+                    executar_sincrono(m_ops[agendadas[j]]);
+                }
+            }
+        }
+    }
+
+    /*
+    Processa as respostas (CQEs) disponíveis, esperando antes por
+    pelo menos 'minimo' delas. Transferências parciais voltam para
+    a lista de agendadas com o restante.
+    */
+    void FilaES::colher(unsigned minimo) {
+        std::atomic_ref<uint32_t> cq_cauda (*m_anel.cq_cauda);
+        uint32_t cabeca = *m_anel.cq_cabeca;
+        if (minimo > 0 && cabeca == cq_cauda.load(std::memory_order_acquire)) {
+            while (syscall(__NR_io_uring_enter, m_anel.fd, 0, minimo, IORING_ENTER_GETEVENTS, nullptr, 0) < 0) {
+                if (errno != EINTR) {
+                    throw std::system_error(errno, std::generic_category(), "io_uring_enter");
+                }
+            }
+        }
+        uint32_t cauda = cq_cauda.load(std::memory_order_acquire);
+        for (; cabeca != cauda; cabeca++) {
+            const io_uring_cqe& cqe = static_cast<const io_uring_cqe*>(m_anel.cqes)[cabeca & m_anel.cq_mascara];
+            size_t id = static_cast<size_t>(cqe.user_data);
+            Operacao& op = m_ops[id];
+            m_em_voo--;
+            if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+                m_agendadas.push_back(id);
+            } else if (cqe.res < 0) {
+                concluir(op, descrever_erro(op.escrita ? "Falha ao escrever" : "Falha ao ler", -cqe.res));
+            } else if (cqe.res == 0) {
+                // o arquivo diminuiu depois do fstat: fica com o que foi lido
+                op.dados.resize(op.feitos);
+                concluir(op, op.escrita ? std::optional<std::string>("Falha ao escrever: nenhum byte escrito") : std::nullopt);
+            } else {
+                op.feitos += static_cast<size_t>(cqe.res);
+                if (op.feitos < op.dados.size()) {
+                    m_agendadas.push_back(id);
+                } else {
+                    concluir(op);
+                }
+            }
+        }
+        std::atomic_ref<uint32_t>(*m_anel.cq_cabeca).store(cabeca, std::memory_order_release);
+    }
+
+    /*
+    Fallback sem io_uring: transfere o arquivo inteiro com pread/pwrite.
+    */
+    void FilaES::executar_sincrono(Operacao& op) {
+        while (op.feitos < op.dados.size()) {
+            size_t tamanho = std::min(op.dados.size() - op.feitos, MAXIMO_POR_OPERACAO);
+            ssize_t feitos = op.escrita
+                ? pwrite(op.fd, op.dados.data() + op.feitos, tamanho, static_cast<off_t>(op.feitos))
+                : pread(op.fd, op.dados.data() + op.feitos, tamanho, static_cast<off_t>(op.feitos));
+            if (feitos < 0 && errno == EINTR) {
+                continue;
+            }
+            if (feitos < 0) {
+                concluir(op, descrever_erro(op.escrita ? "Falha ao escrever" : "Falha ao ler", errno));
+                return;
+            }
+            if (feitos == 0 && op.escrita) {
+                concluir(op, "Falha ao escrever: nenhum byte escrito");
+                return;
+            }
+            if (feitos == 0) {
+                op.dados.resize(op.feitos);
+                break;
+            }
+            op.feitos += static_cast<size_t>(feitos);
+        }
+        concluir(op);
+    }
+
+    void FilaES::concluir(Operacao& op, std::optional<std::string> erro) {
+        if (op.fd >= 0) {
+            close(op.fd);
+            op.fd = -1;
+        }
+        op.concluida = true;
+        op.erro = std::move(erro);
+    }
+
+    ResultadoES FilaES::esperar(size_t id) {
+        MLC_TRACE_SCOPE("fila_es_esperar");
+        Operacao& op = m_ops[id];
+        while (!op.concluida) {
+            if (!m_agendadas.empty()) {
+                enviar();
+            } else {
+                colher(1);
+            }
+        }
+        ResultadoES resultado {.conteudo = {}, .erro = std::move(op.erro)};
+        if (!op.escrita) {
+            resultado.conteudo = std::move(op.dados);
+        }
+        op.dados = std::string();
+        return resultado;
+    }
+}
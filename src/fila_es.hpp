@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <vector>
+
+/*
+Fila de leituras e escritas de arquivos inteiros, usada pelo
+compilador quando recebe vários arquivos de uma vez. As operações
+são agendadas (ler/escrever) e entregues ao kernel em lote com
+enviar(): com io_uring, um único io_uring_enter submete o lote
+inteiro e o processo segue compilando enquanto o disco trabalha;
+esperar() só bloqueia se a operação pedida ainda não terminou.
+Quando o io_uring não está disponível (kernel anterior ao 5.6,
+ou bloqueado por seccomp em containers), enviar() faz as mesmas
+operações com pread/pwrite, de forma síncrona.
+*/
+namespace mlc {
+    struct ResultadoES {
+        std::string conteudo; // arquivo lido (vazio nas escritas)
+        std::optional<std::string> erro;
+    };
+
+    class FilaES {
+        public:
+            /*
+            PARÂMETROS:
+            - entradas (unsigned): tamanho da SQ do io_uring, ou seja, o
+            máximo de operações em voo ao mesmo tempo.
+            - io_uring (bool): com false, a fila usa pread/pwrite mesmo
+            quando o io_uring está disponível (usado pelos testes).
+            */
+            explicit FilaES(unsigned entradas = 64, bool io_uring = true);
+            ~FilaES();
+
+            /*
+            Agenda a leitura do arquivo 'caminho' inteiro e retorna
+            o identificador da operação.
+            */
+            size_t ler(const std::string& caminho);
+
+            /*
+            Agenda a escrita de 'conteudo' no arquivo 'caminho', que
+            é criado ou truncado, e retorna o identificador da operação.
+            */
+            size_t escrever(const std::string& caminho, std::string conteudo);
+
+            /*
+            Entrega ao kernel, em um lote, as operações agendadas
+            desde a última chamada.
+            */
+            void enviar();
+
+            /*
+            Espera a operação 'id' terminar e devolve o seu resultado.
+            Cada operação só pode ser esperada uma vez.
+            */
+            ResultadoES esperar(size_t id);
+
+            /*
+            Indica se a fila usa io_uring (ou o fallback com pread/pwrite).
+            */
+            bool usa_io_uring() const;
+
+            FilaES(const FilaES&) = delete;
+            FilaES& operator=(const FilaES&) = delete;
+
+        private:
+            struct Operacao {
+                bool escrita;
+                int fd = -1;
+                std::string dados; // destino da leitura ou origem da escrita
+                size_t feitos = 0; // bytes já transferidos
+                bool concluida = false;
+                std::optional<std::string> erro;
+            };
+
+            /*
+            Anéis do io_uring mapeados em memória (checar io_uring_setup(2)).
+            */
+            struct Anel {
+                int fd = -1;
+                unsigned entradas = 0;
+                uint32_t* sq_cabeca = nullptr;
+                uint32_t* sq_cauda = nullptr;
+                uint32_t sq_mascara = 0;
+                uint32_t* sq_indices = nullptr;
+                void* sqes = nullptr;
+                uint32_t* cq_cabeca = nullptr;
+                uint32_t* cq_cauda = nullptr;
+                uint32_t cq_mascara = 0;
+                void* cqes = nullptr;
+                void* mapa_sq = nullptr;
+                size_t tamanho_sq = 0;
+                void* mapa_cq = nullptr;
+                size_t tamanho_cq = 0;
+                size_t tamanho_sqes = 0;
+            };
+
+            std::deque<Operacao> m_ops; // indexadas pelo identificador; deque mantém os buffers no lugar
+            std::vector<size_t> m_agendadas; // ainda não entregues ao kernel
+            size_t m_em_voo = 0; // entregues e ainda sem resposta
+            Anel m_anel;
+
+            void abrir_anel(unsigned entradas);
+            void fechar_anel();
+            void concluir(Operacao& op, std::optional<std::string> erro = {});
+            void executar_sincrono(Operacao& op);
+            void colher(unsigned minimo);
+    };
+}
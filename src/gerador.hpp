@@ -4,209 +4,1647 @@
 #include <string>
 #include <sstream>
 #include <map>
+#include <set>
+#include <unordered_map>
+#include <functional>
+#include <string_view>
+#include <limits>
+#include <algorithm>
+#include <bit>
+#include <optional>
 #include <assert.h>
 
 #include "parser.hpp"
+#include "perfil.hpp"
+#include "selecao.hpp"
+#include "trace.hpp"
 
 
+/*
+Variável na stack. Um array ocupa 'tamanho' posições a partir de
+'stack_pos', com o elemento 0 no menor endereço; para variáveis
+comuns, 'tamanho' é 0 e a variável ocupa uma única posição.
+*/
 struct Variable {
     size_t stack_pos;
+    size_t tamanho = 0;
+};
+
+/*
+Destino opcional para o código assembly gerado. Quando presente,
+o Generator entrega o código em pedaços (chunks) à medida que os
+produz, em vez de acumular o programa inteiro em memória.
+*/
+using SaidaAsm = std::function<void(std::string_view)>;
+
+/*
+Uso do perfil de execução na geração de código (checar perfil.hpp).
+- arquivo_saida (std::string): se não vazio, o programa é instrumentado
+e grava os seus contadores nesse arquivo ao terminar.
+- hash_fonte (uint64_t): hash do código fonte, gravado com os contadores.
+- perfil (const mlc::Perfil*): contadores de uma execução anterior do
+mesmo código, ou nulo.
+*/
+struct OpcoesPerfil {
+    std::string arquivo_saida;
+    uint64_t hash_fonte = 0;
+    const mlc::Perfil* perfil = nullptr;
 };
 
 
 class Generator {
     public:
-        inline Generator(node::Program program) 
-            : m_program(std::move(program))
+        inline Generator(node::Program program, SaidaAsm saida = {}, bool avx2 = false, OpcoesPerfil perfil = {})
+            : m_program(std::move(program)), m_saida(std::move(saida)), m_avx2(avx2), m_perfil(std::move(perfil))
         {}
 
         /*
-        Método responsável por escrever o código em assembly
-        referente aos nós de termos. Assim, implementa um visitor
-        pattern para checar qual tipo de termo está lidando com,
-        e, assim, adaptar a geração de código.
+        Método que gera o código de uma expressão deixando o seu
+        valor no topo da stack. Literais de 32 bits e variáveis vão
+        direto para a stack com 'push'; as demais expressões são
+        calculadas em rax (checar generate_valor).
+        PARÂMETROS:
+        - expr (const node::Expr*): ponteiro para o nó da AST
+        que servirá de base para a geração de código
+        RETURNS:
+        */
+        inline void generate_expr(const node::Expr* expr) {
+            if (std::optional<std::string> operando = operando_folha(Seletor::desembrulhar(expr))) {
+                push(operando.value());
+                return;
+            }
+            generate_valor(expr);
+            push("rax");
+        }
+
+        /*
+        Método que gera o código de uma expressão deixando o seu
+        valor no registrador 'reg'. Folhas são carregadas direto nele.
+        PARÂMETROS:
+        - expr (const node::Expr*): nó da expressão.
+        - reg (const std::string&): registrador de destino.
+        RETURNS:
+        */
+        inline void generate_valor_em(const node::Expr* expr, const std::string& reg) {
+            if (std::optional<std::string> operando = operando_folha(Seletor::desembrulhar(expr))) {
+                m_out << "    mov " << reg << ", " << operando.value() << '\n';
+                return;
+            }
+            generate_valor(expr);
+            m_out << "    mov " << reg << ", rax\n";
+        }
+
+        /*
+        Método responsável pela geração de código assembly dos
+        nós de expressões, com seleção de instruções por BURS
+        (checar selecao.hpp): a árvore é rotulada pelo Seletor e
+        depois reduzida de cima para baixo, aplicando em cada nó a
+        regra de menor custo para o não-terminal pedido. A redução
+        usa uma pilha de trabalho explícita (m_pilha_selecao), e não
+        recursão, de modo que expressões profundamente aninhadas não
+        estouram a stack nativa. Ao final, o valor está em rax (ou,
+        com 'destino' igual a cond, nas flags de um 'cmp', com a
+        comparação feita em m_condicao).
+        PARÂMETROS:
+        - expr (const node::Expr*): ponteiro para o nó da AST
+        que servirá de base para a geração de código.
+        - destino (burs::NaoTerminal): reg ou cond.
+        RETURNS:
+        */
+        inline void generate_valor(const node::Expr* expr, burs::NaoTerminal destino = burs::NaoTerminal::reg) {
+            MLC_TRACE_SCOPE("generate_expr");
+            m_profundidade_selecao++;
+            m_seletor.rotular(expr);
+            size_t base = m_pilha_selecao.size();
+            m_pilha_selecao.push_back({.expr = Seletor::desembrulhar(expr), .destino = destino});
+            while (m_pilha_selecao.size() > base) {
+                MLC_TRACE_SCOPE("visit_expr");
+                TarefaSelecao tarefa = m_pilha_selecao.back();
+                m_pilha_selecao.pop_back();
+                if (tarefa.expr == nullptr) {
+                    push("rax");
+                } else {
+                    reduzir(tarefa);
+                }
+            }
+            // os rótulos só são descartados na expressão mais externa (chamadas expandidas geram expressões aninhadas)
+            if (--m_profundidade_selecao == 0) {
+                m_seletor.limpar();
+            }
+        }
+
+        /*
+        Método que escreve a instrução de uma operação binária entre
+        rax e um operando imediato ou de memória. Com 'invertido', o
+        operando é o lado esquerdo da expressão e rax o direito.
+        PARÂMETROS:
+        - tipo (TipoToken): operador.
+        - operando (const std::string&): imediato ou 'QWORD [rsp + N]'.
+        - imediato (bool): se o operando é um imediato.
+        - invertido (bool): se o operando é o lado esquerdo.
+        RETURNS:
+        */
+        inline void emitir_op(TipoToken tipo, const std::string& operando, bool imediato, bool invertido) {
+            switch (tipo) {
+                case TipoToken::mais:
+                    m_out << "    add rax, " << operando << '\n';
+                    break;
+                case TipoToken::menos:
+                    if (invertido) {
+                        m_out << "    neg rax\n";
+                        m_out << "    add rax, " << operando << '\n';
+                    } else {
+                        m_out << "    sub rax, " << operando << '\n';
+                    }
+                    break;
+                case TipoToken::asterisco:
+                    m_out << (imediato ? "    imul rax, rax, " : "    imul rax, ") << operando << '\n';
+                    break;
+                case TipoToken::barra_div:
+                    if (invertido) {
+                        m_out << "    mov rcx, rax\n";
+                        m_out << "    mov rax, " << operando << '\n';
+                        m_out << "    cqo\n";
+                        m_out << "    idiv rcx\n";
+                    } else if (imediato) {
+                        m_out << "    mov rcx, " << operando << '\n';
+                        m_out << "    cqo\n";
+                        m_out << "    idiv rcx\n";
+                    } else {
+                        m_out << "    cqo\n";
+                        m_out << "    idiv " << operando << '\n';
+                    }
+                    break;
+                default: // comparações
+                    m_out << "    cmp rax, " << operando << '\n';
+                    m_condicao = invertido ? espelhar_comparacao(tipo) : tipo;
+                    break;
+            }
+        }
+
+        /*
+        Método que escreve a instrução de uma operação binária com o
+        lado esquerdo no topo da stack e o direito em rax.
+        PARÂMETROS:
+        - tipo (TipoToken): operador.
+        RETURNS:
+        */
+        inline void emitir_op_reg(TipoToken tipo) {
+            switch (tipo) {
+                case TipoToken::mais:
+                    pop("rcx");
+                    m_out << "    add rax, rcx\n";
+                    break;
+                case TipoToken::asterisco:
+                    pop("rcx");
+                    m_out << "    imul rax, rcx\n";
+                    break;
+                case TipoToken::menos:
+                    m_out << "    mov rcx, rax\n";
+                    pop("rax");
+                    m_out << "    sub rax, rcx\n";
+                    break;
+                case TipoToken::barra_div:
+                    m_out << "    mov rcx, rax\n";
+                    pop("rax");
+                    m_out << "    cqo\n";
+                    m_out << "    idiv rcx\n";
+                    break;
+                default: // comparações
+                    pop("rcx");
+                    m_out << "    cmp rcx, rax\n";
+                    m_condicao = tipo;
+                    break;
+            }
+        }
+
+        /*
+        Método que monta o operando de uma folha da expressão:
+        literais que cabem em 32 bits viram imediatos e variáveis
+        viram operandos de memória.
+        PARÂMETROS:
+        - expr (const node::Expr*): nó da expressão (sem parênteses).
+        RETURNS:
+        - (std::optional<std::string>): operando, ou vazio caso a
+        expressão não seja uma folha.
+        */
+        inline std::optional<std::string> operando_folha(const node::Expr* expr) const {
+            const node::Term* term = std::get_if<node::Term>(&expr->variant_expr);
+            if (term == nullptr) {
+                return {};
+            }
+            if (auto term_int_lit = std::get_if<node::TermIntLit>(&term->variant_term)) {
+                if (Seletor::cabe_32(term_int_lit->token_int.valor_int)) {
+                    return std::to_string(term_int_lit->token_int.valor_int);
+                }
+            } else if (auto term_identif = std::get_if<node::TermIdentif>(&term->variant_term)) {
+                /*
+                A stack é organizada para que cada elemento tenha um tamanho de 8 bytes. Assim, usamos o operador
+                QWORD para especificar que vamos acessar um local na memória de 8 bytes de tamanho (checar endereco_var).
+                */
+                return endereco_var(buscar_escalar(term_identif->token_identif));
+            }
+            return {};
+        }
+
+        /*
+        Método que gera o código de uma condição (ex.: do 'if'),
+        saltando para 'label' quando ela é falsa (ou, com
+        'se_verdadeira', quando ela é verdadeira). Qualquer
+        valor diferente de 0 é verdadeiro. Quando a condição é
+        uma comparação, o resultado não é materializado: o 'cmp'
+        (não-terminal cond) é seguido diretamente pelo salto
+        condicional.
+        PARÂMETROS:
+        - expr (const node::Expr*): nó da condição.
+        - label (const std::string&): label de destino do salto.
+        - se_verdadeira (bool): se verdadeiro, salta quando a
+        condição é verdadeira (usado no fim dos loops).
+        RETURNS:
+        */
+        inline void generate_condicao(const node::Expr* expr, const std::string& label, bool se_verdadeira = false) {
+            if (auto bin_expr = std::get_if<node::BinExpr>(&Seletor::desembrulhar(expr)->variant_expr)) {
+                if (eh_comparacao(bin_expr->token.tipo)) {
+                    generate_valor(expr, burs::NaoTerminal::cond);
+                    m_out << "    j" << sufixo_cond(se_verdadeira ? m_condicao : inverter_comparacao(m_condicao)) << ' ' << label << '\n';
+                    return;
+                }
+            }
+            generate_valor(expr);
+            m_out << "    test rax, rax\n";
+            m_out << (se_verdadeira ? "    jnz " : "    jz ") << label << '\n';
+        }
+
+        /*
+        Método que gera um 'if'. Sem perfil, a condição falsa salta
+        por cima do corpo, que fica no caminho sem saltos. Com perfil:
+        - corpos executados em menos de 1/FRACAO_FRIA das vezes vão
+        para fora da linha (m_frio, escrito no fim do programa), e o
+        caminho quente passa a ser o que não entra no 'if';
+        - um corpo que é só uma atribuição simples, com a condição
+        imprevisível (verdadeira entre 1/5 e 4/5 das vezes), vira um
+        'cmov' sem saltos (checar generate_if_cmov).
+        PARÂMETROS:
+        - statmt_if (const node::StatmtIf*): nó do 'if'.
+        RETURNS:
+        */
+        inline void generate_if(const node::StatmtIf* statmt_if) {
+            contar(statmt_if->contador);
+            std::optional<uint64_t> execucoes_if = execucoes(statmt_if->contador);
+            if (execucoes_if.has_value() && execucoes_if.value() > 0) {
+                uint64_t execucoes_corpo = execucoes(statmt_if->scope->contador).value();
+                const node::ReassVar* atribuicao = atribuicao_cmov(statmt_if->scope);
+                if (atribuicao != nullptr && m_perfil.arquivo_saida.empty()
+                    && 5 * execucoes_corpo >= execucoes_if.value() && 5 * execucoes_corpo <= 4 * execucoes_if.value()) {
+                    generate_if_cmov(statmt_if->expr, atribuicao);
+                    return;
+                }
+                if (!m_em_codigo_frio && execucoes_corpo * FRACAO_FRIA < execucoes_if.value()) {
+                    std::string label_frio = create_label();
+                    std::string label_volta = create_label();
+                    generate_condicao(statmt_if->expr, label_frio, true);
+                    m_out << label_volta << ":\n";
+                    std::swap(m_out, m_frio);
+                    m_em_codigo_frio = true;
+                    m_out << label_frio << ":\n";
+                    m_pilha_statmt.push_back({.tipo = TarefaStatmt::fechar_frio, .statmt = nullptr, .label = label_volta});
+                    agendar_scope(statmt_if->scope);
+                    return;
+                }
+            }
+            std::string label = create_label();
+            generate_condicao(statmt_if->expr, label);
+            m_pilha_statmt.push_back({.tipo = TarefaStatmt::escrever_label, .statmt = nullptr, .label = label});
+            agendar_scope(statmt_if->scope);
+        }
+
+        /*
+        Método que gera 'if (cond) { x = e; }' sem saltos: 'e' é
+        calculado antes da condição (atribuicao_cmov garante que
+        isso não tem efeitos), e o 'cmov' escolhe entre o valor
+        novo e o atual de 'x'.
+        PARÂMETROS:
+        - condicao (const node::Expr*): condição do 'if'.
+        - atribuicao (const node::ReassVar*): único statement do corpo.
+        RETURNS:
+        */
+        inline void generate_if_cmov(const node::Expr* condicao, const node::ReassVar* atribuicao) {
+            const Variable& var = buscar_escalar(atribuicao->token_identif);
+            generate_expr(atribuicao->expr);
+            const char* sufixo = "nz";
+            if (auto bin_expr = std::get_if<node::BinExpr>(&Seletor::desembrulhar(condicao)->variant_expr); bin_expr != nullptr && eh_comparacao(bin_expr->token.tipo)) {
+                generate_valor(condicao, burs::NaoTerminal::cond);
+                sufixo = sufixo_cond(m_condicao);
+            } else {
+                generate_valor(condicao);
+                m_out << "    test rax, rax\n";
+            }
+            pop("rcx"); // 'pop' e 'mov' não alteram as flags da condição
+            m_out << "    mov rax, " << endereco_var(var) << '\n';
+            m_out << "    cmov" << sufixo << " rax, rcx\n";
+            m_out << "    mov " << endereco_var(var) << ", rax\n";
+        }
+
+        /*
+        Método responsável por lidar com escopos na geração de
+        código assembly. Assim, inicia e finaliza um escopo,
+        enquanto, no processo, chama a geração de código para
+        os statement encontrados no interior do escopo em questão.
+        PARÂMETROS:
+        - scope (const node::Scope*): ponteiro para o nó da AST
+        referente ao escopo que está interpretando.
+        RETURNS:
+        */
+        inline void generate_scope(const node::Scope* scope) {
+            size_t base = m_pilha_statmt.size();
+            agendar_scope(scope);
+            executar_statmts(base);
+        }
+
+        /*
+        Método que gera o código assembly para os diferentes tipos
+        de statements possíveis (checar grammar.md). Escopos
+        aninhados não são gerados recursivamente: seus statements
+        são empilhados na pilha de trabalho m_pilha_statmt, junto
+        com uma tarefa que fecha o escopo ao final.
+        PARÂMETROS:
+        - statmt (const node::Statmt*): ponteiro para o nó da AST
+        que servirá de base para a geração de código.
+        RETURNS:
+        */
+        inline void generate_statmt(const node::Statmt* statmt) {
+            size_t base = m_pilha_statmt.size();
+            m_pilha_statmt.push_back({.tipo = TarefaStatmt::gerar_statmt, .statmt = statmt, .label = {}});
+            executar_statmts(base);
+        }
+
+        /*
+        Método que gera a atribuição a uma variável. Atribuições da
+        forma 'x = x + e' e 'x = x - e' operam direto sobre a memória
+        da variável ('add QWORD [rsp + N], e'), e literais são escritos
+        sem passar por um registrador. Nos demais casos, o valor é
+        calculado em rax e copiado para a variável. O endereço é
+        montado depois do cálculo, já que o rsp pode mudar durante ele.
+        PARÂMETROS:
+        - reass_var (const node::ReassVar*): nó da atribuição.
+        RETURNS:
+        */
+        inline void generate_atribuicao(const node::ReassVar* reass_var) {
+            const Variable& var = buscar_escalar(reass_var->token_identif);
+            const node::Expr* expr = Seletor::desembrulhar(reass_var->expr);
+            if (Seletor::valor_literal(expr).has_value() && operando_folha(expr).has_value()) {
+                m_out << "    mov " << endereco_var(var) << ", " << operando_folha(expr).value() << '\n';
+                return;
+            }
+            auto eh_var = [&reass_var](const node::Expr* lado) {
+                auto term = std::get_if<node::Term>(&lado->variant_expr);
+                auto term_identif = term != nullptr ? std::get_if<node::TermIdentif>(&term->variant_term) : nullptr;
+                return term_identif != nullptr && term_identif->token_identif.valor == reass_var->token_identif.valor;
+            };
+            if (auto bin_expr = std::get_if<node::BinExpr>(&expr->variant_expr)) {
+                TipoToken tipo = bin_expr->token.tipo;
+                const node::Expr* esq = Seletor::desembrulhar(bin_expr->lado_esquerdo);
+                const node::Expr* dir = Seletor::desembrulhar(bin_expr->lado_direito);
+                const node::Expr* outro = nullptr;
+                if ((tipo == TipoToken::mais || tipo == TipoToken::menos) && eh_var(esq)) {
+                    outro = dir;
+                } else if (tipo == TipoToken::mais && eh_var(dir)) {
+                    outro = esq;
+                }
+                if (outro != nullptr) {
+                    std::string instrucao = tipo == TipoToken::mais ? "add" : "sub";
+                    if (Seletor::valor_literal(outro).has_value() && operando_folha(outro).has_value()) {
+                        m_out << "    " << instrucao << ' ' << endereco_var(var) << ", " << operando_folha(outro).value() << '\n';
+                        return;
+                    }
+                    generate_valor(outro);
+                    m_out << "    " << instrucao << ' ' << endereco_var(var) << ", rax\n";
+                    return;
+                }
+            }
+            generate_valor(expr);
+            m_out << "    mov " << endereco_var(var) << ", rax\n";
+        }
+
+        /*
+        Método que gera a leitura de um elemento de array, supondo
+        que o índice já está em rax. O elemento lido substitui o
+        índice em rax.
+        PARÂMETROS:
+        - term_index (const node::TermIndex*): nó da leitura.
+        RETURNS:
+        */
+        inline void generate_leitura(const node::TermIndex* term_index) {
+            const Variable& var = buscar_array(term_index->token_identif);
+            if (term_index->checar) {
+                generate_checagem(var, "rax");
+            }
+            m_out << "    mov rax, QWORD " << endereco_elemento(var, "rax") << '\n';
+        }
+
+        /*
+        Método que gera a verificação de limites de um índice em
+        tempo de execução. Uma única comparação sem sinal cobre
+        os dois lados, já que um índice negativo vira um número
+        sem sinal maior que qualquer tamanho. Fora dos limites, o
+        programa salta para a rotina de erro (checar
+        generate_erro_limites).
+        PARÂMETROS:
+        - var (const Variable&): array acessado.
+        - reg (const std::string&): registrador com o índice.
+        RETURNS:
+        */
+        inline void generate_checagem(const Variable& var, const std::string& reg) {
+            m_out << "    cmp " << reg << ", " << var.tamanho << '\n';
+            m_out << "    jae " << LABEL_ERRO_LIMITES << '\n';
+            m_usa_erro_limites = true;
+        }
+
+        /*
+        Método que escreve a rotina chamada quando um índice está
+        fora dos limites do array: escreve uma mensagem de erro no
+        stderr e encerra o programa com o código 1.
+        PARÂMETROS:
+        RETURNS:
+        */
+        inline void generate_erro_limites() {
+            m_out << LABEL_ERRO_LIMITES << ":\n";
+            generate_flush();
+            m_out << "    mov rax, 1\n"; // write
+            m_out << "    mov rdi, 2\n"; // stderr
+            m_out << "    lea rsi, [rel " << LABEL_ERRO_LIMITES << ".msg]\n";
+            m_out << "    mov rdx, " << MENSAGEM_ERRO_LIMITES.size() + 1 << '\n';
+            m_out << "    syscall\n";
+            m_out << "    mov rax, 60\n";
+            m_out << "    mov rdi, 1\n";
+            m_out << "    syscall\n";
+            m_out << "section .rodata\n";
+            m_out << LABEL_ERRO_LIMITES << ".msg: db \"" << MENSAGEM_ERRO_LIMITES << "\", 10\n";
+        }
+
+        /*
+        Método que escreve a chamada ao esvaziamento do buffer de
+        'print' (checar generate_runtime_print), usada antes de
+        qualquer saída do programa para que nada do que foi escrito
+        se perca. Não gera código em programas sem 'print'.
+        PARÂMETROS:
+        RETURNS:
+        */
+        inline void generate_flush() {
+            if (m_program.usa_print) {
+                m_out << "    call " << LABEL_FLUSH << '\n';
+            }
+            if (!m_perfil.arquivo_saida.empty()) {
+                m_out << "    call " << LABEL_PERFIL << '\n';
+            }
+        }
+
+        /*
+        Método que escreve o runtime dos programas instrumentados:
+        os contadores de execução (um por escopo e 'if', checar
+        node::Scope) em .bss, incrementados por 'contar', e a rotina
+        mlc_perfil, chamada junto com o esvaziamento do buffer antes de
+        cada saída do programa, que grava o cabeçalho e os contadores
+        no arquivo do perfil (formato em perfil.hpp). Preserva rdi, que
+        guarda o código de saída. Se o arquivo não puder ser aberto,
+        o perfil é descartado sem alterar o resultado do programa.
+        PARÂMETROS:
+        RETURNS:
+        */
+        inline void generate_runtime_perfil() {
+            std::string perfil = LABEL_PERFIL;
+            size_t num_contadores = m_program.num_contadores;
+            m_out << perfil << ":\n";
+            m_out << "    push rdi\n";
+            m_out << "    mov eax, 2\n"; // open
+            m_out << "    lea rdi, [rel " << perfil << ".arquivo]\n";
+            m_out << "    mov esi, 577\n"; // O_WRONLY | O_CREAT | O_TRUNC
+            m_out << "    mov edx, 420\n"; // 0644
+            m_out << "    syscall\n";
+            m_out << "    test rax, rax\n";
+            m_out << "    js " << perfil << ".fim\n";
+            m_out << "    mov rdi, rax\n";
+            m_out << "    mov eax, 1\n"; // write
+            m_out << "    lea rsi, [rel " << perfil << ".cabecalho]\n";
+            m_out << "    mov edx, 24\n";
+            m_out << "    syscall\n";
+            m_out << "    mov eax, 1\n";
+            m_out << "    lea rsi, [rel " << perfil << ".contadores]\n";
+            m_out << "    mov rdx, " << num_contadores * 8 << '\n';
+            m_out << "    syscall\n";
+            m_out << "    mov eax, 3\n"; // close
+            m_out << "    syscall\n";
+            m_out << perfil << ".fim:\n";
+            m_out << "    pop rdi\n";
+            m_out << "    ret\n";
+            m_out << "section .rodata\n";
+            m_out << "    align 8\n";
+            m_out << perfil << ".cabecalho: dq 0x" << std::hex << mlc::MAGICA_PERFIL << ", 0x" << m_perfil.hash_fonte << std::dec << ", " << num_contadores << '\n';
+            m_out << perfil << ".arquivo: db ";
+            for (char c : m_perfil.arquivo_saida) {
+                m_out << static_cast<int>(static_cast<unsigned char>(c)) << ", ";
+            }
+            m_out << "0\n";
+            m_out << "section .bss\n";
+            m_out << "    alignb 8\n";
+            m_out << perfil << ".contadores: resq " << std::max<size_t>(num_contadores, 1) << '\n';
+            m_out << "section .text\n";
+        }
+
+        /*
+        Método que escreve o runtime de 'print': um buffer estático
+        de TAMANHO_BUFFER_PRINT bytes em .bss e duas rotinas.
+        - mlc_print (valor em rdi): converte o valor para decimal de
+        trás para frente numa área temporária na stack, dois dígitos
+        por vez, com a divisão por 100 trocada por uma multiplicação
+        pelo inverso e os pares de dígitos lidos de uma tabela. O
+        texto é copiado para o buffer, que só é esvaziado quando não
+        há espaço para ele.
+        - mlc_flush: escreve o conteúdo do buffer no stdout, repetindo
+        o 'write' enquanto ele escrever apenas parte dos bytes. Preserva
+        rdi, que guarda o código de saída quando é chamada antes de um 'exit'.
+        Assim, cada 'print' custa uma syscall a cada ~64 KiB de saída,
+        e não uma por chamada. As rotinas só alteram registradores que
+        a convenção SysV permite (rax, rcx, rdx, rsi, rdi, r8-r11).
+        PARÂMETROS:
+        RETURNS:
+        */
+        inline void generate_runtime_print() {
+            std::string print = LABEL_PRINT;
+            std::string flush = LABEL_FLUSH;
+            m_out << print << ":\n";
+            m_out << "    sub rsp, " << AREA_PRINT << '\n'; // área temporária do texto
+            m_out << "    lea rsi, [rsp + " << AREA_PRINT << "]\n"; // fim do texto
+            m_out << "    mov BYTE [rsi - 1], 10\n";
+            m_out << "    dec rsi\n";
+            m_out << "    mov r8, rdi\n";
+            m_out << "    neg r8\n"; // módulo do valor (INT64_MIN continua correto como número sem sinal)
+            m_out << "    cmovs r8, rdi\n";
+            m_out << "    lea r10, [rel " << print << ".pares]\n";
+            m_out << "    mov r11, 0x28F5C28F5C28F5C3\n"; // ceil(2^66 / 25): (x >> 2) * c >> 66 = x / 100
+            m_out << print << ".par:\n";
+            m_out << "    cmp r8, 100\n";
+            m_out << "    jb " << print << ".fim_pares\n";
+            m_out << "    mov rax, r8\n";
+            m_out << "    shr rax, 2\n";
+            m_out << "    mul r11\n";
+            m_out << "    shr rdx, 2\n"; // rdx = r8 / 100
+            m_out << "    imul rax, rdx, 100\n";
+            m_out << "    sub r8, rax\n"; // r8 = r8 % 100
+            m_out << "    movzx eax, WORD [r10 + r8*2]\n";
+            m_out << "    sub rsi, 2\n";
+            m_out << "    mov WORD [rsi], ax\n";
+            m_out << "    mov r8, rdx\n";
+            m_out << "    jmp " << print << ".par\n";
+            m_out << print << ".fim_pares:\n";
+            m_out << "    cmp r8, 10\n";
+            m_out << "    jb " << print << ".unidade\n";
+            m_out << "    movzx eax, WORD [r10 + r8*2]\n";
+            m_out << "    sub rsi, 2\n";
+            m_out << "    mov WORD [rsi], ax\n";
+            m_out << "    jmp " << print << ".sinal\n";
+            m_out << print << ".unidade:\n";
+            m_out << "    add r8d, '0'\n";
+            m_out << "    dec rsi\n";
+            m_out << "    mov BYTE [rsi], r8b\n";
+            m_out << print << ".sinal:\n";
+            m_out << "    test rdi, rdi\n";
+            m_out << "    jns " << print << ".copiar\n";
+            m_out << "    dec rsi\n";
+            m_out << "    mov BYTE [rsi], '-'\n";
+            m_out << print << ".copiar:\n";
+            m_out << "    lea r9, [rsp + " << AREA_PRINT << "]\n";
+            m_out << "    sub r9, rsi\n"; // tamanho do texto
+            m_out << "    mov rax, QWORD [rel " << print << ".usado]\n";
+            m_out << "    lea rdx, [rax + r9]\n";
+            m_out << "    cmp rdx, " << TAMANHO_BUFFER_PRINT << '\n';
+            m_out << "    jbe " << print << ".cabe\n";
+            m_out << "    push rsi\n";
+            m_out << "    push r9\n";
+            m_out << "    call " << flush << '\n';
+            m_out << "    pop r9\n";
+            m_out << "    pop rsi\n";
+            m_out << "    xor eax, eax\n";
+            m_out << print << ".cabe:\n";
+            m_out << "    lea rdi, [rel " << print << ".buffer]\n";
+            m_out << "    add rdi, rax\n";
+            m_out << "    add rax, r9\n";
+            m_out << "    mov QWORD [rel " << print << ".usado], rax\n";
+            m_out << "    mov rcx, r9\n";
+            m_out << "    rep movsb\n";
+            m_out << "    add rsp, " << AREA_PRINT << '\n';
+            m_out << "    ret\n";
+            m_out << flush << ":\n";
+            m_out << "    push rdi\n"; // código de saída, no caso de um 'exit'
+            m_out << "    lea rsi, [rel " << print << ".buffer]\n";
+            m_out << "    mov rdx, QWORD [rel " << print << ".usado]\n";
+            m_out << flush << ".laco:\n";
+            m_out << "    test rdx, rdx\n";
+            m_out << "    jz " << flush << ".fim\n";
+            m_out << "    mov eax, 1\n"; // write
+            m_out << "    mov edi, 1\n"; // stdout
+            m_out << "    syscall\n";
+            m_out << "    test rax, rax\n";
+            m_out << "    jle " << flush << ".fim\n"; // erro: o restante é descartado
+            m_out << "    add rsi, rax\n";
+            m_out << "    sub rdx, rax\n";
+            m_out << "    jmp " << flush << ".laco\n";
+            m_out << flush << ".fim:\n";
+            m_out << "    mov QWORD [rel " << print << ".usado], 0\n";
+            m_out << "    pop rdi\n";
+            m_out << "    ret\n";
+            m_out << "section .rodata\n";
+            m_out << print << ".pares: db \"";
+            for (int k = 0; k < 100; k++) {
+                m_out << static_cast<char>('0' + k / 10) << static_cast<char>('0' + k % 10);
+            }
+            m_out << "\"\n";
+            m_out << "section .bss\n";
+            m_out << "    alignb 16\n";
+            m_out << print << ".usado: resq 1\n";
+            m_out << print << ".buffer: resb " << TAMANHO_BUFFER_PRINT << '\n';
+            m_out << "section .text\n";
+        }
+
+        /*
+        Método que gera a parte vetorial de um loop marcado pelo
+        Otimizador ('vetorizar'), que tem a forma:
+            while (i < limite) { a[i] = <expr>; ...; i = i + 1; }
+        onde cada expressão só usa +, -, * por potência de 2, elementos
+        'x[i]' e valores que não mudam no loop. Cada iteração vetorial
+        processa LARGURA elementos de uma vez (2 com SSE2, 4 com AVX2),
+        com o contador em rax e os valores invariantes já replicados
+        em registradores. Quando faltam menos de LARGURA elementos, ou
+        quando algum acesso ainda precisa ser verificado e sairia dos
+        limites, o loop escalar original (gerado logo em seguida)
+        termina o trabalho, inclusive reportando o erro de limites no
+        elemento certo.
+        PARÂMETROS:
+        - statmt_while (const node::StatmtWhile*): nó do loop.
+        RETURNS:
+        */
+        inline void generate_while_vetorial(const node::StatmtWhile* statmt_while) {
+            const node::BinExpr& condicao = std::get<node::BinExpr>(statmt_while->expr->variant_expr);
+            const Variable& contador = buscar_escalar(std::get<node::TermIdentif>(std::get<node::Term>(condicao.lado_esquerdo->variant_expr).variant_term).token_identif);
+            const std::vector<node::Statmt*>& corpo = statmt_while->scope->statmts_scope;
+            size_t largura = m_avx2 ? 4 : 2;
+
+            // valores invariantes (literais e variáveis), cada um replicado num registrador a partir do último
+            std::vector<std::pair<const node::Expr*, std::string>> invariantes;
+            std::vector<const node::Expr*> pilha;
+            size_t menor_checado = std::numeric_limits<size_t>::max(); // menor array com acessos ainda verificados
+            for (size_t k = 0; k + 1 < corpo.size(); k++) {
+                const node::StatmtIndex* statmt_index = std::get<node::StatmtIndex*>(corpo[k]->variant_statmt);
+                if (statmt_index->checar) {
+                    menor_checado = std::min(menor_checado, buscar_array(statmt_index->token_identif).tamanho);
+                }
+                pilha.push_back(statmt_index->expr);
+                while (!pilha.empty()) {
+                    const node::Expr* atual = pilha.back();
+                    pilha.pop_back();
+                    if (auto bin_expr = std::get_if<node::BinExpr>(&atual->variant_expr)) {
+                        int expoente;
+                        if (bin_expr->token.tipo == TipoToken::asterisco) {
+                            pilha.push_back(fator_shift(*bin_expr, expoente));
+                        } else {
+                            pilha.push_back(bin_expr->lado_esquerdo);
+                            pilha.push_back(bin_expr->lado_direito);
+                        }
+                        continue;
+                    }
+                    const node::Term& term = std::get<node::Term>(atual->variant_expr);
+                    if (auto term_paren = std::get_if<node::TermParen>(&term.variant_term)) {
+                        pilha.push_back(term_paren->expr);
+                    } else if (auto term_index = std::get_if<node::TermIndex>(&term.variant_term)) {
+                        if (term_index->checar) {
+                            menor_checado = std::min(menor_checado, buscar_array(term_index->token_identif).tamanho);
+                        }
+                    } else if (registrador_invariante(atual, invariantes).empty()) {
+                        invariantes.push_back({atual, reg_vetor(NUM_REGS_VETOR - 1 - invariantes.size())});
+                    }
+                }
+            }
+
+            std::string label_corpo = create_label();
+            std::string label_teste = create_label();
+            std::string label_fim = create_label();
+            m_out << "    mov rax, " << endereco_var(contador) << '\n';
+            if (auto limite = std::get_if<node::TermIntLit>(&std::get<node::Term>(condicao.lado_direito->variant_expr).variant_term)) {
+                m_out << "    mov rdx, " << limite->token_int.valor_int << '\n';
+            } else {
+                const node::TermIdentif& limite_var = std::get<node::TermIdentif>(std::get<node::Term>(condicao.lado_direito->variant_expr).variant_term);
+                m_out << "    mov rdx, " << endereco_var(buscar_escalar(limite_var.token_identif)) << '\n';
+            }
+            for (const auto& [expr, reg] : invariantes) {
+                if (auto term_int_lit = std::get_if<node::TermIntLit>(&std::get<node::Term>(expr->variant_expr).variant_term)) {
+                    m_out << "    mov rcx, " << term_int_lit->token_int.valor_int << '\n';
+                } else {
+                    m_out << "    mov rcx, " << endereco_var(buscar_escalar(std::get<node::TermIdentif>(std::get<node::Term>(expr->variant_expr).variant_term).token_identif)) << '\n';
+                }
+                std::string xmm = "xmm" + reg.substr(3);
+                if (m_avx2) {
+                    m_out << "    vmovq " << xmm << ", rcx\n";
+                    m_out << "    vpbroadcastq " << reg << ", " << xmm << '\n';
+                } else {
+                    m_out << "    movq " << reg << ", rcx\n";
+                    m_out << "    punpcklqdq " << reg << ", " << reg << '\n';
+                }
+            }
+            m_out << "    jmp " << label_teste << '\n';
+            m_out << "    align 16\n";
+            m_out << label_corpo << ":\n";
+            for (size_t k = 0; k + 1 < corpo.size(); k++) {
+                const node::StatmtIndex* statmt_index = std::get<node::StatmtIndex*>(corpo[k]->variant_statmt);
+                generate_expr_vetorial(statmt_index->expr, invariantes);
+                m_out << (m_avx2 ? "    vmovdqu " : "    movdqu ") << endereco_elemento(buscar_array(statmt_index->token_identif), "rax") << ", " << reg_vetor(0) << '\n';
+            }
+            m_out << "    add rax, " << largura << '\n';
+            m_out << label_teste << ":\n";
+            m_out << "    lea rcx, [rax + " << largura << "]\n";
+            m_out << "    cmp rcx, rdx\n";
+            if (menor_checado >= largura && menor_checado != std::numeric_limits<size_t>::max()) {
+                // todos os elementos do bloco [i, i + LARGURA) estão dentro do menor array verificado
+                m_out << "    jg " << label_fim << '\n';
+                m_out << "    cmp rax, " << menor_checado - largura << '\n';
+                m_out << "    jbe " << label_corpo << '\n';
+            } else if (menor_checado == std::numeric_limits<size_t>::max()) {
+                m_out << "    jle " << label_corpo << '\n';
+            }
+            m_out << label_fim << ":\n";
+            m_out << "    mov " << endereco_var(contador) << ", rax\n";
+            if (m_avx2) {
+                m_out << "    vzeroupper\n";
+            }
+        }
+
+        /*
+        Método que gera o código vetorial de uma expressão de um loop
+        vetorizado, com o resultado em xmm0 (ou ymm0). Os valores
+        intermediários ficam em registradores vetoriais, indexados pela
+        profundidade na pilha de resultados: o resultado de um nó na
+        posição d fica no registrador d. A árvore é percorrida em
+        pós-ordem com uma pilha explícita.
+        PARÂMETROS:
+        - expr (const node::Expr*): nó da expressão.
+        - invariantes (const std::vector<std::pair<const node::Expr*, std::string>>&):
+        registradores com os valores invariantes já replicados.
+        RETURNS:
+        */
+        inline void generate_expr_vetorial(const node::Expr* expr, const std::vector<std::pair<const node::Expr*, std::string>>& invariantes) {
+            struct Visita {
+                const node::Expr* expr;
+                bool filhos_prontos;
+            };
+            std::vector<Visita> pilha {{.expr = expr, .filhos_prontos = false}};
+            std::vector<std::string> resultados; // registrador com o valor de cada nó já visitado
+            const char* v = m_avx2 ? "v" : "";
+            while (!pilha.empty()) {
+                Visita visita = pilha.back();
+                pilha.pop_back();
+                std::string destino = reg_vetor(resultados.size());
+                if (auto bin_expr = std::get_if<node::BinExpr>(&visita.expr->variant_expr)) {
+                    int expoente = 0;
+                    const node::Expr* valor = bin_expr->token.tipo == TipoToken::asterisco ? fator_shift(*bin_expr, expoente) : nullptr;
+                    if (!visita.filhos_prontos) {
+                        pilha.push_back({.expr = visita.expr, .filhos_prontos = true});
+                        if (valor != nullptr) {
+                            pilha.push_back({.expr = valor, .filhos_prontos = false});
+                        } else {
+                            pilha.push_back({.expr = bin_expr->lado_direito, .filhos_prontos = false});
+                            pilha.push_back({.expr = bin_expr->lado_esquerdo, .filhos_prontos = false});
+                        }
+                        continue;
+                    }
+                    if (valor != nullptr) {
+                        // 'x * 2^k' vira um shift: SSE2 e AVX2 não têm multiplicação de inteiros de 64 bits
+                        destino = reg_vetor(resultados.size() - 1);
+                        copiar_vetor(destino, resultados.back());
+                        if (expoente > 0) {
+                            m_out << "    " << v << "psllq " << destino << ", " << (m_avx2 ? destino + ", " : "") << expoente << '\n';
+                        }
+                        resultados.back() = destino;
+                        continue;
+                    }
+                    std::string direito = resultados.back();
+                    resultados.pop_back();
+                    destino = reg_vetor(resultados.size() - 1);
+                    const char* instrucao = bin_expr->token.tipo == TipoToken::mais ? "paddq " : "psubq ";
+                    if (m_avx2) {
+                        m_out << "    vp" << instrucao + 1 << destino << ", " << resultados.back() << ", " << direito << '\n';
+                    } else {
+                        copiar_vetor(destino, resultados.back());
+                        m_out << "    " << instrucao << destino << ", " << direito << '\n';
+                    }
+                    resultados.back() = destino;
+                    continue;
+                }
+                const node::Term& term = std::get<node::Term>(visita.expr->variant_expr);
+                if (auto term_paren = std::get_if<node::TermParen>(&term.variant_term)) {
+                    pilha.push_back({.expr = term_paren->expr, .filhos_prontos = false});
+                } else if (auto term_index = std::get_if<node::TermIndex>(&term.variant_term)) {
+                    m_out << "    " << v << "movdqu " << destino << ", " << endereco_elemento(buscar_array(term_index->token_identif), "rax") << '\n';
+                    resultados.push_back(destino);
+                } else {
+                    resultados.push_back(registrador_invariante(visita.expr, invariantes));
+                }
+            }
+            copiar_vetor(reg_vetor(0), resultados.back());
+        }
+
+        /*
+        Métodos auxiliares da vetorização: o nome do registrador
+        vetorial n, a cópia entre registradores (omitida quando são
+        o mesmo), o registrador que guarda um valor invariante (ou
+        "" caso ele ainda não tenha um), o expoente de um literal
+        que é potência de 2 (ou -1) e, numa multiplicação por potência
+        de 2, o lado que é multiplicado (o outro vira o shift).
+        */
+        inline std::string reg_vetor(size_t n) const {
+            return (m_avx2 ? "ymm" : "xmm") + std::to_string(n);
+        }
+
+        inline void copiar_vetor(const std::string& destino, const std::string& origem) {
+            if (destino != origem) {
+                m_out << (m_avx2 ? "    vmovdqa " : "    movdqa ") << destino << ", " << origem << '\n';
+            }
+        }
+
+        static inline std::string registrador_invariante(const node::Expr* expr, const std::vector<std::pair<const node::Expr*, std::string>>& invariantes) {
+            const node::Term& term = std::get<node::Term>(expr->variant_expr);
+            for (const auto& [invariante, reg] : invariantes) {
+                const node::Term& outro = std::get<node::Term>(invariante->variant_expr);
+                auto lit_a = std::get_if<node::TermIntLit>(&term.variant_term);
+                auto lit_b = std::get_if<node::TermIntLit>(&outro.variant_term);
+                auto var_a = std::get_if<node::TermIdentif>(&term.variant_term);
+                auto var_b = std::get_if<node::TermIdentif>(&outro.variant_term);
+                if ((lit_a != nullptr && lit_b != nullptr && lit_a->token_int.valor_int == lit_b->token_int.valor_int)
+                    || (var_a != nullptr && var_b != nullptr && var_a->token_identif.valor == var_b->token_identif.valor)) {
+                    return reg;
+                }
+            }
+            return "";
+        }
+
+        static inline int potencia_de_2(const node::Expr* expr) {
+            auto term = std::get_if<node::Term>(&expr->variant_expr);
+            auto term_int_lit = term != nullptr ? std::get_if<node::TermIntLit>(&term->variant_term) : nullptr;
+            if (term_int_lit == nullptr || term_int_lit->token_int.valor_int <= 0 || !std::has_single_bit(static_cast<uint64_t>(term_int_lit->token_int.valor_int))) {
+                return -1;
+            }
+            return std::countr_zero(static_cast<uint64_t>(term_int_lit->token_int.valor_int));
+        }
+
+        static inline const node::Expr* fator_shift(const node::BinExpr& bin_expr, int& expoente) {
+            expoente = potencia_de_2(bin_expr.lado_direito);
+            if (expoente >= 0) {
+                return bin_expr.lado_esquerdo;
+            }
+            expoente = potencia_de_2(bin_expr.lado_esquerdo);
+            return bin_expr.lado_direito;
+        }
+
+        /*
+        Método que gera o código de uma chamada de função, supondo
+        que os argumentos já estão no topo da stack (o último acima
+        dos demais). Funções pequenas e não recursivas são expandidas
+        no local (checar generate_inline). As demais seguem a
+        convenção de chamada SysV: os 6 primeiros argumentos vão em
+        rdi, rsi, rdx, rcx, r8 e r9, os seguintes vão na stack (o 7º
+        no topo), a stack fica alinhada em 16 bytes no 'call' e o
+        resultado volta em rax.
+        PARÂMETROS:
+        - call (const node::TermCall*): nó da chamada.
+        RETURNS:
+        */
+        inline void generate_chamada(const node::TermCall* call) {
+            const InfoFuncao& info = buscar_fn(call->token_identif);
+            size_t num_args = call->args.size();
+            if (num_args != info.funcao->params.size()) {
+                throw ErroCompilacao {
+                    .mensagem = "A função '" + call->token_identif.valor.value() + "' espera "
+                        + std::to_string(info.funcao->params.size()) + " argumento(s).",
+                    .offset = call->token_identif.offset
+                };
+            }
+            if (deve_inline(info)) {
+                generate_inline(info.funcao);
+                return;
+            }
+
+            size_t base = m_stack_size - num_args; // posição do primeiro argumento
+            size_t na_stack = num_args > NUM_REGS_ARGS ? num_args - NUM_REGS_ARGS : 0;
+            if (na_stack == 0) {
+                for (size_t k = num_args; k > 0; k--) {
+                    pop(REGS_ARGS[k - 1]);
+                }
+            }
+            if ((m_stack_size + na_stack) % 2 != 0) {
+                m_out << "    sub rsp, 8\n";
+                m_stack_size++;
+            }
+            if (na_stack > 0) {
+                // os argumentos da stack são copiados para o topo na ordem inversa da avaliação
+                for (size_t k = num_args; k > NUM_REGS_ARGS; k--) {
+                    push(endereco_var({.stack_pos = base + k - 1}));
+                }
+                for (size_t k = 0; k < NUM_REGS_ARGS; k++) {
+                    m_out << "    mov " << REGS_ARGS[k] << ", " << endereco_var({.stack_pos = base + k}) << '\n';
+                }
+            }
+            m_out << "    call fn_" << call->token_identif.valor.value() << '\n';
+            m_chamadas.insert(call->token_identif.valor.value());
+            if (m_stack_size > base) {
+                m_out << "    add rsp, " << (m_stack_size - base) * 8 << '\n';
+                m_stack_size = base;
+            }
+        }
+
+        /*
+        Método que expande o corpo de uma função no local da chamada.
+        Os argumentos, já na stack, viram as variáveis dos parâmetros,
+        e o corpo é gerado num conjunto de escopos próprio (o corpo
+        não enxerga as variáveis de quem chama). Cada 'return' descarta
+        a stack até os argumentos e salta para o fim da expansão.
+        PARÂMETROS:
+        - funcao (const node::Function*): função chamada.
+        RETURNS:
+        */
+        inline void generate_inline(const node::Function* funcao) {
+            size_t base = m_stack_size - funcao->params.size();
+            std::vector<std::map<std::string, Variable>> scopes_chamador = std::move(m_scopes);
+            size_t num_scopes_chamador = num_scopes;
+            m_scopes = {criar_params(funcao, base)};
+            num_scopes = 1;
+            std::string label_fim = create_label();
+            m_inlines.push_back({.funcao = funcao, .label_fim = label_fim, .base = base});
+            generate_scope(funcao->scope);
+            m_inlines.pop_back();
+            bool alcancavel = !termina(funcao->scope->statmts_scope);
+            if (alcancavel) {
+                m_out << "    mov rax, 0\n"; // resultado de uma função que termina sem 'return'
+            }
+            end_scope(alcancavel);
+            m_out << label_fim << ":\n";
+            m_scopes = std::move(scopes_chamador);
+            num_scopes = num_scopes_chamador;
+        }
+
+        /*
+        Método que gera o código de uma função declarada com 'fn'.
+        O prólogo guarda rbp e copia os parâmetros (dos registradores
+        ou da stack de quem chama) para a stack da função, onde são
+        tratados como variáveis comuns. Uma chamada da função a ela
+        mesma em um 'return' volta para 'fn_<nome>.inicio' em vez de
+        empilhar uma nova chamada (checar generate_return).
+        PARÂMETROS:
+        - funcao (const node::Function*): nó da função.
+        RETURNS:
+        */
+        inline void generate_funcao(const node::Function* funcao) {
+            const std::string& nome = funcao->token_identif.valor.value();
+            m_funcao_atual = funcao;
+            m_prefixo_label = "fn_" + nome + ".";
+            m_label_count = 0;
+            m_stack_size = 0;
+            m_out << "fn_" << nome << ":\n";
+            m_out << "    push rbp\n";
+            m_out << "    mov rbp, rsp\n";
+            for (size_t k = 0; k < funcao->params.size(); k++) {
+                if (k < NUM_REGS_ARGS) {
+                    push(REGS_ARGS[k]);
+                } else {
+                    push("QWORD [rbp + " + std::to_string(16 + 8 * (k - NUM_REGS_ARGS)) + "]");
+                }
+            }
+            m_out << "fn_" << nome << ".inicio:\n";
+            m_scopes = {criar_params(funcao, 0)};
+            num_scopes = 1;
+            generate_scope(funcao->scope);
+            if (!termina(funcao->scope->statmts_scope)) {
+                m_out << "    mov rax, 0\n";
+                m_out << "    leave\n";
+                m_out << "    ret\n";
+            }
+            m_funcao_atual = nullptr;
+        }
+
+        /*
+        Método que gera o código de um 'return'. Dentro de uma
+        expansão (inline), salta para o fim dela; dentro de uma
+        função, restaura a stack de quem chamou e retorna. Quando
+        o valor retornado é uma chamada da própria função (tail
+        call), os argumentos novos são escritos sobre os parâmetros
+        e o código salta para o início do corpo, de modo que a
+        recursão não consome stack.
+        PARÂMETROS:
+        - statmt_return (const node::StatmtReturn*): nó do statement.
+        RETURNS:
+        */
+        inline void generate_return(const node::StatmtReturn* statmt_return) {
+            if (!m_inlines.empty()) {
+                generate_valor(statmt_return->expr);
+                if (m_stack_size > m_inlines.back().base) {
+                    m_out << "    add rsp, " << (m_stack_size - m_inlines.back().base) * 8 << '\n';
+                }
+                m_out << "    jmp " << m_inlines.back().label_fim << '\n';
+                return;
+            }
+            if (m_funcao_atual == nullptr) {
+                throw ErroCompilacao {
+                    .mensagem = "'return' só pode ser usado dentro de uma função.",
+                    .offset = statmt_return->token_return.offset
+                };
+            }
+            const node::Term* term = std::get_if<node::Term>(&Seletor::desembrulhar(statmt_return->expr)->variant_expr);
+            const node::TermCall* call = term != nullptr ? std::get_if<node::TermCall>(&term->variant_term) : nullptr;
+            size_t num_params = m_funcao_atual->params.size();
+            if (call != nullptr && call->token_identif.valor == m_funcao_atual->token_identif.valor && call->args.size() == num_params) {
+                for (const node::Expr* arg : call->args) {
+                    generate_expr(arg);
+                }
+                for (size_t k = num_params; k > 0; k--) {
+                    pop("rax");
+                    m_out << "    mov QWORD [rbp - " << 8 * k << "], rax\n";
+                }
+                m_out << "    lea rsp, [rbp - " << 8 * num_params << "]\n";
+                m_out << "    jmp fn_" << m_funcao_atual->token_identif.valor.value() << ".inicio\n";
+                return;
+            }
+            generate_valor(statmt_return->expr);
+            m_out << "    leave\n";
+            m_out << "    ret\n";
+        }
+
+        /*
+        Função base para a geração de código assembly. Para isso,
+        faz uso de um 'for' que atravessa o vetor de nós da AST
+        representando as diversas statements do programa. No final,
+        escreve a syscall padrão de saída do assembly, caso não
+        seja encontrado a função "exit()" ao longo do código. As
+        funções são geradas depois de '_start', seguidas do código
+        frio (checar generate_if) e das rotinas de suporte que o
+        programa usa (perfil, 'print' e erro de limites).
+        PARÂMETROS:
+        RETURNS:
+        - out (std::string): formato em string de uma stringstream
+        que contêm o código em assembly correspondente ao código
+        em .ml. Caso o Generator tenha uma saída (SaidaAsm), o código
+        já terá sido entregue a ela e a string retornada fica vazia.
+        */
+        inline std::string generate_program() {
+            for (const node::Function* funcao : m_program.funcoes) {
+                registrar_fn(analisar_fn(funcao));
+            }
+            m_scopes.push_back(m_variables);
+            m_out << "global _start\n_start:\n";
+            for (const node::Statmt* statmt : m_program.statmts) {
+                generate_statmt(statmt);
+                descarregar(TAMANHO_CHUNK);
+            }
+            m_out << "    xor edi, edi\n"; // código de saída do programa
+            generate_flush();
+            m_out << "    mov rax, 60\n"; //código da expressão de saída para o assembly
+            m_out << "    syscall\n";
+            for (const node::Function* funcao : m_program.funcoes) {
+                generate_funcao(funcao);
+                descarregar(TAMANHO_CHUNK);
+            }
+            m_out << m_frio.view();
+            if (!m_perfil.arquivo_saida.empty()) {
+                generate_runtime_perfil();
+            }
+            if (m_program.usa_print) {
+                generate_runtime_print();
+            }
+            if (m_usa_erro_limites) {
+                generate_erro_limites();
+            }
+            descarregar(0);
+            return m_out.str();
+        }
+
+
+        /*
+        Tamanho do corpo de uma função (em nós da AST), usado pelo
+        modelo de custo do inliner, e se ela chama a si mesma.
+        */
+        struct InfoFuncao {
+            const node::Function* funcao;
+            size_t custo;
+            bool recursiva;
+        };
+
+        /*
+        Método que calcula o custo de uma função para o inliner: o
+        número de nós da AST no corpo (statements e nós de expressões).
+        O corpo é percorrido com pilhas explícitas.
+        PARÂMETROS:
+        - funcao (const node::Function*): nó da função.
+        RETURNS:
+        - (InfoFuncao): custo da função e se ela chama a si mesma.
+        */
+        static inline InfoFuncao analisar_fn(const node::Function* funcao) {
+            InfoFuncao info {.funcao = funcao, .custo = 0, .recursiva = false};
+            std::vector<const std::vector<node::Statmt*>*> listas {&funcao->scope->statmts_scope};
+            std::vector<const node::Expr*> exprs;
+            while (!listas.empty()) {
+                const std::vector<node::Statmt*>* lista = listas.back();
+                listas.pop_back();
+                for (const node::Statmt* statmt : *lista) {
+                    info.custo++;
+                    if (auto statmt_exit = std::get_if<node::StatmtExit*>(&statmt->variant_statmt)) {
+                        exprs.push_back((*statmt_exit)->expr);
+                    } else if (auto statmt_return = std::get_if<node::StatmtReturn*>(&statmt->variant_statmt)) {
+                        exprs.push_back((*statmt_return)->expr);
+                    } else if (auto statmt_var = std::get_if<node::StatmtVar*>(&statmt->variant_statmt)) {
+                        std::visit([&exprs](auto* var) { exprs.push_back(var->expr); }, (*statmt_var)->variant_var);
+                    } else if (auto scope = std::get_if<node::Scope*>(&statmt->variant_statmt)) {
+                        listas.push_back(&(*scope)->statmts_scope);
+                    } else if (auto statmt_if = std::get_if<node::StatmtIf*>(&statmt->variant_statmt)) {
+                        exprs.push_back((*statmt_if)->expr);
+                        listas.push_back(&(*statmt_if)->scope->statmts_scope);
+                    } else if (auto statmt_while = std::get_if<node::StatmtWhile*>(&statmt->variant_statmt)) {
+                        exprs.push_back((*statmt_while)->expr);
+                        listas.push_back(&(*statmt_while)->scope->statmts_scope);
+                    } else if (auto statmt_index = std::get_if<node::StatmtIndex*>(&statmt->variant_statmt)) {
+                        exprs.push_back((*statmt_index)->indice);
+                        exprs.push_back((*statmt_index)->expr);
+                    } else if (auto statmt_print = std::get_if<node::StatmtPrint*>(&statmt->variant_statmt)) {
+                        exprs.push_back((*statmt_print)->expr);
+                    }
+                }
+                while (!exprs.empty()) {
+                    const node::Expr* expr = exprs.back();
+                    exprs.pop_back();
+                    info.custo++;
+                    if (auto bin_expr = std::get_if<node::BinExpr>(&expr->variant_expr)) {
+                        exprs.push_back(bin_expr->lado_esquerdo);
+                        exprs.push_back(bin_expr->lado_direito);
+                    } else if (auto term_paren = std::get_if<node::TermParen>(&std::get<node::Term>(expr->variant_expr).variant_term)) {
+                        exprs.push_back(term_paren->expr);
+                    } else if (auto term_call = std::get_if<node::TermCall>(&std::get<node::Term>(expr->variant_expr).variant_term)) {
+                        info.recursiva |= term_call->token_identif.valor == funcao->token_identif.valor;
+                        exprs.insert(exprs.end(), term_call->args.begin(), term_call->args.end());
+                    } else if (auto term_index = std::get_if<node::TermIndex>(&std::get<node::Term>(expr->variant_expr).variant_term)) {
+                        exprs.push_back(term_index->indice);
+                    }
+                }
+            }
+            return info;
+        }
+
+        /*
+        Método que registra uma função em m_funcoes, para que ela
+        possa ser chamada de qualquer ponto do programa.
+        PARÂMETROS:
+        - info (const InfoFuncao&): função e o seu custo (checar analisar_fn).
+        RETURNS:
+        */
+        inline void registrar_fn(const InfoFuncao& info) {
+            const Token& token_identif = info.funcao->token_identif;
+            if (!m_funcoes.try_emplace(token_identif.valor.value(), info).second) {
+                throw ErroCompilacao {
+                    .mensagem = "Função '" + token_identif.valor.value() + "' já declarada.",
+                    .offset = token_identif.offset
+                };
+            }
+        }
+
+        /*
+        Indica se as chamadas de uma função podem ser expandidas no
+        local (checar deve_inline), o que faz o código de quem chama
+        depender do corpo dela.
+        */
+        static inline bool inline_possivel(const InfoFuncao& info) {
+            return !info.recursiva && info.custo <= LIMITE_INLINE;
+        }
+
+        /*
+        Geração por unidades, usada pela compilação incremental
+        (checar incremental.hpp). Cada statement do nível mais externo
+        e cada função formam uma unidade, gerada separadamente e com
+        labels próprias, de modo que o código de uma unidade pode ser
+        guardado e reaproveitado enquanto o seu contexto não mudar:
+        para um statement, as variáveis de '_start' e o tamanho da
+        stack antes dele; para todas as unidades, a tabela de funções
+        e se o programa usa 'print'. As unidades são geradas sem as
+        anotações do Otimizador, que dependem do programa inteiro.
+        - codigo (std::string): assembly da unidade.
+        - declaradas: variáveis de '_start' criadas pelo statement.
+        - stack_size (size_t): tamanho da stack depois do statement.
+        - usa_erro_limites (bool): algum acesso a array é verificado.
+        - chamadas (std::set<std::string>): funções chamadas (sem as
+        expandidas no local), que o bloco da unidade declara como extern.
+        */
+        struct CodigoUnidade {
+            std::string codigo;
+            std::vector<std::pair<std::string, Variable>> declaradas;
+            size_t stack_size = 0;
+            bool usa_erro_limites = false;
+            std::set<std::string> chamadas;
+        };
+
+        /*
+        Método que gera um statement do nível mais externo como uma
+        unidade. O contexto (variáveis de '_start' e tamanho da stack)
+        é o deixado pela unidade anterior, gerada ou restaurada com
+        avancar_contexto.
+        PARÂMETROS:
+        - statmt (const node::Statmt*): statement da unidade.
+        - prefixo_label (std::string): prefixo único das labels da unidade.
+        RETURNS:
+        - (CodigoUnidade): código e efeito da unidade no contexto.
+        */
+        inline CodigoUnidade generate_unidade(const node::Statmt* statmt, std::string prefixo_label) {
+            if (m_scopes.empty()) {
+                m_scopes.push_back(m_variables);
+            }
+            size_t stack_entrada = m_stack_size;
+            m_prefixo_label = std::move(prefixo_label);
+            m_label_count = 0;
+            m_usa_erro_limites = false;
+            m_chamadas.clear();
+            generate_statmt(statmt);
+            CodigoUnidade unidade {.codigo = m_out.str(), .declaradas = {}, .stack_size = m_stack_size,
+                .usa_erro_limites = m_usa_erro_limites, .chamadas = std::move(m_chamadas)};
+            for (const auto& [nome, var] : m_scopes.front()) {
+                if (var.stack_pos >= stack_entrada) {
+                    unidade.declaradas.emplace_back(nome, var);
+                }
+            }
+            m_out.str("");
+            return unidade;
+        }
+
+        /*
+        Método que gera uma função como uma unidade. O contexto de
+        '_start' é preservado.
+        PARÂMETROS:
+        - funcao (const node::Function*): função da unidade.
+        RETURNS:
+        - (CodigoUnidade): código da função.
+        */
+        inline CodigoUnidade generate_unidade(const node::Function* funcao) {
+            std::vector<std::map<std::string, Variable>> scopes_start = std::move(m_scopes);
+            size_t stack_start = m_stack_size;
+            m_usa_erro_limites = false;
+            m_chamadas.clear();
+            generate_funcao(funcao);
+            CodigoUnidade unidade {.codigo = m_out.str(), .declaradas = {}, .stack_size = 0,
+                .usa_erro_limites = m_usa_erro_limites, .chamadas = std::move(m_chamadas)};
+            m_out.str("");
+            m_scopes = std::move(scopes_start);
+            m_stack_size = stack_start;
+            num_scopes = 1;
+            return unidade;
+        }
+
+        /*
+        Método que aplica ao contexto de '_start' o efeito de uma
+        unidade já gerada, sem gerá-la de novo.
+        PARÂMETROS:
+        - declaradas: variáveis criadas pela unidade (checar CodigoUnidade).
+        - stack_size (size_t): tamanho da stack depois da unidade.
+        RETURNS:
+        */
+        inline void avancar_contexto(const std::vector<std::pair<std::string, Variable>>& declaradas, size_t stack_size) {
+            if (m_scopes.empty()) {
+                m_scopes.push_back(m_variables);
+            }
+            m_scopes.front().insert(declaradas.begin(), declaradas.end());
+            m_stack_size = stack_size;
+        }
+
+        /*
+        Método que gera o fim de '_start' de um programa gerado por
+        unidades (a saída com código 0) e as rotinas de suporte que
+        as unidades usam.
+        PARÂMETROS:
+        - usa_erro_limites (bool): alguma unidade verifica limites.
+        RETURNS:
+        - (std::string): o código.
+        */
+        inline std::string generate_saida(bool usa_erro_limites) {
+            m_out << "    xor edi, edi\n";
+            generate_flush();
+            m_out << "    mov rax, 60\n";
+            m_out << "    syscall\n";
+            if (m_program.usa_print) {
+                generate_runtime_print();
+            }
+            if (usa_erro_limites) {
+                generate_erro_limites();
+            }
+            std::string codigo = m_out.str();
+            m_out.str("");
+            return codigo;
+        }
+
+        /*
+        Rotinas de suporte (checar generate_saida) que o código das
+        unidades pode chamar.
         PARÂMETROS:
-        - term (const node::Term*): ponteiro para o nó da AST
-        referente ao código que será gerado.
+        - usa_print (bool): o programa usa 'print'.
+        - usa_erro_limites (bool): alguma unidade verifica limites.
         RETURNS:
+        - (std::vector<std::string>): labels das rotinas.
         */
-        inline void generate_term(const node::Term* term) {
-            struct TermVisitor {
-                Generator& generator;
-                void operator()(const node::TermIntLit* term_int_lit) {
-                    generator.m_out << "    mov rax, " << term_int_lit->token_int.valor.value() << '\n';
-                    std::cout << "esta aqui para o valor: " << term_int_lit->token_int.valor.value() << '\n';
-                    generator.push("rax");
-                }
-                void operator()(const node::TermIdentif* term_identif) {
-                    int contem = 0;
-                    int i_og_scope;
-                    for (int i = 0; i < (generator.num_scopes); i++) {
-                        if (generator.m_scopes.at(i).contains(term_identif->token_identif.valor.value())) {
-                            contem = 1;
-                            i_og_scope = i;
-                            break;
-                        }
-                    }
-                    if (contem == 1) {
-                        auto &var = generator.m_scopes.at(i_og_scope).at(term_identif->token_identif.valor.value());
-                        std::stringstream offset;
-                        /*
-                        A stack é organizada para que cada elemento tenha um tamanho de 8 bytes. Assim, usamos o operador
-                        QWORD para especificar que vamos acessar um local na memória de 8 bytes de tamanho. Para mais,
-                        multiplicamos o offset por 8, pois ele por si só nos da o número de elementos entre o desejado e
-                        aquele no topo. Porém, cada elemento da stack possui 8 bytes de espaço, independente do tipo do
-                        dado que ali está. Portanto, multiplicamos por 8 para "descer" o número correto de bytes até o
-                        endereço desejado.
-                        */
-                        std::cout << "stack_size: " << generator.m_stack_size << " var: " << term_identif->token_identif.valor.value() << " pos na stack: " << var.stack_pos << std::endl;
-                        offset << "QWORD [rsp + " << (generator.m_stack_size - var.stack_pos - 1) * 8 << "]"; // stack e registrador %rsp crescem pra baixo.
-                        generator.push(offset.str());
-                    } else {
-                        std::cerr << "Identificador '" << term_identif->token_identif.valor.value() << "' não inicializado." << std::endl;
-                        exit(EXIT_FAILURE);
-                    }
-                }
-                void operator()(const node::TermParen* term_paren) {
-                    generator.generate_expr(term_paren->expr);
-                }
-            };
-            TermVisitor visitor {.generator = *this};
-            std::visit(visitor, term->variant_term);
+        static inline std::vector<std::string> simbolos_suporte(bool usa_print, bool usa_erro_limites) {
+            std::vector<std::string> simbolos;
+            if (usa_print) {
+                simbolos.push_back(LABEL_PRINT);
+                simbolos.push_back(LABEL_FLUSH);
+            }
+            if (usa_erro_limites) {
+                simbolos.push_back(LABEL_ERRO_LIMITES);
+            }
+            return simbolos;
         }
 
+    private:
+        static constexpr std::streamoff TAMANHO_CHUNK = 64 * 1024; // Tamanho mínimo de cada chunk entregue à saída
+
         /*
-        Método responsável pela geração de código assembly dos
-        nós de expressões gerados pelo parseamento. Implementa
-        um visitor pattern para reconhecer qual tipo de expressão
-        está lidando, e, assim, adaptar a geração de código.
-        PARÂMETROS:
-        - expr (const node::Expr*): ponteiro para o nó da AST
-        que servirá de base para a geração de código
-        RETURNS:
+        Item da pilha de trabalho da seleção de instruções: um nó a
+        ser reduzido ao não-terminal 'destino' (na 'etapa' 0, antes
+        dos filhos, ou 1, depois deles), ou, com 'expr' nulo, um
+        'push rax' que guarda um valor já calculado.
         */
-        inline void generate_expr(const node::Expr* expr) {
-            struct ExprVisitor {
-                Generator& generator;
-                void operator()(const node::Term* term) {
-                    generator.generate_term(term);
-                }
-                void operator()(const node::BinExpr* bin_expr) {
-                    generator.generate_bin_expr(bin_expr);
-                }
-            };
+        struct TarefaSelecao {
+            const node::Expr* expr;
+            burs::NaoTerminal destino;
+            uint8_t etapa = 0;
+        };
 
-            ExprVisitor visitor {.generator = *this};
-            std::visit(visitor, expr->variant_expr);
-        }
+        /*
+        Corpo de função sendo expandido no local da chamada: um
+        'return' dentro dele salta para 'label_fim', descartando
+        tudo o que está na stack acima de 'base' (onde ficam os
+        argumentos).
+        */
+        struct Inline {
+            const node::Function* funcao;
+            std::string label_fim;
+            size_t base;
+        };
+
+        static constexpr const char* REGS_ARGS[] = {"rdi", "rsi", "rdx", "rcx", "r8", "r9"}; // Registradores dos argumentos (SysV)
+        static constexpr size_t NUM_REGS_ARGS = 6;
+        static constexpr size_t LIMITE_INLINE = 40; // Custo máximo de uma função expandida no local da chamada
+        static constexpr size_t PROFUNDIDADE_INLINE = 4; // Máximo de expansões aninhadas
+        static constexpr const char* LABEL_ERRO_LIMITES = "erro_limites";
+        static constexpr const char* LABEL_PRINT = "mlc_print";
+        static constexpr const char* LABEL_FLUSH = "mlc_flush";
+        static constexpr const char* LABEL_PERFIL = "mlc_perfil";
+        static constexpr uint64_t FRACAO_FRIA = 10; // Corpos de 'if' executados em menos de 1/10 das vezes ficam fora da linha
+        static constexpr size_t TAMANHO_BUFFER_PRINT = 64 * 1024; // Bytes acumulados antes de cada 'write'
+        static constexpr size_t AREA_PRINT = 24; // Sinal, até 19 dígitos e a quebra de linha, arredondados para 8 bytes
+        static constexpr std::string_view MENSAGEM_ERRO_LIMITES = "Erro: indice fora dos limites do array.";
+        static constexpr size_t NUM_REGS_VETOR = 16; // xmm0-xmm15 (ou ymm0-ymm15)
+
+        /*
+        Item da pilha de trabalho de statements: um statement a
+        ser gerado, o fechamento de um escopo, uma label a ser
+        escrita (ex.: o fim de um 'if'), a condição no fim de
+        um 'while' ('condicao', que salta de volta para 'label_corpo'),
+        ou o fim de um corpo fora da linha, que salta de volta para
+        'label' (checar generate_if).
+        */
+        struct TarefaStatmt {
+            enum Tipo { gerar_statmt, fechar_escopo, escrever_label, fechar_while, fechar_frio } tipo;
+            const node::Statmt* statmt;
+            std::string label;
+            const node::Expr* condicao = nullptr;
+            std::string label_corpo = {};
+            bool alcancavel = true; // fechar_escopo: a execução pode chegar ao fim do escopo
+        };
+
+        const node::Program m_program; // Nó referente ao início do programa
+        SaidaAsm m_saida; // Destino opcional do código gerado, em chunks
+        std::stringstream m_out; // Stringstream que contêm todo o código assembly (ou o chunk atual)
+        size_t m_stack_size = 0; // Número de informações na stack
+        std::map<std::string, Variable> m_variables; // HashMap com todas as variáveis
+        std::vector<std::map<std::string, Variable>> m_scopes; // Vetor com os maps de cada escopo
+        size_t num_scopes = 1;
+        int m_label_count = 0;
+        std::string m_prefixo_label; // Prefixo das labels da função atual ("" em _start)
+        std::unordered_map<std::string, InfoFuncao> m_funcoes; // Funções do programa, por nome
+        const node::Function* m_funcao_atual = nullptr; // Função sendo gerada (nullptr em _start)
+        std::vector<Inline> m_inlines; // Corpos de função sendo expandidos, do mais externo ao mais interno
+        Seletor m_seletor; // Rótulos da seleção de instruções (BURS) da expressão atual
+        std::vector<TarefaSelecao> m_pilha_selecao; // Pilha de trabalho de generate_valor
+        size_t m_profundidade_selecao = 0; // Chamadas de generate_valor em andamento
+        TipoToken m_condicao = TipoToken::maior; // Comparação feita pelo último 'cmp' (não-terminal cond)
+        std::vector<TarefaStatmt> m_pilha_statmt; // Pilha de trabalho de generate_statmt/generate_scope
+        bool m_avx2 = false; // Loops vetorizados com AVX2 (ymm) em vez de SSE2 (xmm)
+        bool m_usa_erro_limites = false; // Algum acesso a array é verificado em tempo de execução
+        OpcoesPerfil m_perfil; // Instrumentação e uso do perfil de execução
+        std::stringstream m_frio; // Corpos de 'if' raramente executados, escritos depois das funções
+        bool m_em_codigo_frio = false; // O código atual está sendo escrito em m_frio (e m_out é o código frio)
+        std::set<std::string> m_chamadas; // Funções chamadas pela unidade atual (checar CodigoUnidade)
 
         /*
-        Método responsável pela geração de código assembly
-        para os nós de expressões binárias. Implementa um 
-        visitor pattern para adaptar a geração de código
-        conforme o tipo de expressão que está lidando.
+        Método que aplica a um nó a regra escolhida pelo Seletor
+        para o não-terminal da tarefa. Regras que precisam do valor
+        dos filhos agendam, na pilha de trabalho, a redução dos filhos
+        seguida da própria tarefa com 'etapa' = 1, que escreve a
+        instrução final.
         PARÂMETROS:
-        - bin_expr (const node::BinExpr*): ponteiro para o
-        nó da AST referente à expressão binária que servirá de
-        base para a geração de código.
+        - tarefa (const TarefaSelecao&): nó, não-terminal e etapa.
         RETURNS:
         */
-        inline void generate_bin_expr(const node::BinExpr* bin_expr) {
-            switch (bin_expr->token.tipo) {
-                case TipoToken::mais:
-                    generate_expr(bin_expr->lado_esquerdo);
-                    generate_expr(bin_expr->lado_direito);
-                    pop("rax");
-                    pop("rbx");
-                    m_out << "    add rax, rbx\n";
-                    push("rax");
+        inline void reduzir(const TarefaSelecao& tarefa) {
+            using burs::Acao;
+            using burs::NaoTerminal;
+            const node::Expr* expr = tarefa.expr;
+            const burs::Regra& regra = m_seletor.regra(expr, tarefa.destino);
+            const node::BinExpr* bin_expr = std::get_if<node::BinExpr>(&expr->variant_expr);
+            const node::Expr* esq = bin_expr != nullptr ? Seletor::desembrulhar(bin_expr->lado_esquerdo) : nullptr;
+            const node::Expr* dir = bin_expr != nullptr ? Seletor::desembrulhar(bin_expr->lado_direito) : nullptr;
+            auto continuar = [&]() {
+                m_pilha_selecao.push_back({.expr = expr, .destino = tarefa.destino, .etapa = 1});
+            };
+            auto calcular = [&](const node::Expr* filho, NaoTerminal nt = NaoTerminal::reg) {
+                m_pilha_selecao.push_back({.expr = filho, .destino = nt});
+            };
+
+            switch (regra.acao) {
+                case Acao::carregar_literal: {
+                    int64_t valor = Seletor::valor_literal(expr).value();
+                    if (valor == 0) {
+                        m_out << "    xor eax, eax\n";
+                    } else if (valor > 0 && valor <= std::numeric_limits<uint32_t>::max()) {
+                        m_out << "    mov eax, " << valor << '\n'; // zera os 32 bits de cima, com uma instrução menor
+                    } else {
+                        m_out << "    mov rax, " << valor << '\n';
+                    }
                     break;
-                case TipoToken::menos:
-                    generate_expr(bin_expr->lado_esquerdo);
-                    generate_expr(bin_expr->lado_direito);
-                    pop("rax");
-                    pop("rbx");
-                    m_out << "    sub rbx, rax\n";
-                    push("rbx");
+                }
+                case Acao::carregar_mem:
+                    m_out << "    mov rax, " << operando_folha(expr).value() << '\n';
                     break;
-                case TipoToken::asterisco:
-                    generate_expr(bin_expr->lado_esquerdo);
-                    generate_expr(bin_expr->lado_direito);
-                    pop("rax");
-                    pop("rbx");
-                    m_out << "    mul rbx\n";
-                    push("rax");
+                case Acao::chamada: {
+                    const node::TermCall& term_call = std::get<node::TermCall>(std::get<node::Term>(expr->variant_expr).variant_term);
+                    if (tarefa.etapa == 1) {
+                        generate_chamada(&term_call);
+                        break;
+                    }
+                    // cada argumento é calculado e empilhado, na ordem do código fonte
+                    continuar();
+                    for (auto it = term_call.args.rbegin(); it != term_call.args.rend(); it++) {
+                        m_pilha_selecao.push_back({.expr = nullptr, .destino = NaoTerminal::reg});
+                        calcular(Seletor::desembrulhar(*it));
+                    }
                     break;
-                case TipoToken::barra_div:
-                    generate_expr(bin_expr->lado_esquerdo);
-                    generate_expr(bin_expr->lado_direito);
-                    pop("rbx");
-                    pop("rax");
-                    m_out << "    div rbx\n";
-                    push("rax");
+                }
+                case Acao::leitura: {
+                    const node::TermIndex& term_index = std::get<node::TermIndex>(std::get<node::Term>(expr->variant_expr).variant_term);
+                    if (tarefa.etapa == 1) {
+                        generate_leitura(&term_index);
+                        break;
+                    }
+                    continuar();
+                    calcular(Seletor::desembrulhar(term_index.indice));
                     break;
-                case TipoToken::maior:
-                case TipoToken::menor:
-                case TipoToken::maior_igual:
-                case TipoToken::menor_igual:
-                    generate_expr(bin_expr->lado_esquerdo);
-                    generate_expr(bin_expr->lado_direito);
-                    pop("rbx");
-                    pop("rax");
-                    m_out << "    cmp rax, rbx\n";
+                }
+                case Acao::op_direita:
+                case Acao::op_esquerda: {
+                    bool invertido = regra.acao == Acao::op_esquerda;
+                    if (tarefa.etapa == 1) {
+                        const node::Expr* operando = invertido ? esq : dir;
+                        emitir_op(bin_expr->token.tipo, operando_folha(operando).value(), Seletor::valor_literal(operando).has_value(), invertido);
+                        break;
+                    }
+                    continuar();
+                    calcular(invertido ? dir : esq);
+                    break;
+                }
+                case Acao::op_mem_imm: {
+                    bool imm_esq = Seletor::valor_literal(esq).has_value();
+                    m_out << "    imul rax, " << operando_folha(imm_esq ? dir : esq).value() << ", " << operando_folha(imm_esq ? esq : dir).value() << '\n';
+                    break;
+                }
+                case Acao::op_reg:
+                    if (tarefa.etapa == 1) {
+                        emitir_op_reg(bin_expr->token.tipo);
+                        break;
+                    }
+                    continuar();
+                    calcular(dir);
+                    m_pilha_selecao.push_back({.expr = nullptr, .destino = NaoTerminal::reg});
+                    calcular(esq);
+                    break;
+                case Acao::lea:
+                    reduzir_lea(tarefa, m_seletor.rotulo(expr).ender);
+                    break;
+                case Acao::shl: {
+                    const burs::Endereco& escala = m_seletor.rotulo(expr).escala;
+                    if (tarefa.etapa == 1) {
+                        m_out << "    shl rax, " << std::countr_zero(static_cast<uint64_t>(escala.fator)) << '\n';
+                        break;
+                    }
+                    continuar();
+                    calcular(escala.indice);
+                    break;
+                }
+                case Acao::setcc:
+                    if (tarefa.etapa == 1) {
+                        m_out << "    set" << sufixo_cond(m_condicao) << " al\n";
+                        m_out << "    movzx eax, al\n";
+                        break;
+                    }
+                    continuar();
+                    calcular(expr, NaoTerminal::cond);
+                    break;
+                case Acao::operando:
+                case Acao::compor:
+                    assert(false && "imm, mem, escala e ender não são reduzidos sozinhos");
                     break;
             }
         }
 
         /*
-        Método responsável por lidar com escopos na geração de 
-        código assembly. Assim, inicia e finaliza um escopo, 
-        enquanto, no processo, chama a geração de código para
-        os statement encontrados no interior do escopo em questão.
+        Método que reduz um endereço (não-terminal ender) a um 'lea'.
+        Com um único componente (ou base e índice iguais), ele é
+        calculado em rax. Com dois, uma variável é carregada direto
+        em rcx; quando os dois geram código, o primeiro no código
+        fonte é calculado antes e espera na stack.
         PARÂMETROS:
-        - scope (const node::Scope*): ponteiro para o nó da AST
-        referente ao escopo que está interpretando.
+        - tarefa (const TarefaSelecao&): tarefa do nó.
+        - ender (const burs::Endereco&): endereço do nó.
         RETURNS:
         */
-        inline void generate_scope(const node::Scope* scope) {
-            begin_scope();
-            for (const node::Statmt* statmt : scope->statmts_scope) {
-                generate_statmt(statmt);
+        inline void reduzir_lea(const TarefaSelecao& tarefa, const burs::Endereco& ender) {
+            bool dois = ender.base != nullptr && ender.indice != nullptr && ender.base != ender.indice;
+            bool folha_indice = dois && m_seletor.eh_folha(ender.indice);
+            bool folha_base = dois && !folha_indice && m_seletor.eh_folha(ender.base);
+            if (tarefa.etapa == 0) {
+                m_pilha_selecao.push_back({.expr = tarefa.expr, .destino = tarefa.destino, .etapa = 1});
+                if (!dois || folha_indice || folha_base) {
+                    const node::Expr* componente = folha_base || ender.base == nullptr ? ender.indice : ender.base;
+                    m_pilha_selecao.push_back({.expr = componente, .destino = burs::NaoTerminal::reg});
+                } else {
+                    const node::Expr* primeiro = ender.indice_primeiro ? ender.indice : ender.base;
+                    const node::Expr* segundo = ender.indice_primeiro ? ender.base : ender.indice;
+                    m_pilha_selecao.push_back({.expr = segundo, .destino = burs::NaoTerminal::reg});
+                    m_pilha_selecao.push_back({.expr = nullptr, .destino = burs::NaoTerminal::reg});
+                    m_pilha_selecao.push_back({.expr = primeiro, .destino = burs::NaoTerminal::reg});
+                }
+                return;
+            }
+            std::string base;
+            std::string indice;
+            if (!dois) {
+                base = ender.base != nullptr ? "rax" : "";
+                indice = ender.indice != nullptr ? "rax" : "";
+            } else if (folha_indice || folha_base) {
+                m_out << "    mov rcx, " << operando_folha(folha_indice ? ender.indice : ender.base).value() << '\n';
+                base = folha_indice ? "rax" : "rcx";
+                indice = folha_indice ? "rcx" : "rax";
+            } else {
+                pop("rcx");
+                base = ender.indice_primeiro ? "rax" : "rcx";
+                indice = ender.indice_primeiro ? "rcx" : "rax";
             }
-            end_scope();
+            m_out << "    lea rax, [" << base;
+            if (!indice.empty()) {
+                m_out << (base.empty() ? "" : " + ") << indice << '*' << ender.fator;
+            }
+            if (ender.deslocamento != 0) {
+                m_out << (ender.deslocamento < 0 ? " - " : " + ") << (ender.deslocamento < 0 ? -ender.deslocamento : ender.deslocamento);
+            }
+            m_out << "]\n";
         }
 
         /*
-        Método que gera o código assembly para os diferentes tipos
-        de statements possíveis (checar grammar.md). Implementa
-        um visitor pattern para reconhecer qual tipo de statement
-        dentro do std::variant esta lidando com, e, assim, adaptar
-        a geração de código.
+        Método que consome a pilha de trabalho de statements até
+        que ela volte ao tamanho 'base'. Implementa um visitor
+        pattern para reconhecer qual tipo de statement dentro do
+        std::variant esta lidando com, e, assim, adaptar a geração
+        de código.
         PARÂMETROS:
-        - statmt (const node::Statmt*): ponteiro para o nó da AST
-        que servirá de base para a geração de código.
+        - base (size_t): tamanho da pilha antes do trabalho atual.
         RETURNS:
         */
-        inline void generate_statmt(const node::Statmt* statmt) {
+        inline void executar_statmts(size_t base) {
             struct StatmtVisitor {
                 Generator& generator;
                 void operator()(const node::StatmtExit* statmt_exit) {
-                    generator.generate_expr(statmt_exit->expr);
+                    generator.generate_valor_em(statmt_exit->expr, "rdi");
+                    generator.generate_flush();
                     generator.m_out << "    mov rax, 60\n";
-                    generator.pop("rdi");
                     generator.m_out << "    syscall\n";
                 }
+                void operator()(const node::StatmtPrint* statmt_print) {
+                    generator.generate_valor_em(statmt_print->expr, "rdi");
+                    generator.m_out << "    call " << LABEL_PRINT << '\n';
+                }
                 void operator()(const node::StatmtVar* statmt_var) {
                     struct VarVisitor {
                         Generator& generator;
                         void operator()(const node::NewVar* new_var) {
                             if (new_var->token_identif.valor.has_value()) {
-                                for (int i = 0; i < generator.m_scopes.size(); i++) {
-                                    if (generator.m_scopes.at(i).contains(new_var->token_identif.valor.value())) {
-                                        std::cerr << "Identificador '" << new_var->token_identif.valor.value() << "' já utilizado." << std::endl;
-                                        exit(EXIT_FAILURE);
-                                    }
-                                }
+                                generator.checar_novo_identif(new_var->token_identif);
                                 Variable nova_var = {.stack_pos = generator.m_stack_size};
                                 generator.m_scopes.back().insert({new_var->token_identif.valor.value(), nova_var});
                                 generator.generate_expr(new_var->expr);
@@ -214,135 +1652,459 @@ class Generator {
                         }
                         void operator()(const node::ReassVar* reass_var) {
                             if (reass_var->token_identif.valor.has_value()) {
-                                int contem = 0;
-                                int i_og_scope;
-                                for (int i = 0; i < generator.num_scopes; i++) {
-                                    if (generator.m_scopes.at(i).contains(reass_var->token_identif.valor.value())) {
-                                        contem = 1;
-                                        i_og_scope = i;
-                                        break;
-                                    }
-                                }
-                                if (contem == 1) {
-                                    // !!!!!!!!!
-                                    /*
-                                    O problema está aqui:
-                                    na hora que eu encontro uma expressão de reassignment, eu estou gerando o código do valor
-                                    que a variável vai receber e depois eu mexo o ponteiro da stack. Nâo é assim que deve ser feito.
-                                    Eu primeiro preciso mover o ponteiro da stack para a posição na stack da variável que vai
-                                    receber o reassignment, pra depois dar push no valor em si. Depois mexo novamente o ponteiro para
-                                    a base da stack.
-                                    O problema é: como vou fazer isso sem afetar a geração de código de, por exemplo, expressões binárias?
-                                    Por que isso foi generalizado para ser feito na função de geração de termos, sendo um termo um inteiro
-                                    ou um identificador. Então toda vez que eu encontrar um identificador, vou para essa função, não
-                                    necessariamente sendo um reassignment.
-                                    */
-                                    
-
-                                    auto &var = generator.m_scopes.at(i_og_scope).at(reass_var->token_identif.valor.value());
-                                    // std::stringstream offset;
-                                    // std::cout << "ESTOU NO NOVO QWORD" << std::endl;
-                                    std::cout << "stack_size: " << generator.m_stack_size << " var: " << reass_var->token_identif.valor.value() << " pos na stack: " << var.stack_pos << std::endl;
-                                    // offset << "QWORD [rsp + " << (generator.m_stack_size - var.stack_pos) * 8 << "]"; // stack e registrador %rsp crescem pra baixo.
-                                    // generator.push(offset.str());
-                                    
-                                    generator.m_out << "    add rsp, " << (generator.m_stack_size - var.stack_pos) * 8 << '\n';
-                                    generator.generate_expr(reass_var->expr);
-
-                                    // TESTAR CHAMAR QWORD AQUI
-                                } else {
-                                    std::cerr << "Identificador '" << reass_var->token_identif.valor.value() << "' não inicializado." << std::endl;
-                                    exit(EXIT_FAILURE);
-                                }
+                                generator.generate_atribuicao(reass_var);
                             }
                         }
                     };
                     std::visit(VarVisitor {.generator = generator}, statmt_var->variant_var);
                 }
                 void operator()(const node::Scope* scope) {
-                    generator.generate_scope(scope);
+                    generator.agendar_scope(scope);
                 }
                 void operator()(const node::StatmtIf* statmt_if) {
-                    struct StatmtIfVisitor {
-                        Generator& generator;
-                        std::string label;
-                        void operator()(const node::Term* term) {
-                            generator.pop("rax");
-                            generator.m_out << "    cmp rax, 0\n";
-                            generator.m_out << "    jle " << label << '\n';
-                        }
-                        void operator()(const node::BinExpr* bin_expr) {
-                            switch (bin_expr->token.tipo) {
-                                case TipoToken::mais:
-                                case TipoToken::menos:
-                                case TipoToken::asterisco:
-                                case TipoToken::barra_div:
-                                    generator.m_out << "    jz " << label << '\n';
-                                    break;
-                                case TipoToken::maior:
-                                    std::cout << generator.m_stack_size << std::endl;
-                                    generator.m_out << "    jle " << label << '\n';
-                                    break;
-                                case TipoToken::menor:
-                                    generator.m_out << "    jge " << label << '\n';
-                                    break;
-                                case TipoToken::maior_igual:
-                                    generator.m_out << "    jl " << label << '\n';
-                                    break;
-                                case TipoToken::menor_igual:
-                                    generator.m_out << "    jg " << label << '\n';
-                                    break;
-                            }
+                    generator.generate_if(statmt_if);
+                }
+                void operator()(const node::StatmtReturn* statmt_return) {
+                    generator.generate_return(statmt_return);
+                }
+                void operator()(const node::StatmtArray* statmt_array) {
+                    generator.checar_novo_identif(statmt_array->token_identif);
+                    size_t tamanho = static_cast<size_t>(statmt_array->token_tamanho.valor_int);
+                    Variable array = {.stack_pos = generator.m_stack_size, .tamanho = tamanho};
+                    generator.m_scopes.back().insert({statmt_array->token_identif.valor.value(), array});
+                    // arrays pequenos são zerados com 'push', os demais com 'rep stosq'
+                    if (tamanho <= 4) {
+                        for (size_t k = 0; k < tamanho; k++) {
+                            generator.push("0");
                         }
-                    };
-                    std::string label = generator.create_label();
-                    generator.generate_expr(statmt_if->expr);
-                    std::visit(StatmtIfVisitor {.generator = generator, .label = label}, statmt_if->expr->variant_expr);
-                    generator.generate_scope(statmt_if->scope);
-                    generator.m_out << label << ":\n";
+                        return;
+                    }
+                    generator.m_out << "    sub rsp, " << tamanho * 8 << '\n';
+                    generator.m_out << "    mov rdi, rsp\n";
+                    generator.m_out << "    mov rcx, " << tamanho << '\n';
+                    generator.m_out << "    xor eax, eax\n";
+                    generator.m_out << "    rep stosq\n";
+                    generator.m_stack_size += tamanho;
+                }
+                void operator()(const node::StatmtIndex* statmt_index) {
+                    const Variable& array = generator.buscar_array(statmt_index->token_identif);
+                    generator.generate_expr(statmt_index->indice);
+                    generator.generate_valor_em(statmt_index->expr, "rcx");
+                    generator.pop("rax");
+                    if (statmt_index->checar) {
+                        generator.generate_checagem(array, "rax");
+                    }
+                    generator.m_out << "    mov QWORD " << generator.endereco_elemento(array, "rax") << ", rcx\n";
+                }
+                void operator()(const node::StatmtWhile* statmt_while) {
+                    /*
+                    O loop é gerado com a condição no final ("loop rotation"): a entrada salta direto
+                    para a condição, e cada iteração executa um único salto condicional de volta ao
+                    corpo. O início do corpo é alinhado em 16 bytes; o preenchimento fica entre o
+                    'jmp' e a label, então nunca é executado. Loops frios (fora da linha, ou que
+                    nunca entraram no corpo segundo o perfil) não são alinhados.
+                    */
+                    if (statmt_while->vetorizar) {
+                        generator.generate_while_vetorial(statmt_while);
+                    }
+                    std::string label_condicao = generator.create_label();
+                    std::string label_corpo = generator.create_label();
+                    generator.m_out << "    jmp " << label_condicao << '\n';
+                    if (!generator.m_em_codigo_frio && generator.execucoes(statmt_while->scope->contador).value_or(1) > 0) {
+                        generator.m_out << "    align 16\n";
+                    }
+                    generator.m_out << label_corpo << ":\n";
+                    generator.m_pilha_statmt.push_back({
+                        .tipo = TarefaStatmt::fechar_while,
+                        .statmt = nullptr,
+                        .label = label_condicao,
+                        .condicao = statmt_while->expr,
+                        .label_corpo = label_corpo
+                    });
+                    generator.agendar_scope(statmt_while->scope);
                 }
             };
-            StatmtVisitor visitor {.generator = *this};
-            std::visit(visitor, statmt->variant_statmt);
+
+            while (m_pilha_statmt.size() > base) {
+                MLC_TRACE_SCOPE("visit_statmt");
+                TarefaStatmt tarefa = std::move(m_pilha_statmt.back());
+                m_pilha_statmt.pop_back();
+                switch (tarefa.tipo) {
+                    case TarefaStatmt::gerar_statmt:
+                        std::visit(StatmtVisitor {.generator = *this}, tarefa.statmt->variant_statmt);
+                        break;
+                    case TarefaStatmt::fechar_while:
+                        m_out << tarefa.label << ":\n";
+                        generate_condicao(tarefa.condicao, tarefa.label_corpo, true);
+                        break;
+                    case TarefaStatmt::fechar_escopo:
+                        end_scope(tarefa.alcancavel);
+                        break;
+                    case TarefaStatmt::escrever_label:
+                        m_out << tarefa.label << ":\n";
+                        break;
+                    case TarefaStatmt::fechar_frio:
+                        m_out << "    jmp " << tarefa.label << '\n';
+                        std::swap(m_out, m_frio);
+                        m_em_codigo_frio = false;
+                        break;
+                }
+            }
         }
 
         /*
-        Função base para a geração de código assembly. Para isso,
-        faz uso de um 'for' que atravessa o vetor de nós da AST
-        representando as diversas statements do programa. No final, 
-        escreve a syscall padrão de saída do assembly, caso não
-        seja encontrado a função "exit()" ao longo do código.
+        Método que inicia um escopo e empilha, na pilha de trabalho
+        de statements, os statements do escopo (em ordem reversa,
+        para que saiam na ordem original) e o seu fechamento.
         PARÂMETROS:
+        - scope (const node::Scope*): nó do escopo.
         RETURNS:
-        - out (std::string): formato em string de uma stringstream
-        que contêm o código em assembly correspondente ao código 
-        em .ml.
         */
-        inline std::string generate_program() {
-            m_scopes.push_back(m_variables);
-            m_out << "global _start\n_start:\n";
-                for (const node::Statmt* statmt : m_program.statmts) {   
-                    generate_statmt(statmt);
+        inline void agendar_scope(const node::Scope* scope) {
+            begin_scope();
+            contar(scope->contador);
+            m_pilha_statmt.push_back({.tipo = TarefaStatmt::fechar_escopo, .statmt = nullptr, .label = {}, .alcancavel = !termina(scope->statmts_scope)});
+            for (auto it = scope->statmts_scope.rbegin(); it != scope->statmts_scope.rend(); it++) {
+                m_pilha_statmt.push_back({.tipo = TarefaStatmt::gerar_statmt, .statmt = *it, .label = {}});
+            }
+        }
+
+        /*
+        Método que escreve o incremento de um contador do perfil
+        (checar generate_runtime_perfil). Não gera código em
+        programas não instrumentados.
+        PARÂMETROS:
+        - contador (uint32_t): posição do contador (node::Scope::contador).
+        RETURNS:
+        */
+        inline void contar(uint32_t contador) {
+            if (!m_perfil.arquivo_saida.empty()) {
+                m_out << "    inc QWORD [rel " << LABEL_PERFIL << ".contadores + " << 8 * static_cast<size_t>(contador) << "]\n";
+            }
+        }
+
+        /*
+        Método que consulta o perfil de execução.
+        PARÂMETROS:
+        - contador (uint32_t): posição do contador (node::Scope::contador).
+        RETURNS:
+        - (std::optional<uint64_t>): quantas vezes o escopo ou 'if'
+        foi executado, ou vazio quando não há perfil.
+        */
+        inline std::optional<uint64_t> execucoes(uint32_t contador) const {
+            if (m_perfil.perfil == nullptr) {
+                return {};
+            }
+            return m_perfil.perfil->contadores[contador];
+        }
+
+        /*
+        Método que verifica se o corpo de um 'if' pode ser trocado
+        por um 'cmov': ele precisa ter uma única atribuição a uma
+        variável, cujo valor seja calculado só com literais, variáveis
+        e +, -, * ou comparações. Assim, calculá-lo mesmo quando a
+        condição é falsa não tem efeitos (chamadas, leituras de
+        arrays e divisões podem ter).
+        PARÂMETROS:
+        - scope (const node::Scope*): corpo do 'if'.
+        RETURNS:
+        - (const node::ReassVar*): a atribuição, ou nulo caso o
+        corpo não possa ser trocado.
+        */
+        inline const node::ReassVar* atribuicao_cmov(const node::Scope* scope) const {
+            if (scope->statmts_scope.size() != 1) {
+                return nullptr;
+            }
+            auto statmt_var = std::get_if<node::StatmtVar*>(&scope->statmts_scope[0]->variant_statmt);
+            auto reass_var = statmt_var != nullptr ? std::get_if<node::ReassVar*>(&(*statmt_var)->variant_var) : nullptr;
+            if (reass_var == nullptr || !(*reass_var)->token_identif.valor.has_value()) {
+                return nullptr;
+            }
+            std::vector<const node::Expr*> pilha {(*reass_var)->expr};
+            while (!pilha.empty()) {
+                const node::Expr* expr = pilha.back();
+                pilha.pop_back();
+                if (auto bin_expr = std::get_if<node::BinExpr>(&expr->variant_expr)) {
+                    if (bin_expr->token.tipo == TipoToken::barra_div) {
+                        return nullptr;
+                    }
+                    pilha.push_back(bin_expr->lado_esquerdo);
+                    pilha.push_back(bin_expr->lado_direito);
+                    continue;
                 }
-            m_out << "    mov rax, 60\n"; //código da expressão de saída para o assembly
-            m_out << "    mov rdi, 0\n"; // código de saída do programa
-            m_out << "    syscall\n";
-            return m_out.str();
+                const node::Term& term = std::get<node::Term>(expr->variant_expr);
+                if (auto term_paren = std::get_if<node::TermParen>(&term.variant_term)) {
+                    pilha.push_back(term_paren->expr);
+                } else if (auto term_identif = std::get_if<node::TermIdentif>(&term.variant_term)) {
+                    if (buscar_var(term_identif->token_identif).tamanho != 0) {
+                        return nullptr;
+                    }
+                } else if (!std::holds_alternative<node::TermIntLit>(term.variant_term)) {
+                    return nullptr;
+                }
+            }
+            return *reass_var;
         }
 
+        /*
+        Método que procura uma variável em todos os escopos abertos.
+        PARÂMETROS:
+        - token_identif (const Token&): token do identificador.
+        RETURNS:
+        - (const Variable&): variável encontrada. Caso ela não
+        exista, lança um ErroCompilacao.
+        */
+        inline const Variable& buscar_var(const Token& token_identif) const {
+            for (size_t i = 0; i < num_scopes; i++) {
+                auto it = m_scopes.at(i).find(token_identif.valor.value());
+                if (it != m_scopes.at(i).end()) {
+                    return it->second;
+                }
+            }
+            throw ErroCompilacao {
+                .mensagem = "Identificador '" + token_identif.valor.value() + "' não inicializado.",
+                .offset = token_identif.offset
+            };
+        }
 
-    private:
-        const node::Program m_program; // Nó referente ao início do programa
-        std::stringstream m_out; // Stringstream que contêm todo o código assembly
-        size_t m_stack_size = 0; // Número de informações na stack
-        std::map<std::string, Variable> m_variables; // HashMap com todas as variáveis
-        std::vector<std::map<std::string, Variable>> m_scopes; // Vetor com os maps de cada escopo
-        size_t num_scopes = 1;
-        int m_label_count = 0;
+        /*
+        Versões de buscar_var que também verificam o tipo da
+        variável: um array só pode ser usado com um índice, e uma
+        variável comum nunca pode ser indexada.
+        */
+        inline const Variable& buscar_escalar(const Token& token_identif) const {
+            const Variable& var = buscar_var(token_identif);
+            if (var.tamanho > 0) {
+                throw ErroCompilacao {
+                    .mensagem = "'" + token_identif.valor.value() + "' é um array e só pode ser usado com um índice.",
+                    .offset = token_identif.offset
+                };
+            }
+            return var;
+        }
+
+        inline const Variable& buscar_array(const Token& token_identif) const {
+            const Variable& var = buscar_var(token_identif);
+            if (var.tamanho == 0) {
+                throw ErroCompilacao {
+                    .mensagem = "'" + token_identif.valor.value() + "' não é um array.",
+                    .offset = token_identif.offset
+                };
+            }
+            return var;
+        }
+
+        /*
+        Método que verifica se um identificador pode ser declarado,
+        ou seja, se ainda não existe em nenhum escopo aberto.
+        PARÂMETROS:
+        - token_identif (const Token&): token do identificador.
+        RETURNS:
+        */
+        inline void checar_novo_identif(const Token& token_identif) const {
+            for (size_t i = 0; i < m_scopes.size(); i++) {
+                if (m_scopes.at(i).contains(token_identif.valor.value())) {
+                    throw ErroCompilacao {
+                        .mensagem = "Identificador '" + token_identif.valor.value() + "' já utilizado.",
+                        .offset = token_identif.offset
+                    };
+                }
+            }
+        }
+
+        /*
+        Método que procura uma função pelo nome.
+        PARÂMETROS:
+        - token_identif (const Token&): token do nome da função.
+        RETURNS:
+        - (const InfoFuncao&): função encontrada. Caso ela não
+        exista, lança um ErroCompilacao.
+        */
+        inline const InfoFuncao& buscar_fn(const Token& token_identif) const {
+            auto it = m_funcoes.find(token_identif.valor.value());
+            if (it == m_funcoes.end()) {
+                throw ErroCompilacao {
+                    .mensagem = "Função '" + token_identif.valor.value() + "' não declarada.",
+                    .offset = token_identif.offset
+                };
+            }
+            return it->second;
+        }
+
+        /*
+        Modelo de custo do inliner: uma chamada é expandida no local
+        quando o corpo da função é pequeno (o custo da chamada, do
+        prólogo e do epílogo é comparável ao do próprio corpo), a
+        função não é recursiva e ela ainda não está sendo expandida
+        (o que evita expansões infinitas com recursão indireta).
+        PARÂMETROS:
+        - info (const InfoFuncao&): função chamada.
+        RETURNS:
+        - (bool): verdadeiro caso a chamada deva ser expandida.
+        */
+        inline bool deve_inline(const InfoFuncao& info) const {
+            if (!inline_possivel(info) || m_inlines.size() >= PROFUNDIDADE_INLINE) {
+                return false;
+            }
+            return std::none_of(m_inlines.begin(), m_inlines.end(), [&info](const Inline& expansao) {
+                return expansao.funcao == info.funcao;
+            });
+        }
+
+        /*
+        Método que monta o escopo dos parâmetros de uma função.
+        PARÂMETROS:
+        - funcao (const node::Function*): nó da função.
+        - base (size_t): posição na stack do primeiro parâmetro.
+        RETURNS:
+        - (std::map<std::string, Variable>): escopo com os parâmetros.
+        */
+        inline std::map<std::string, Variable> criar_params(const node::Function* funcao, size_t base) const {
+            std::map<std::string, Variable> params;
+            for (size_t k = 0; k < funcao->params.size(); k++) {
+                const Token& param = funcao->params[k];
+                if (!params.insert({param.valor.value(), Variable {.stack_pos = base + k}}).second) {
+                    throw ErroCompilacao {
+                        .mensagem = "Parâmetro '" + param.valor.value() + "' repetido.",
+                        .offset = param.offset
+                    };
+                }
+            }
+            return params;
+        }
+
+        /*
+        Método que monta o operando de memória de uma variável,
+        relativo ao topo atual da stack.
+        PARÂMETROS:
+        - var (const Variable&): variável.
+        RETURNS:
+        - (std::string): operando no formato "QWORD [rsp + N]".
+        */
+        inline std::string endereco_var(const Variable& var) const {
+            std::stringstream offset;
+            offset << "QWORD [rsp + " << (m_stack_size - var.stack_pos - 1) * 8 << "]"; // stack e registrador %rsp crescem pra baixo.
+            return offset.str();
+        }
+
+        /*
+        Método que monta o operando de memória de um elemento de
+        array, relativo ao topo atual da stack. O elemento 0 fica na
+        posição mais alta do array na stack, ou seja, no menor endereço.
+        PARÂMETROS:
+        - var (const Variable&): array.
+        - reg (const std::string&): registrador com o índice.
+        RETURNS:
+        - (std::string): operando no formato "[rsp + reg*8 + N]", sem
+        o tamanho, que depende da instrução (escalar ou vetorial).
+        */
+        inline std::string endereco_elemento(const Variable& var, const std::string& reg) const {
+            std::stringstream offset;
+            offset << "[rsp + " << reg << "*8 + " << (m_stack_size - var.stack_pos - var.tamanho) * 8 << "]";
+            return offset.str();
+        }
+
+        /*
+        Indica se a execução nunca passa do fim de uma lista de
+        statements: o último é um 'exit' ou um 'return', ou um escopo
+        '{ }' que também termina. Com o código inalcançável já
+        removido pelo Otimizador, é a mesma análise feita por ele
+        (checar Otimizador::resolver_lista).
+        PARÂMETROS:
+        - statmts (const std::vector<node::Statmt*>&): statements
+        de um escopo.
+        RETURNS:
+        - (bool): verdadeiro caso o fim da lista seja inalcançável.
+        */
+        static inline bool termina(const std::vector<node::Statmt*>& statmts) {
+            const std::vector<node::Statmt*>* lista = &statmts;
+            while (!lista->empty()) {
+                const node::Statmt* ultimo = lista->back();
+                if (std::holds_alternative<node::StatmtExit*>(ultimo->variant_statmt) || std::holds_alternative<node::StatmtReturn*>(ultimo->variant_statmt)) {
+                    return true;
+                }
+                auto scope = std::get_if<node::Scope*>(&ultimo->variant_statmt);
+                if (scope == nullptr) {
+                    return false;
+                }
+                lista = &(*scope)->statmts_scope;
+            }
+            return false;
+        }
+
+        /*
+        Métodos auxiliares das comparações: se o token é uma
+        comparação, o sufixo da instrução condicional (setcc/jcc)
+        correspondente, a comparação com os lados trocados (a < b
+        equivale a b > a) e a comparação inversa (usada para saltar
+        quando a condição é falsa).
+        */
+        static inline bool eh_comparacao(TipoToken tipo) {
+            return info_operador(tipo).has_value() && info_operador(tipo)->classe == ClasseOp::comparacao;
+        }
+
+        static inline const char* sufixo_cond(TipoToken tipo) {
+            switch (tipo) {
+                case TipoToken::maior:
+                    return "g";
+                case TipoToken::menor:
+                    return "l";
+                case TipoToken::maior_igual:
+                    return "ge";
+                case TipoToken::menor_igual:
+                    return "le";
+                default:
+                    return "nz";
+            }
+        }
+
+        static inline TipoToken espelhar_comparacao(TipoToken tipo) {
+            switch (tipo) {
+                case TipoToken::maior:
+                    return TipoToken::menor;
+                case TipoToken::menor:
+                    return TipoToken::maior;
+                case TipoToken::maior_igual:
+                    return TipoToken::menor_igual;
+                default:
+                    return TipoToken::maior_igual;
+            }
+        }
+
+        static inline TipoToken inverter_comparacao(TipoToken tipo) {
+            switch (tipo) {
+                case TipoToken::maior:
+                    return TipoToken::menor_igual;
+                case TipoToken::menor:
+                    return TipoToken::maior_igual;
+                case TipoToken::maior_igual:
+                    return TipoToken::menor;
+                default:
+                    return TipoToken::maior;
+            }
+        }
+
+        /*
+        Método que entrega o conteúdo acumulado em m_out para a
+        saída (SaidaAsm), caso exista uma e o conteúdo tenha pelo
+        menos 'minimo' bytes. Com isso, quem consome o assembly
+        pode trabalhar enquanto o resto do programa é gerado.
+        PARÂMETROS:
+        - minimo (std::streamoff): tamanho mínimo para que o chunk
+        seja entregue. Com 0, entrega tudo que estiver pendente.
+        RETURNS:
+        */
+        inline void descarregar(std::streamoff minimo) {
+            if (!m_saida || m_out.tellp() < minimo || m_out.tellp() == 0) {
+                return;
+            }
+            m_saida(m_out.view());
+            m_out.str("");
+        }
 
         /*
         Método que escreve o código para o "push" do valor
-        guardado por um registrador para a stack. No final, 
+        guardado por um registrador para a stack. No final,
         incrementa 1 no valor de m_stack_size.
         PARÂMETROS:
         - reg (const std::string&): string que contêm o nome
@@ -371,7 +2133,7 @@ class Generator {
         /*
         Função que representa o início de um escopo. Na prática,
         apenas salva o número de variáveis do escopo antigo, para
-        ter um ponto de "checkpoint" para quando o escopo novo 
+        ter um ponto de "checkpoint" para quando o escopo novo
         for finalizado.
         PARÂMETROS:
         RETURNS:
@@ -384,30 +2146,40 @@ class Generator {
 
         /*
         Função que encerra o escopo atual. Assim, remove as
-        variáveis implementadas nele e atualiza o valor do 
+        variáveis implementadas nele e atualiza o valor do
         ponteiro da stack para "voltar" ao fim do escopo
-        anterior, de modo a ignorar o que foi adicionado no 
+        anterior, de modo a ignorar o que foi adicionado no
         escopo destruído e permitir sobrescrita.
         PARÂMETROS:
+        - alcancavel (bool): a execução pode chegar ao fim do
+        escopo. Caso contrário, só a contagem da stack é
+        atualizada, sem gerar código.
         RETURNS:
         */
-        inline void end_scope() {
-            size_t num_pops = m_scopes.back().size(); //Número de variáveis adicionadas no escopo
-            m_out << "    add rsp, " << num_pops * 8 << "\n";
+        inline void end_scope(bool alcancavel = true) {
+            size_t num_pops = 0; //Número de posições da stack ocupadas pelas variáveis do escopo
+            for (const auto& [nome, var] : m_scopes.back()) {
+                num_pops += std::max<size_t>(var.tamanho, 1);
+            }
+            if (num_pops > 0 && alcancavel) {
+                m_out << "    add rsp, " << num_pops * 8 << "\n";
+            }
             m_stack_size -= num_pops;
             m_scopes.pop_back();
             num_scopes--;
         }
 
         /*
-        Método que sinaliza no arquivo em assembly o local 
-        da label para a implementação de 'ifs'.
+        Método que sinaliza no arquivo em assembly o local
+        da label para a implementação de 'ifs'. Dentro de uma
+        função, as labels recebem o nome da função como prefixo,
+        e a contagem recomeça em cada função.
         PARÂMETROS:
         RETURNS:
         - (std::string): string que contêm o número da label
         nova.
         */
         inline std::string create_label() {
-            return "label" + std::to_string(m_label_count++);
+            return m_prefixo_label + "label" + std::to_string(m_label_count++);
         }
-};
\ No newline at end of file
+};
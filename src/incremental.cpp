@@ -0,0 +1,574 @@
+#include <algorithm>
+#include <optional>
+#include <set>
+#include <unordered_map>
+
+#include "./incremental.hpp"
+#include "./tokenization.hpp"
+#include "./parser.hpp"
+#include "./gerador.hpp"
+#include "./diagnostico.hpp"
+#include "./perfil.hpp"
+#include "./trace.hpp"
+
+
+namespace mlc {
+    static constexpr size_t TAMANHO_BLOCO = 64 * 1024; // Assembly de cada bloco, em bytes; blocos com o dobro disso são divididos
+    static constexpr uint64_t ID_SUPORTE = 0; // Bloco com '_start', a saída do programa e as rotinas de suporte
+    static constexpr size_t LIXO_MINIMO = 1024 * 1024; // Bytes reparseados antes que a arena seja recomeçada (checar Estado::lixo)
+
+    /*
+    Label de entrada do bloco 'id' (ou do fim de '_start', no bloco de suporte).
+    */
+    static std::string label_bloco(uint64_t id) {
+        return id == ID_SUPORTE ? "mlc_fim" : "mlc_bloco" + std::to_string(id);
+    }
+
+    /*
+    Item do nível mais externo do programa (checar incremental.hpp).
+    - inicio, fim (uint32_t): bytes [inicio, fim) do código atual,
+    do primeiro ao último token do item.
+    - offset_ast (uint32_t): valor de 'inicio' quando o item foi
+    parseado (os offsets dos tokens na AST são dessa versão).
+    - statmt, funcao: nó do item (só um deles não é nulo).
+    - info: custo da função para o inliner.
+    - hash_texto (uint64_t): hash do texto de uma função, que entra
+    na assinatura do programa quando ela pode ser expandida no local.
+    - serial (uint64_t): identifica a unidade nas labels.
+    - bloco (uint64_t): bloco em que a unidade é montada.
+    - contexto (uint64_t): hash do contexto com que 'codigo' foi gerado.
+    */
+    struct Unidade {
+        uint32_t inicio;
+        uint32_t fim;
+        uint32_t offset_ast;
+        const node::Statmt* statmt = nullptr;
+        const node::Function* funcao = nullptr;
+        std::optional<Generator::InfoFuncao> info = std::nullopt;
+        bool usa_print = false;
+        uint64_t hash_texto = 0;
+        uint64_t serial = 0;
+        uint64_t bloco = ID_SUPORTE;
+        bool gerada = false;
+        uint64_t contexto = 0;
+        Generator::CodigoUnidade codigo {};
+    };
+
+    /*
+    Unidade já existente gerada de novo porque o seu contexto mudou.
+    O código só substitui o antigo quando a atualização inteira dá certo.
+    */
+    struct Regerada {
+        size_t indice; // na sequência da atualização (checar Trecho)
+        uint64_t contexto;
+        Generator::CodigoUnidade codigo {};
+    };
+
+    /*
+    Resultado da tokenização e do parsing de uma nova versão: as
+    unidades [inicio, fim) da versão anterior são substituídas por
+    'novas', e as seguintes se deslocam 'delta' bytes. A sequência
+    de unidades da nova versão, usada na geração antes de ser
+    confirmada, é a das unidades [0, inicio), 'novas' e [fim, ...).
+    */
+    struct Trecho {
+        size_t inicio;
+        size_t fim;
+        std::vector<Unidade> novas;
+        int64_t delta;
+    };
+
+    /*
+    Estado guardado entre as atualizações.
+    - lixo (size_t): bytes parseados desde que a arena foi recomeçada.
+    Os nós das unidades substituídas continuam na arena; quando eles
+    passam do tamanho do programa, a arena é recomeçada e a próxima
+    atualização refaz todas as unidades, o que mantém a memória
+    proporcional ao programa com um custo amortizado pequeno.
+    - blocos: blocos das unidades, seguidos do bloco de suporte.
+    - sucessores: bloco seguinte de cada bloco, na última atualização
+    (o código de um bloco salta para o seguinte no fim de '_start').
+    */
+    struct CompilacaoIncremental::Estado {
+        Options opts;
+        ArenaAlloc alloc;
+        std::string src;
+        bool compilado = false;
+        std::vector<Unidade> unidades;
+        std::vector<Bloco> blocos;
+        std::unordered_map<uint64_t, uint64_t> sucessores;
+        uint64_t proximo_serial = 1;
+        uint64_t proximo_bloco = ID_SUPORTE + 1;
+        size_t lixo = 0;
+        EstatisticasIncrementais estatisticas;
+
+        Estado(Options opcoes)
+            : opts(std::move(opcoes)), alloc(opts.arena_bytes)
+        {}
+
+        /*
+        Descarta todas as unidades e recomeça a arena.
+        */
+        void reiniciar() {
+            unidades.clear();
+            alloc.reset();
+            src.clear();
+            compilado = false;
+            lixo = 0;
+        }
+
+        /*
+        Lê e parseia o item do nível mais externo que começa em
+        'primeiro'. Os tokens do item são lidos até o ';' ou o '}'
+        que o fecha, e o Parser deve consumir todos eles; caso
+        contrário o código tem um erro, que é relatado pela
+        compilação completa (checar atualizar).
+        PARÂMETROS:
+        - tokenizer (Tokenizer&): posicionado logo depois de 'primeiro'.
+        - primeiro (Token): primeiro token do item.
+        - novo (std::string_view): código fonte.
+        RETURNS:
+        - (Unidade): a unidade, ainda não gerada.
+        */
+        Unidade parsear_unidade(Tokenizer& tokenizer, Token primeiro, std::string_view novo) {
+            std::vector<Token> tokens {std::move(primeiro)};
+            int profundidade = 0;
+            while (true) {
+                TipoToken tipo = tokens.back().tipo;
+                if (tipo == TipoToken::chaves_abre) {
+                    profundidade++;
+                } else if (tipo == TipoToken::chaves_fecha && --profundidade <= 0) {
+                    break;
+                } else if (tipo == TipoToken::ponto_virgula && profundidade == 0) {
+                    break;
+                }
+                std::optional<Token> token = tokenizer.proximo();
+                if (!token.has_value()) {
+                    break;
+                }
+                tokens.push_back(std::move(token.value()));
+            }
+            Unidade unidade {.inicio = tokens.front().offset, .fim = tokenizer.posicao(), .offset_ast = tokens.front().offset};
+            size_t num_tokens = tokens.size();
+            Parser parser(std::move(tokens), alloc);
+            node::Program item;
+            parser.parse_item(item);
+            if (parser.posicao() != num_tokens) {
+                throw ErroCompilacao {.mensagem = "Declaração inválida.", .offset = unidade.fim};
+            }
+            unidade.usa_print = item.usa_print;
+            unidade.serial = proximo_serial++;
+            if (!item.funcoes.empty()) {
+                unidade.funcao = item.funcoes.front();
+                unidade.info = Generator::analisar_fn(unidade.funcao);
+                unidade.hash_texto = hash_fonte(novo.substr(unidade.inicio, unidade.fim - unidade.inicio));
+            } else {
+                unidade.statmt = item.statmts.front();
+            }
+            return unidade;
+        }
+
+        /*
+        Compara 'novo' com a versão anterior e tokeniza e parseia de
+        novo só o trecho alterado. A tokenização começa no fim da
+        última unidade que termina antes da alteração (o Tokenizer
+        não guarda estado entre tokens) e para no primeiro item que
+        começa, depois da alteração, no mesmo lugar (deslocado) em
+        que começava uma unidade da versão anterior: dali em diante,
+        o código é o mesmo, e portanto os tokens e a AST também.
+        PARÂMETROS:
+        - novo (std::string_view): nova versão do código fonte.
+        RETURNS:
+        - (Trecho): unidades substituídas e as que as substituem.
+        */
+        Trecho reparsear(std::string_view novo) {
+            MLC_TRACE_SCOPE("reparsear");
+            size_t tamanho_velho = src.size();
+            size_t tamanho_novo = novo.size();
+            size_t limite = std::min(tamanho_velho, tamanho_novo);
+            size_t prefixo = static_cast<size_t>(std::mismatch(src.begin(), src.begin() + limite, novo.begin()).first - src.begin());
+            size_t sufixo = 0;
+            while (sufixo < limite - prefixo && src[tamanho_velho - 1 - sufixo] == novo[tamanho_novo - 1 - sufixo]) {
+                sufixo++;
+            }
+            Trecho trecho {.inicio = 0, .fim = 0, .novas = {}, .delta = static_cast<int64_t>(tamanho_novo) - static_cast<int64_t>(tamanho_velho)};
+            // a primeira unidade afetada é a primeira que termina depois do início da alteração (ou logo nele, já que o último token pode crescer)
+            trecho.inicio = static_cast<size_t>(std::partition_point(unidades.begin(), unidades.end(), [prefixo](const Unidade& unidade) {
+                return unidade.fim < prefixo;
+            }) - unidades.begin());
+            uint32_t inicio_leitura = trecho.inicio > 0 ? unidades[trecho.inicio - 1].fim : 0;
+            Tokenizer tokenizer(novo);
+            tokenizer.posicionar(inicio_leitura);
+            size_t k = trecho.inicio;
+            trecho.fim = unidades.size();
+            while (std::optional<Token> primeiro = tokenizer.proximo()) {
+                int64_t offset = primeiro->offset;
+                if (offset >= static_cast<int64_t>(tamanho_novo - sufixo)) {
+                    while (k < unidades.size() && unidades[k].inicio + trecho.delta < offset) {
+                        k++;
+                    }
+                    if (k < unidades.size() && unidades[k].inicio + trecho.delta == offset && unidades[k].inicio >= tamanho_velho - sufixo) {
+                        trecho.fim = k;
+                        estatisticas.bytes_tokenizados = static_cast<size_t>(offset) - inicio_leitura;
+                        return trecho;
+                    }
+                }
+                trecho.novas.push_back(parsear_unidade(tokenizer, std::move(primeiro.value()), novo));
+            }
+            estatisticas.bytes_tokenizados = tamanho_novo - inicio_leitura;
+            return trecho;
+        }
+
+        /*
+        Gera o código das unidades novas e das que tiveram o contexto
+        alterado. O contexto de um statement é um hash encadeado: o da
+        unidade anterior combinado com o efeito dela ('declaradas' e
+        'stack_size'), a partir da assinatura do programa (a tabela de
+        funções, o corpo das que podem ser expandidas no local, e se o
+        programa usa 'print'). O Generator só recebe as variáveis de
+        '_start' quando a primeira unidade precisa ser gerada.
+        PARÂMETROS:
+        - trecho (Trecho&): recebe o código das unidades novas.
+        RETURNS:
+        - (std::vector<Regerada>): código das unidades já existentes
+        geradas de novo.
+        */
+        std::vector<Regerada> gerar(Trecho& trecho) {
+            MLC_TRACE_SCOPE("generate");
+            size_t total = trecho.inicio + trecho.novas.size() + (unidades.size() - trecho.fim);
+            auto unidade = [&](size_t v) -> Unidade& {
+                if (v < trecho.inicio) {
+                    return unidades[v];
+                }
+                v -= trecho.inicio;
+                return v < trecho.novas.size() ? trecho.novas[v] : unidades[trecho.fim + v - trecho.novas.size()];
+            };
+            node::Program programa;
+            for (size_t v = 0; v < total; v++) {
+                programa.usa_print = programa.usa_print || unidade(v).usa_print;
+            }
+            Generator generator(programa, {}, opts.avx2);
+            uint64_t assinatura = misturar_hash(BASE_HASH, programa.usa_print);
+            for (size_t v = 0; v < total; v++) {
+                const Unidade& atual = unidade(v);
+                if (atual.funcao == nullptr) {
+                    continue;
+                }
+                generator.registrar_fn(atual.info.value());
+                assinatura = misturar_hash(assinatura, hash_fonte(atual.funcao->token_identif.valor.value()));
+                assinatura = misturar_hash(assinatura, atual.funcao->params.size());
+                assinatura = misturar_hash(assinatura, Generator::inline_possivel(atual.info.value()) ? atual.hash_texto : 0);
+            }
+
+            std::vector<Regerada> regeradas;
+            uint64_t contexto = assinatura;
+            size_t aplicadas = 0; // unidades cujo efeito já está no contexto do Generator
+            for (size_t v = 0; v < total; v++) {
+                const Unidade& atual = unidade(v);
+                if (atual.funcao != nullptr) {
+                    if (!atual.gerada || atual.contexto != assinatura) {
+                        regeradas.push_back({.indice = v, .contexto = assinatura, .codigo = generator.generate_unidade(atual.funcao)});
+                    }
+                    continue;
+                }
+                const Generator::CodigoUnidade* codigo = &atual.codigo;
+                if (!atual.gerada || atual.contexto != contexto) {
+                    // as unidades entre a última gerada e esta foram reaproveitadas, então o seu efeito guardado vale
+                    for (; aplicadas < v; aplicadas++) {
+                        const Unidade& anterior = unidade(aplicadas);
+                        if (anterior.statmt != nullptr) {
+                            generator.avancar_contexto(anterior.codigo.declaradas, anterior.codigo.stack_size);
+                        }
+                    }
+                    regeradas.push_back({.indice = v, .contexto = contexto,
+                        .codigo = generator.generate_unidade(atual.statmt, "u" + std::to_string(atual.serial) + ".")});
+                    codigo = &regeradas.back().codigo;
+                    aplicadas = v + 1;
+                }
+                contexto = misturar_hash(contexto, codigo->stack_size);
+                for (const auto& [nome, var] : codigo->declaradas) {
+                    contexto = misturar_hash(misturar_hash(misturar_hash(contexto, hash_fonte(nome)), var.stack_pos), var.tamanho);
+                }
+            }
+            estatisticas.unidades_geradas = regeradas.size();
+
+            // as unidades novas recebem o seu código; as já existentes só o recebem em confirmar
+            size_t fim_novas = trecho.inicio + trecho.novas.size();
+            std::erase_if(regeradas, [&](Regerada& regerada) {
+                if (regerada.indice < trecho.inicio || regerada.indice >= fim_novas) {
+                    return false;
+                }
+                Unidade& nova = trecho.novas[regerada.indice - trecho.inicio];
+                nova.codigo = std::move(regerada.codigo);
+                nova.contexto = regerada.contexto;
+                nova.gerada = true;
+                return true;
+            });
+            return regeradas;
+        }
+
+        /*
+        Monta o código de um bloco: as unidades [inicio, fim), com os
+        statements (o trecho de '_start' do bloco, que termina saltando
+        para o bloco seguinte) antes das funções. O cabeçalho declara
+        como global o que o bloco define e como extern o que ele usa
+        de outros blocos.
+        PARÂMETROS:
+        - inicio, fim (size_t): unidades do bloco.
+        - sucessor (uint64_t): bloco seguinte.
+        - usa_print (bool): o programa usa 'print'.
+        RETURNS:
+        - (Bloco): o bloco.
+        */
+        Bloco montar_bloco(size_t inicio, size_t fim, uint64_t sucessor, bool usa_print) const {
+            uint64_t id = unidades[inicio].bloco;
+            std::string cabecalho = "global " + label_bloco(id) + "\n";
+            std::string codigo = label_bloco(id) + ":\n";
+            std::string funcoes;
+            std::set<std::string> chamadas;
+            std::set<std::string> definidas;
+            bool usa_erro_limites = false;
+            for (size_t j = inicio; j < fim; j++) {
+                const Unidade& unidade = unidades[j];
+                chamadas.insert(unidade.codigo.chamadas.begin(), unidade.codigo.chamadas.end());
+                usa_erro_limites = usa_erro_limites || unidade.codigo.usa_erro_limites;
+                if (unidade.funcao != nullptr) {
+                    const std::string& nome = unidade.funcao->token_identif.valor.value();
+                    definidas.insert(nome);
+                    cabecalho += "global fn_" + nome + "\n";
+                    funcoes += unidade.codigo.codigo;
+                } else {
+                    codigo += unidade.codigo.codigo;
+                }
+            }
+            for (const std::string& nome : chamadas) {
+                if (!definidas.contains(nome)) {
+                    cabecalho += "extern fn_" + nome + "\n";
+                }
+            }
+            for (const std::string& simbolo : Generator::simbolos_suporte(usa_print, usa_erro_limites)) {
+                cabecalho += "extern " + simbolo + "\n";
+            }
+            cabecalho += "extern " + label_bloco(sucessor) + "\n";
+            codigo += "    jmp " + label_bloco(sucessor) + "\n";
+            return Bloco {.id = id, .assembly = cabecalho + codigo + funcoes, .alterado = true, .cabecalho = cabecalho.size()};
+        }
+
+        /*
+        Monta o bloco de suporte: '_start', que salta para o primeiro
+        bloco, o fim de '_start' (para onde o último bloco salta) e as
+        rotinas de suporte usadas pelas unidades.
+        */
+        Bloco montar_suporte(uint64_t primeiro, bool usa_print, bool usa_erro_limites) const {
+            node::Program programa;
+            programa.usa_print = usa_print;
+            Generator generator(programa, {}, opts.avx2);
+            std::string cabecalho = "global _start\nglobal " + label_bloco(ID_SUPORTE) + "\n";
+            for (const std::string& simbolo : Generator::simbolos_suporte(usa_print, usa_erro_limites)) {
+                cabecalho += "global " + simbolo + "\n";
+            }
+            if (primeiro != ID_SUPORTE) {
+                cabecalho += "extern " + label_bloco(primeiro) + "\n";
+            }
+            std::string codigo = "_start:\n    jmp " + label_bloco(primeiro) + "\n" + label_bloco(ID_SUPORTE) + ":\n";
+            codigo += generator.generate_saida(usa_erro_limites);
+            return Bloco {.id = ID_SUPORTE, .assembly = cabecalho + codigo, .alterado = true, .cabecalho = cabecalho.size()};
+        }
+
+        /*
+        Refaz a lista de blocos depois de uma atualização. Cada bloco
+        é uma sequência contígua de unidades com o mesmo 'bloco'. Só
+        são montados de novo os blocos em 'alterados' e os que passaram
+        a saltar para outro bloco; os demais mantêm o código anterior.
+        Blocos alterados com mais que o dobro de TAMANHO_BLOCO são
+        divididos.
+        PARÂMETROS:
+        - alterados (std::set<uint64_t>&): blocos cujas unidades mudaram.
+        RETURNS:
+        */
+        void refazer_blocos(std::set<uint64_t>& alterados) {
+            MLC_TRACE_SCOPE("blocos");
+            std::vector<std::pair<size_t, size_t>> sequencias; // unidades [inicio, fim) de cada bloco
+            bool usa_print = false;
+            bool usa_erro_limites = false;
+            for (size_t inicio = 0; inicio < unidades.size();) {
+                uint64_t id = unidades[inicio].bloco;
+                size_t fim = inicio;
+                size_t tamanho = 0;
+                for (; fim < unidades.size() && unidades[fim].bloco == id; fim++) {
+                    tamanho += unidades[fim].codigo.codigo.size();
+                    usa_print = usa_print || unidades[fim].usa_print;
+                    usa_erro_limites = usa_erro_limites || unidades[fim].codigo.usa_erro_limites;
+                }
+                if (alterados.contains(id) && tamanho > 2 * TAMANHO_BLOCO) {
+                    size_t acumulado = 0;
+                    size_t inicio_parte = inicio;
+                    for (size_t j = inicio; j < fim; j++) {
+                        if (acumulado >= TAMANHO_BLOCO) {
+                            sequencias.emplace_back(inicio_parte, j);
+                            inicio_parte = j;
+                            id = proximo_bloco++;
+                            alterados.insert(id);
+                            acumulado = 0;
+                        }
+                        unidades[j].bloco = id;
+                        acumulado += unidades[j].codigo.codigo.size();
+                    }
+                    sequencias.emplace_back(inicio_parte, fim);
+                } else {
+                    sequencias.emplace_back(inicio, fim);
+                }
+                inicio = fim;
+            }
+
+            std::unordered_map<uint64_t, Bloco*> anteriores;
+            for (Bloco& bloco : blocos) {
+                anteriores[bloco.id] = &bloco;
+            }
+            std::vector<Bloco> novos;
+            std::unordered_map<uint64_t, uint64_t> novos_sucessores;
+            for (size_t s = 0; s < sequencias.size(); s++) {
+                auto [inicio, fim] = sequencias[s];
+                uint64_t id = unidades[inicio].bloco;
+                uint64_t sucessor = s + 1 < sequencias.size() ? unidades[sequencias[s + 1].first].bloco : ID_SUPORTE;
+                novos_sucessores[id] = sucessor;
+                auto anterior = anteriores.find(id);
+                auto sucessor_anterior = sucessores.find(id);
+                if (anterior == anteriores.end() || alterados.contains(id) || sucessor_anterior == sucessores.end() || sucessor_anterior->second != sucessor) {
+                    novos.push_back(montar_bloco(inicio, fim, sucessor, usa_print));
+                } else {
+                    novos.push_back(std::move(*anterior->second));
+                }
+            }
+            Bloco suporte = montar_suporte(sequencias.empty() ? ID_SUPORTE : unidades.front().bloco, usa_print, usa_erro_limites);
+            auto anterior = anteriores.find(ID_SUPORTE);
+            suporte.alterado = anterior == anteriores.end() || anterior->second->assembly != suporte.assembly;
+            novos.push_back(std::move(suporte));
+            blocos = std::move(novos);
+            sucessores = std::move(novos_sucessores);
+            for (const Bloco& bloco : blocos) {
+                estatisticas.blocos_alterados += bloco.alterado;
+            }
+        }
+
+        /*
+        Confirma uma atualização que deu certo: as unidades do trecho
+        são substituídas, as seguintes são deslocadas e as unidades
+        geradas de novo recebem o seu código. As unidades novas ficam
+        no bloco da unidade anterior a elas (ou da seguinte).
+        PARÂMETROS:
+        - trecho (Trecho&): resultado de reparsear, já gerado.
+        - regeradas (std::vector<Regerada>&): resultado de gerar.
+        - novo (std::string_view): nova versão do código fonte.
+        RETURNS:
+        */
+        void confirmar(Trecho& trecho, std::vector<Regerada>& regeradas, std::string_view novo) {
+            std::set<uint64_t> alterados;
+            size_t fim_novas = trecho.inicio + trecho.novas.size();
+            for (Regerada& regerada : regeradas) {
+                Unidade& unidade = regerada.indice < trecho.inicio ? unidades[regerada.indice] : unidades[trecho.fim + regerada.indice - fim_novas];
+                unidade.codigo = std::move(regerada.codigo);
+                unidade.contexto = regerada.contexto;
+                alterados.insert(unidade.bloco);
+            }
+            for (size_t j = trecho.inicio; j < trecho.fim; j++) {
+                alterados.insert(unidades[j].bloco);
+            }
+            if (!trecho.novas.empty()) {
+                uint64_t bloco = trecho.inicio > 0 ? unidades[trecho.inicio - 1].bloco
+                    : trecho.fim < unidades.size() ? unidades[trecho.fim].bloco : proximo_bloco++;
+                for (Unidade& nova : trecho.novas) {
+                    nova.bloco = bloco;
+                }
+                alterados.insert(bloco);
+            }
+            for (size_t j = trecho.fim; j < unidades.size(); j++) {
+                unidades[j].inicio = static_cast<uint32_t>(unidades[j].inicio + trecho.delta);
+                unidades[j].fim = static_cast<uint32_t>(unidades[j].fim + trecho.delta);
+            }
+            unidades.erase(unidades.begin() + static_cast<std::ptrdiff_t>(trecho.inicio), unidades.begin() + static_cast<std::ptrdiff_t>(trecho.fim));
+            unidades.insert(unidades.begin() + static_cast<std::ptrdiff_t>(trecho.inicio),
+                std::make_move_iterator(trecho.novas.begin()), std::make_move_iterator(trecho.novas.end()));
+            src.assign(novo);
+            compilado = true;
+            refazer_blocos(alterados);
+        }
+    };
+
+    CompilacaoIncremental::CompilacaoIncremental(Options opts)
+        : m_estado(std::make_unique<Estado>(std::move(opts)))
+    {}
+
+    CompilacaoIncremental::~CompilacaoIncremental() = default;
+
+    Result CompilacaoIncremental::atualizar(std::string_view src) {
+        MLC_TRACE_SCOPE("atualizar");
+        Estado& estado = *m_estado;
+        estado.estatisticas = {};
+        for (Bloco& bloco : estado.blocos) {
+            bloco.alterado = false;
+        }
+        if (estado.compilado && src == estado.src) {
+            return {};
+        }
+        if (estado.lixo > std::max(LIXO_MINIMO, src.size())) {
+            estado.reiniciar();
+        }
+        for (bool repetir = estado.compilado; ; repetir = false) {
+            estado.estatisticas.completa = !estado.compilado;
+            try {
+                Trecho trecho = estado.reparsear(src);
+                estado.estatisticas.unidades_parseadas = trecho.novas.size();
+                estado.lixo += estado.estatisticas.bytes_tokenizados;
+                std::vector<Regerada> regeradas = estado.gerar(trecho);
+                estado.confirmar(trecho, regeradas, src);
+                return {};
+            } catch (ErroCompilacao& erro) {
+                /*
+                Os erros são relatados pela compilação completa, com a
+                mesma mensagem e posição (e na mesma ordem) de sempre. Se
+                ela não encontrar erro, o estado guardado não corresponde
+                ao código, e todas as unidades são refeitas uma vez.
+                */
+                Options completa = estado.opts;
+                completa.otimizar = false;
+                completa.gerar_perfil.clear();
+                completa.perfil.reset();
+                completa.prelude.reset();
+                Compiler compiler(completa);
+                Result result = compiler.compile(src);
+                if (result.ok() && repetir) {
+                    estado.reiniciar();
+                    continue;
+                }
+                if (result.ok()) {
+                    Posicao posicao = IndiceLinhas(src).localizar(erro.offset);
+                    result.erro = std::move(erro);
+                    result.erro->linha = posicao.linha;
+                    result.erro->coluna = posicao.coluna;
+                }
+                result.assembly.clear();
+                return result;
+            } catch (std::bad_alloc&) {
+                estado.reiniciar();
+                return Result {.assembly = {}, .ast = {}, .erro = ErroCompilacao {.mensagem = "Memória insuficiente para a AST.", .offset = 0, .linha = 1, .coluna = 1}};
+            }
+        }
+    }
+
+    const std::vector<Bloco>& CompilacaoIncremental::blocos() const {
+        return m_estado->blocos;
+    }
+
+    std::string CompilacaoIncremental::assembly() const {
+        std::string assembly = "global _start\n";
+        for (const Bloco& bloco : m_estado->blocos) {
+            assembly.append(bloco.assembly, bloco.cabecalho);
+        }
+        return assembly;
+    }
+
+    const EstatisticasIncrementais& CompilacaoIncremental::estatisticas() const {
+        return m_estado->estatisticas;
+    }
+}
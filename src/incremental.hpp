@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "./compilador.hpp"
+
+/*
+Compilação incremental, usada pelo modo --watch do compilador.
+O programa é dividido em unidades, os itens do nível mais externo
+(cada statement de '_start' e cada função), e cada nova versão do
+código fonte é comparada com a anterior:
+- só o trecho alterado é tokenizado de novo, a partir do fim da
+última unidade intacta, até que os tokens voltem a coincidir com
+os da versão anterior no início de uma unidade;
+- só as unidades desse trecho são parseadas de novo;
+- uma unidade só é gerada de novo se foi parseada de novo ou se o
+seu contexto mudou (checar Generator::CodigoUnidade): como cada
+unidade reaproveitada guarda o efeito que teve nas variáveis e na
+stack de '_start', a geração para na primeira unidade depois do
+trecho alterado cujo contexto continua igual.
+O assembly é entregue em blocos de unidades vizinhas, cada um
+montado num objeto próprio (checar MontadorIncremental), então
+só os blocos alterados passam pelo nasm. O programa gerado é o
+mesmo de uma compilação com --sem-otimizacao, já que as otimizações
+da AST dependem do programa inteiro; o perfil de execução e o
+prelúdio também não são usados.
+*/
+namespace mlc {
+    /*
+    Bloco do programa gerado por unidades, montado num objeto próprio.
+    - id (uint64_t): identificador do bloco, estável enquanto ele existir.
+    - assembly (std::string): código do bloco, com as declarações
+    global/extern dos símbolos que ele define e usa.
+    - alterado (bool): o código mudou na última atualização.
+    - cabecalho (size_t): bytes de declarações global/extern no início
+    de 'assembly', omitidas quando os blocos são juntados num só arquivo.
+    */
+    struct Bloco {
+        uint64_t id;
+        std::string assembly;
+        bool alterado = true;
+        size_t cabecalho = 0;
+    };
+
+    /*
+    Trabalho feito pela última atualização.
+    */
+    struct EstatisticasIncrementais {
+        size_t bytes_tokenizados = 0;
+        size_t unidades_parseadas = 0;
+        size_t unidades_geradas = 0;
+        size_t blocos_alterados = 0;
+        bool completa = false; // todas as unidades foram refeitas
+    };
+
+    class CompilacaoIncremental {
+        public:
+            explicit CompilacaoIncremental(Options opts = {});
+            ~CompilacaoIncremental();
+
+            /*
+            Compila a nova versão 'src' do programa, reaproveitando o
+            que não mudou desde a última atualização bem sucedida. Em
+            caso de erro, a mensagem e a posição são as mesmas de uma
+            compilação completa, e o estado continua o da última versão
+            compilada, com a qual a próxima atualização é comparada.
+            Result::assembly fica vazio (checar blocos e assembly).
+            */
+            Result atualizar(std::string_view src);
+
+            /*
+            Blocos do programa, na ordem em que devem ser ligados.
+            */
+            const std::vector<Bloco>& blocos() const;
+
+            /*
+            Programa inteiro, com os blocos concatenados.
+            */
+            std::string assembly() const;
+
+            const EstatisticasIncrementais& estatisticas() const;
+
+            CompilacaoIncremental(const CompilacaoIncremental&) = delete;
+            CompilacaoIncremental& operator=(const CompilacaoIncremental&) = delete;
+
+        private:
+            struct Estado;
+            std::unique_ptr<Estado> m_estado;
+    };
+}
@@ -1,49 +1,294 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
-#include <optional>
+#include <string>
 #include <vector>
+#include <chrono>
+#include <filesystem>
 
-#include "./tokenization.hpp"
-#include "./parser.hpp"
-#include "./gerador.hpp"
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
 
+#include "./ast_binaria.hpp"
+#include "./compilador.hpp"
+#include "./fila_es.hpp"
+#include "./incremental.hpp"
+#include "./montador.hpp"
+#include "./perfil.hpp"
+#include "./trace.hpp"
+
+
+static constexpr size_t LEITURAS_ADIANTADAS = 32; // Entradas lidas à frente da que está sendo compilada
+static constexpr size_t LOTE_ESCRITAS = 16; // Saídas (-S) acumuladas antes de cada envio
+
+/*
+Escreve o trace (caso o compilador tenha sido configurado com
+-DMLC_TRACE=ON) no arquivo pedido com --trace.
+*/
+static void exportar_trace(const char* arquivo_trace) {
+    if (arquivo_trace == nullptr) {
+        return;
+    }
+#ifdef MLC_TRACE
+    std::fstream fs_trace (arquivo_trace, std::ios::out);
+    trace::exportar_chrome(fs_trace);
+#else
+    std::cerr << "Aviso: --trace ignorado; configure o projeto com -DMLC_TRACE=ON." << std::endl;
+#endif
+}
+
+/*
+Nome do arquivo gerado para a entrada 'arquivo_entrada'. Com uma
+única entrada, o executável se chama "out" (ou "out.asm" com -S,
+"out.mlast" com --emit-ast). Com várias, cada saída fica ao lado
+da sua entrada, com o mesmo nome sem a extensão .ml ou .mlast
+(ou com 'extensao' no lugar dela).
+*/
+static std::string nome_saida(std::string_view arquivo_entrada, bool varias_entradas, std::string_view extensao) {
+    std::string nome = "out";
+    if (varias_entradas) {
+        nome = arquivo_entrada;
+        if (nome.ends_with(".ml")) {
+            nome.resize(nome.size() - 3);
+        } else if (nome.ends_with(".mlast")) {
+            nome.resize(nome.size() - 6);
+        }
+    }
+    return nome.append(extensao);
+}
+
+/*
+Entradas terminadas em .mlast são ASTs binárias (checar ast_binaria.hpp):
+são mapeadas em memória, e não lidas pela FilaES.
+*/
+static bool eh_ast_binaria(std::string_view arquivo_entrada) {
+    return arquivo_entrada.ends_with(".mlast");
+}
+
+/*
+Espera até que 'nome' seja gravado no diretório observado por
+'inotify'. Editores costumam gerar vários eventos por gravação
+(ou gravar um arquivo novo e renomeá-lo por cima do antigo, por
+isso o diretório é observado, e não o arquivo); os eventos que
+chegam logo depois do primeiro são descartados junto com ele.
+*/
+static bool esperar_gravacao(int inotify, const std::string& nome) {
+    static constexpr int ESPERA_AGRUPAMENTO_MS = 20; // Eventos seguidos em menos que isso são uma gravação só
+    alignas(inotify_event) char buffer[4096];
+    bool gravado = false;
+    while (true) {
+        pollfd pfd {.fd = inotify, .events = POLLIN, .revents = 0};
+        int prontos = poll(&pfd, 1, gravado ? ESPERA_AGRUPAMENTO_MS : -1);
+        if (prontos < 0 && errno == EINTR) {
+            continue;
+        }
+        if (prontos <= 0) {
+            return prontos == 0;
+        }
+        ssize_t lidos = read(inotify, buffer, sizeof(buffer));
+        if (lidos <= 0) {
+            return false;
+        }
+        for (ssize_t k = 0; k < lidos;) {
+            const inotify_event* evento = reinterpret_cast<const inotify_event*>(buffer + k);
+            gravado = gravado || (evento->len > 0 && nome == evento->name);
+            k += static_cast<ssize_t>(sizeof(inotify_event) + evento->len);
+        }
+    }
+}
+
+/*
+Modo --watch: compila 'arquivo_entrada' e, a cada vez que ele é
+gravado, compila de novo só o que mudou (checar incremental.hpp) e
+monta só os blocos alterados, até o processo ser interrompido.
+*/
+static int observar(const std::string& arquivo_entrada, const mlc::Options& opts, bool apenas_assembly) {
+    std::filesystem::path caminho (arquivo_entrada);
+    std::string diretorio = caminho.has_parent_path() ? caminho.parent_path().string() : ".";
+    int inotify = inotify_init1(IN_CLOEXEC);
+    if (inotify < 0 || inotify_add_watch(inotify, diretorio.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        std::cerr << diretorio << ": não foi possível observar o diretório (inotify)." << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::string saida = nome_saida(arquivo_entrada, false, apenas_assembly ? ".asm" : "");
+    mlc::CompilacaoIncremental compilacao(opts);
+    mlc::MontadorIncremental montador;
+    bool ligado = false; // o executável corresponde à última versão compilada
+    do {
+        auto inicio = std::chrono::steady_clock::now();
+        std::ifstream fs_entrada (arquivo_entrada, std::ios::binary);
+        if (!fs_entrada) {
+            std::cerr << arquivo_entrada << ": não foi possível ler o arquivo." << std::endl;
+            continue;
+        }
+        std::stringstream conteudo;
+        conteudo << fs_entrada.rdbuf();
+        mlc::Result result = compilacao.atualizar(conteudo.str());
+        if (!result.ok()) {
+            std::cerr << arquivo_entrada << ":" << result.erro->linha << ":" << result.erro->coluna << ": " << result.erro->mensagem << std::endl;
+            continue;
+        }
+        const mlc::EstatisticasIncrementais& estatisticas = compilacao.estatisticas();
+        if (apenas_assembly) {
+            std::ofstream fs_saida (saida, std::ios::binary);
+            fs_saida << compilacao.assembly();
+        } else if (!ligado || estatisticas.blocos_alterados > 0) {
+            auto erro_montagem = montador.atualizar(compilacao.blocos(), saida);
+            ligado = !erro_montagem.has_value();
+            if (erro_montagem.has_value()) {
+                std::cerr << arquivo_entrada << ": " << erro_montagem.value() << std::endl;
+                continue;
+            }
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inicio).count();
+        std::cout << saida << ": " << estatisticas.bytes_tokenizados << " bytes tokenizados, "
+            << estatisticas.unidades_parseadas << " unidade(s) parseada(s), " << estatisticas.unidades_geradas << " gerada(s), "
+            << estatisticas.blocos_alterados << " bloco(s) montado(s) em " << ms << " ms" << std::endl;
+    } while (esperar_gravacao(inotify, caminho.filename().string()));
+    close(inotify);
+    return EXIT_FAILURE;
+}
 
 int main(int argc, char* argv[]) {
-    //garantindo que o programa tenha apenas dois argumentos: argv[0] = path do arquivo em C e argv[1] = path do arquivo .ml
-    if (argc != 2) {
-        std::cerr << "Uso incorreto do compilador. O uso correto seria..." << std::endl << "compiler <input.ml>" << std::endl;
+    //lendo as opções: compiler [--trace <trace.json>] [--sem-otimizacao] [--avx2] [-S] [--watch] [--emit-ast] [--prelude <prelude.mlast>] [--profile-generate <perfil>] [--profile-use <perfil>] <input.ml|input.mlast>...
+    std::vector<std::string> arquivos_entrada;
+    const char* arquivo_trace = nullptr;
+    bool apenas_assembly = false;
+    bool emitir_ast = false;
+    bool observar_entrada = false;
+    bool uso_correto = true;
+    mlc::Options opts;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "--trace" && i + 1 < argc) {
+            arquivo_trace = argv[++i];
+        } else if (arg == "--sem-otimizacao") {
+            opts.otimizar = false;
+        } else if (arg == "--avx2") {
+            opts.avx2 = true;
+        } else if (arg == "-S") {
+            apenas_assembly = true;
+        } else if (arg == "--emit-ast") {
+            emitir_ast = true;
+        } else if (arg == "--watch") {
+            observar_entrada = true;
+        } else if (arg == "--prelude" && i + 1 < argc) {
+            auto prelude = std::make_shared<mlc::AstBinaria>();
+            auto erro_prelude = prelude->abrir(argv[++i]);
+            if (erro_prelude.has_value()) {
+                std::cerr << argv[i] << ": " << erro_prelude.value() << std::endl;
+                return EXIT_FAILURE;
+            }
+            opts.prelude = std::move(prelude);
+        } else if (arg == "--profile-generate" && i + 1 < argc) {
+            opts.gerar_perfil = argv[++i];
+        } else if (arg == "--profile-use" && i + 1 < argc) {
+            opts.perfil = mlc::ler_perfil(argv[++i]);
+            if (!opts.perfil.has_value()) {
+                std::cerr << "Não foi possível ler o perfil '" << argv[i] << "'." << std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (!arg.starts_with("-")) {
+            arquivos_entrada.emplace_back(arg);
+        } else {
+            uso_correto = false;
+            break;
+        }
+    }
+    if (arquivos_entrada.empty() || !uso_correto) {
+        std::cerr << "Uso incorreto do compilador. O uso correto seria..." << std::endl << "compiler [--trace <trace.json>] [--sem-otimizacao] [--avx2] [-S] [--watch] [--emit-ast] [--prelude <prelude.mlast>] [--profile-generate <perfil>] [--profile-use <perfil>] <input.ml|input.mlast>..." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (observar_entrada && (arquivos_entrada.size() != 1 || eh_ast_binaria(arquivos_entrada.front()) || emitir_ast
+        || opts.prelude != nullptr || !opts.gerar_perfil.empty() || opts.perfil.has_value())) {
+        std::cerr << "O modo --watch recebe um único arquivo .ml, e não pode ser usado com --emit-ast, --prelude ou --profile-*." << std::endl;
         return EXIT_FAILURE;
     }
+    if (observar_entrada) {
+        return observar(arquivos_entrada.front(), opts, apenas_assembly);
+    }
+
+    /*
+    As leituras das próximas entradas e as escritas das saídas prontas
+    passam pela FilaES em lotes, então o disco trabalha enquanto os
+    arquivos anteriores são compilados, montados e ligados.
+    */
+    mlc::FilaES fila;
+    mlc::Compiler compiler(opts);
+    size_t num_entradas = arquivos_entrada.size();
+    std::vector<size_t> leituras (num_entradas);
+    std::vector<std::pair<size_t, std::string>> escritas; // operação e nome do arquivo
+    size_t num_lidas = 0; // leituras agendadas até aqui
+    size_t num_pendentes = 0; // operações agendadas desde o último envio
+    bool sucesso = true;
+    for (size_t k = 0; k < num_entradas; k++) {
+        if (num_lidas < num_entradas && num_lidas < k + LEITURAS_ADIANTADAS / 2) {
+            for (; num_lidas < num_entradas && num_lidas < k + LEITURAS_ADIANTADAS; num_lidas++) {
+                if (!eh_ast_binaria(arquivos_entrada[num_lidas])) {
+                    leituras[num_lidas] = fila.ler(arquivos_entrada[num_lidas]);
+                }
+            }
+            fila.enviar();
+            num_pendentes = 0;
+        }
+        const std::string& arquivo_entrada = arquivos_entrada[k];
+        mlc::AstBinaria ast;
+        mlc::ResultadoES leitura;
+        if (eh_ast_binaria(arquivo_entrada)) {
+            leitura.erro = emitir_ast ? std::optional<std::string>("a entrada já é uma AST binária.") : ast.abrir(arquivo_entrada);
+        } else {
+            leitura = fila.esperar(leituras[k]);
+        }
+        if (leitura.erro.has_value()) {
+            std::cerr << arquivo_entrada << ": " << leitura.erro.value() << std::endl;
+            sucesso = false;
+            continue;
+        }
+        std::string saida = nome_saida(arquivo_entrada, num_entradas > 1, emitir_ast ? ".mlast" : apenas_assembly ? ".asm" : "");
+
+        //com -S e --emit-ast, a saída inteira é escrita pela fila; sem elas, cada chunk vai direto para o assembler
+        mlc::Montador montador;
+        mlc::Sink sink;
+        if (!apenas_assembly && !emitir_ast) {
+            sink = [&](std::string_view chunk) {
+                montador.escrever(chunk);
+            };
+        }
+        mlc::Result result = emitir_ast ? compiler.emit_ast(leitura.conteudo)
+            : eh_ast_binaria(arquivo_entrada) ? compiler.compile_ast(ast, sink)
+            : compiler.compile(leitura.conteudo, sink);
+        if (!result.ok()) {
+            std::cerr << arquivo_entrada << ":" << result.erro->linha << ":" << result.erro->coluna << ": " << result.erro->mensagem << std::endl;
+            sucesso = false;
+            continue;
+        }
+        if (apenas_assembly || emitir_ast) {
+            escritas.emplace_back(fila.escrever(saida, std::move(emitir_ast ? result.ast : result.assembly)), saida);
+            if (++num_pendentes >= LOTE_ESCRITAS) {
+                fila.enviar();
+                num_pendentes = 0;
+            }
+            continue;
+        }
+
+        //passando o assembly gerado pelo assembler e linker
+        auto erro_montagem = montador.finalizar(saida);
+        if (erro_montagem.has_value()) {
+            std::cerr << arquivo_entrada << ": " << erro_montagem.value() << std::endl;
+            sucesso = false;
+        }
+    }
+    fila.enviar();
+    for (const auto& [escrita, saida] : escritas) {
+        mlc::ResultadoES resultado = fila.esperar(escrita);
+        if (resultado.erro.has_value()) {
+            std::cerr << saida << ": " << resultado.erro.value() << std::endl;
+            sucesso = false;
+        }
+    }
+    exportar_trace(arquivo_trace);
 
-    //preparando para ler conteúdos do arquivo .ml como string
-    std::fstream fs_in (argv[1], std::ios::in);
-    std::stringstream conteudo_stream;
-    conteudo_stream << fs_in.rdbuf();
-    fs_in.close();
-    std::string conteudo_arquivo = conteudo_stream.str();
-
-    //realizando tokenização no arquivo e convertendo em assembly
-    Tokenizer tokenizer(std::move(conteudo_arquivo));
-    std::vector<Token> tokens = tokenizer.tokenize();
-    Parser parser(std::move(tokens));
-    std::optional<node::Program> program = parser.parse_program();
-    if (!program.has_value()) {
-        std::cerr << "Nenhuma operação de saída." << std::endl;
-        exit(EXIT_FAILURE);
-    }
-    Generator generator(program.value());
-    std::string conteudo_asm = generator.generate_program();
-    
-    //criando e escrevendo em um arquivo nosso código em assembly
-    std::fstream fs_out ("./out.asm", std::ios::out);
-    fs_out << conteudo_asm;
-    fs_out.close();
-
-    //passando arquivos gerados pelo assembler e linker
-    system("nasm -felf64 ./out.asm");
-    system("ld -o out out.o");
-    
-
-    return EXIT_SUCCESS;
-}
\ No newline at end of file
+    return sucesso ? EXIT_SUCCESS : EXIT_FAILURE;
+}
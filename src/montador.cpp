@@ -0,0 +1,239 @@
+#include <algorithm>
+#include <deque>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "./montador.hpp"
+#include "./trace.hpp"
+
+extern char** environ;
+
+
+namespace mlc {
+    /*
+    Descritores acima deste valor nunca colidem com os descritores
+    fixos (3 e 4) usados pelos processos filhos.
+    */
+    static constexpr int FD_MINIMO = 64;
+
+    /*
+    Cria um memfd com FD_CLOEXEC em um descritor >= FD_MINIMO, para
+    que ele só chegue aos filhos através de posix_spawn_file_actions.
+    */
+    static int criar_memfd(const char* nome) {
+        int fd = memfd_create(nome, MFD_CLOEXEC);
+        if (fd < 0) {
+            return -1;
+        }
+        int alto = fcntl(fd, F_DUPFD_CLOEXEC, FD_MINIMO);
+        close(fd);
+        return alto;
+    }
+
+    /*
+    Inicia 'argv' diretamente (sem shell). Cada par (origem, destino)
+    de 'fds' fica visível no filho como o descritor 'destino'; com a
+    origem igual ao destino, o descritor é herdado com o mesmo número
+    (o dup2 de um descritor nele mesmo retira o FD_CLOEXEC no filho).
+    */
+    static std::optional<std::string> iniciar(const std::vector<const char*>& argv, const std::vector<std::pair<int, int>>& fds, pid_t& pid) {
+        posix_spawn_file_actions_t acoes;
+        posix_spawn_file_actions_init(&acoes);
+        for (auto [origem, destino] : fds) {
+            posix_spawn_file_actions_adddup2(&acoes, origem, destino);
+        }
+        int status_spawn = posix_spawnp(&pid, argv[0], &acoes, nullptr, const_cast<char* const*>(argv.data()), environ);
+        posix_spawn_file_actions_destroy(&acoes);
+        if (status_spawn != 0) {
+            return std::string("Não foi possível executar '") + argv[0] + "': " + strerror(status_spawn);
+        }
+        return {};
+    }
+
+    /*
+    Espera o processo 'pid' do programa 'programa' terminar.
+    */
+    static std::optional<std::string> esperar(pid_t pid, const char* programa) {
+        int status;
+        while (waitpid(pid, &status, 0) < 0) {
+            if (errno != EINTR) {
+                return std::string("Falha ao esperar por '") + programa + "'.";
+            }
+        }
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            return std::string("'") + programa + "' terminou com erro.";
+        }
+        return {};
+    }
+
+    /*
+    Executa 'argv' (checar iniciar) e espera o processo terminar.
+    */
+    static std::optional<std::string> executar(const std::vector<const char*>& argv, const std::vector<std::pair<int, int>>& fds) {
+        MLC_TRACE_SCOPE(argv[0]);
+        pid_t pid;
+        if (auto erro = iniciar(argv, fds, pid)) {
+            return erro;
+        }
+        return esperar(pid, argv[0]);
+    }
+
+    /*
+    Escreve 'dados' inteiro no descritor 'fd'.
+    */
+    static std::optional<std::string> escrever_tudo(int fd, std::string_view dados) {
+        while (!dados.empty()) {
+            ssize_t escritos = write(fd, dados.data(), dados.size());
+            if (escritos < 0) {
+                if (errno != EINTR) {
+                    return std::string("Falha ao escrever o assembly: ") + strerror(errno);
+                }
+                continue;
+            }
+            dados.remove_prefix(static_cast<size_t>(escritos));
+        }
+        return {};
+    }
+
+    Montador::Montador() {
+        m_asm_fd = criar_memfd("mlc-asm");
+        m_obj_fd = criar_memfd("mlc-obj");
+        if (m_asm_fd < 0 || m_obj_fd < 0) {
+            m_erro = std::string("Não foi possível criar memfd: ") + strerror(errno);
+        }
+    }
+
+    Montador::~Montador() {
+        if (m_asm_fd >= 0) {
+            close(m_asm_fd);
+        }
+        if (m_obj_fd >= 0) {
+            close(m_obj_fd);
+        }
+    }
+
+    void Montador::escrever(std::string_view chunk) {
+        if (!m_erro.has_value()) {
+            m_erro = escrever_tudo(m_asm_fd, chunk);
+        }
+    }
+
+    std::optional<std::string> Montador::finalizar(const std::string& saida) {
+        if (m_erro.has_value()) {
+            return m_erro;
+        }
+        /*
+        O nasm é multi-passagem e reabre o arquivo de entrada a cada
+        passagem, então ele não consegue ler de um pipe. Por isso o
+        assembly fica num memfd, que ele reabre por /dev/fd/3.
+        */
+        if (auto erro = executar({"nasm", "-felf64", "-o", "/dev/fd/4", "/dev/fd/3", nullptr}, {{m_asm_fd, 3}, {m_obj_fd, 4}})) {
+            return erro;
+        }
+        return executar({"ld", "-o", saida.c_str(), "/dev/fd/3", nullptr}, {{m_obj_fd, 3}});
+    }
+
+    MontadorIncremental::~MontadorIncremental() {
+        for (auto& [id, objeto] : m_objetos) {
+            close(objeto.asm_fd);
+            close(objeto.obj_fd);
+        }
+    }
+
+    std::optional<std::string> MontadorIncremental::atualizar(const std::vector<Bloco>& blocos, const std::string& saida) {
+        std::unordered_set<uint64_t> ids;
+        for (const Bloco& bloco : blocos) {
+            ids.insert(bloco.id);
+        }
+        std::erase_if(m_objetos, [&ids](const auto& par) {
+            if (ids.contains(par.first)) {
+                return false;
+            }
+            close(par.second.asm_fd);
+            close(par.second.obj_fd);
+            return true;
+        });
+
+        //os blocos alterados são montados em paralelo, com até um nasm por processador
+        struct Montagem {
+            pid_t pid;
+            Objeto* objeto;
+        };
+        size_t max_paralelo = std::max(1u, std::thread::hardware_concurrency());
+        std::deque<Montagem> em_andamento;
+        std::optional<std::string> erro;
+        auto esperar_proxima = [&]() {
+            Montagem montagem = em_andamento.front();
+            em_andamento.pop_front();
+            std::optional<std::string> erro_nasm = esperar(montagem.pid, "nasm");
+            montagem.objeto->montado = !erro_nasm.has_value();
+            if (erro_nasm.has_value() && !erro.has_value()) {
+                erro = erro_nasm;
+            }
+        };
+        {
+            MLC_TRACE_SCOPE("nasm");
+            for (const Bloco& bloco : blocos) {
+                Objeto& objeto = m_objetos[bloco.id];
+                if (objeto.montado && !bloco.alterado) {
+                    continue;
+                }
+                objeto.montado = false;
+                if (objeto.asm_fd < 0) {
+                    objeto.asm_fd = criar_memfd("mlc-asm");
+                    objeto.obj_fd = criar_memfd("mlc-obj");
+                    if (objeto.asm_fd < 0 || objeto.obj_fd < 0) {
+                        erro = std::string("Não foi possível criar memfd: ") + strerror(errno);
+                        break;
+                    }
+                }
+                if (ftruncate(objeto.asm_fd, 0) != 0 || lseek(objeto.asm_fd, 0, SEEK_SET) != 0) {
+                    erro = std::string("Falha ao escrever o assembly: ") + strerror(errno);
+                    break;
+                }
+                if ((erro = escrever_tudo(objeto.asm_fd, bloco.assembly))) {
+                    break;
+                }
+                std::string entrada = "/dev/fd/" + std::to_string(objeto.asm_fd);
+                std::string objeto_saida = "/dev/fd/" + std::to_string(objeto.obj_fd);
+                pid_t pid;
+                if ((erro = iniciar({"nasm", "-felf64", "-o", objeto_saida.c_str(), entrada.c_str(), nullptr}, {{objeto.asm_fd, objeto.asm_fd}, {objeto.obj_fd, objeto.obj_fd}}, pid))) {
+                    break;
+                }
+                em_andamento.push_back({.pid = pid, .objeto = &objeto});
+                if (em_andamento.size() >= max_paralelo) {
+                    esperar_proxima();
+                }
+            }
+            while (!em_andamento.empty()) {
+                esperar_proxima();
+            }
+        }
+        if (erro.has_value()) {
+            return erro;
+        }
+
+        std::vector<std::string> objetos;
+        std::vector<std::pair<int, int>> fds;
+        for (const Bloco& bloco : blocos) {
+            int fd = m_objetos[bloco.id].obj_fd;
+            objetos.push_back("/dev/fd/" + std::to_string(fd));
+            fds.emplace_back(fd, fd);
+        }
+        std::vector<const char*> argv {"ld", "-o", saida.c_str()};
+        for (const std::string& objeto : objetos) {
+            argv.push_back(objeto.c_str());
+        }
+        argv.push_back(nullptr);
+        return executar(argv, fds);
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "./incremental.hpp"
+
+/*
+Driver do assembler (nasm) e do linker (ld). O assembly é escrito,
+em chunks, num arquivo anônimo em memória (memfd) à medida que o
+Generator o produz; nasm e ld são executados diretamente com
+posix_spawn (sem passar por /bin/sh), e o objeto intermediário
+também fica num memfd. Nada é escrito no diretório de trabalho
+além do executável final.
+*/
+namespace mlc {
+    class Montador {
+        public:
+            Montador();
+            ~Montador();
+
+            /*
+            Acrescenta um chunk de assembly à entrada do nasm.
+            */
+            void escrever(std::string_view chunk);
+
+            /*
+            Monta e liga o assembly escrito até aqui, gerando o
+            executável 'saida'. Retorna a mensagem de erro caso
+            alguma etapa falhe.
+            */
+            std::optional<std::string> finalizar(const std::string& saida);
+
+            Montador(const Montador&) = delete;
+            Montador& operator=(const Montador&) = delete;
+
+        private:
+            int m_asm_fd = -1; // memfd com o código assembly
+            int m_obj_fd = -1; // memfd com o objeto gerado pelo nasm
+            std::optional<std::string> m_erro;
+    };
+
+    /*
+    Montagem incremental, usada com a CompilacaoIncremental (modo
+    --watch): cada bloco do programa é montado num objeto próprio,
+    guardado em memfd, e só os blocos alterados passam de novo pelo
+    nasm (vários ao mesmo tempo); o ld liga todos os objetos.
+    */
+    class MontadorIncremental {
+        public:
+            MontadorIncremental() = default;
+            ~MontadorIncremental();
+
+            /*
+            Monta os blocos alterados, descarta os objetos de blocos
+            que deixaram de existir e liga o executável 'saida'.
+            Retorna a mensagem de erro caso alguma etapa falhe.
+            */
+            std::optional<std::string> atualizar(const std::vector<Bloco>& blocos, const std::string& saida);
+
+            MontadorIncremental(const MontadorIncremental&) = delete;
+            MontadorIncremental& operator=(const MontadorIncremental&) = delete;
+
+        private:
+            struct Objeto {
+                int asm_fd = -1;
+                int obj_fd = -1;
+                bool montado = false;
+            };
+
+            std::unordered_map<uint64_t, Objeto> m_objetos; // por Bloco::id
+    };
+}
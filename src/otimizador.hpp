@@ -0,0 +1,1388 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <limits>
+#include <algorithm>
+#include <optional>
+#include <bit>
+
+#include "./arena.hpp"
+#include "./parser.hpp"
+#include "./trace.hpp"
+
+/*
+Otimizações feitas sobre a AST, entre o parser e o Generator:
+- código inalcançável: statements depois de um 'exit' ou 'return'
+(ou de um escopo que sempre termina num deles) são removidos;
+- dead stores: atribuições cujo valor nunca é lido antes de ser
+sobrescrito (ou do fim do programa) são removidas, a partir de
+uma análise de liveness feita de trás para frente;
+- variáveis mortas: declarações de variáveis que nunca são lidas
+são removidas, liberando a sua posição na stack;
+- loops: expressões invariantes são calculadas uma única vez antes
+do 'while' (loop-invariant code motion), e multiplicações de uma
+variável de indução por uma constante viram uma soma por iteração
+(strength reduction). Os valores calculados ficam em variáveis
+sintéticas ('$t0', '$t1', ...), que o tokenizador nunca produz;
+- arrays: verificações de limites são removidas quando o índice
+está provadamente dentro do array (análise de intervalos sobre os
+contadores dos loops), e loops que percorrem arrays elemento a
+elemento são marcados para serem gerados com instruções SIMD.
+Expressões que podem falhar em tempo de execução (divisões) ou
+chamar funções nunca são removidas nem movidas, para que o programa otimizado se comporte como o
+original. Caso o programa tenha um erro semântico (identificadores,
+chamadas de função ou 'return' fora de uma função), mesmo em código
+inalcançável, a AST não é alterada e o erro é reportado normalmente
+pelo Generator.
+*/
+class Otimizador {
+    public:
+        inline Otimizador(node::Program& program, ArenaAlloc& alloc)
+            : m_program(program), m_alloc(alloc)
+        {}
+
+        /*
+        Método que aplica todas as otimizações na AST do programa,
+        alterando-a no local.
+        PARÂMETROS:
+        RETURNS:
+        */
+        inline void otimizar() {
+            MLC_TRACE_SCOPE("otimizar");
+            if (!resolver()) {
+                return;
+            }
+            for (const Corte& corte : m_cortes) {
+                corte.lista->resize(corte.tamanho);
+            }
+            eliminar_checagens();
+            otimizar_lacos();
+            m_pos.assign(m_num_vars, SEM_POS);
+            m_usos.assign(m_num_vars, 0);
+            eliminar_mortos(m_program.statmts);
+            for (node::Function* funcao : m_program.funcoes) {
+                while (!m_vivas.empty()) {
+                    marcar_morta(m_vivas.back()); // os parâmetros da função anterior
+                }
+                eliminar_mortos(funcao->scope->statmts_scope);
+            }
+            marcar_vetoriais();
+        }
+
+    private:
+        static constexpr uint32_t SEM_POS = std::numeric_limits<uint32_t>::max();
+        static constexpr size_t REGS_VETOR = 16; // xmm0-xmm15 (ou ymm0-ymm15)
+
+        /*
+        Lista de statements que deve ser truncada em 'tamanho'
+        (tudo depois de um 'exit' é inalcançável).
+        */
+        struct Corte {
+            std::vector<node::Statmt*>* lista;
+            size_t tamanho;
+        };
+
+        /*
+        Um 'while' do programa e a lista de statements que o contém.
+        */
+        struct Laco {
+            std::vector<node::Statmt*>* lista;
+            size_t indice;
+            node::Statmt* statmt;
+        };
+
+        node::Program& m_program;
+        ArenaAlloc& m_alloc;
+        uint32_t m_num_vars = 0; // Número de declarações de variáveis no programa
+        std::vector<Corte> m_cortes;
+        std::vector<Laco> m_lacos; // Loops do programa, em pré-ordem
+        std::vector<uint32_t> m_atribuicoes; // Número de atribuições de cada variável dentro do loop atual
+        uint32_t m_num_sinteticas = 0;
+        std::vector<uint32_t> m_vivas; // Variáveis vivas no ponto atual da análise
+        std::vector<uint32_t> m_pos; // Posição de cada variável em m_vivas, ou SEM_POS caso esteja morta
+        std::vector<uint32_t> m_usos; // Leituras (e atribuições mantidas) de cada variável já vistas
+        std::vector<uint32_t> m_log; // Variáveis removidas de m_vivas dentro do corpo de um 'if' ou 'while'
+        size_t m_corpos_abertos = 0;
+        std::vector<int64_t> m_tamanhos; // Tamanho de cada array, por id (0 para variáveis comuns)
+        std::unordered_map<std::string_view, size_t> m_aridades; // Número de parâmetros de cada função
+
+        /*
+        Método que resolve os identificadores do programa principal e
+        do corpo de cada função (checar resolver_lista). Os parâmetros
+        de uma função são variáveis declaradas no início do seu corpo.
+        Como o código inalcançável é removido antes do Generator, todos
+        os erros que ele reportaria também são verificados aqui, para
+        que um programa seja válido com ou sem otimizações.
+        PARÂMETROS:
+        RETURNS:
+        - (bool): falso caso o programa tenha algum erro semântico.
+        */
+        inline bool resolver() {
+            for (const node::Function* funcao : m_program.funcoes) {
+                if (!m_aridades.try_emplace(funcao->token_identif.valor.value(), funcao->params.size()).second) {
+                    return false;
+                }
+            }
+            if (!resolver_lista(m_program.statmts, {}, false)) {
+                return false;
+            }
+            for (node::Function* funcao : m_program.funcoes) {
+                std::unordered_map<std::string_view, uint32_t> params;
+                for (const Token& param : funcao->params) {
+                    if (!params.try_emplace(param.valor.value(), m_num_vars++).second) {
+                        return false;
+                    }
+                }
+                if (!resolver_lista(funcao->scope->statmts_scope, std::move(params), true)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /*
+        Método que associa cada uso de identificador à sua declaração
+        (preenchendo 'id_var' nos nós), com as mesmas regras de escopo
+        do Generator, e encontra os statements inalcançáveis. Os
+        escopos são percorridos com uma pilha explícita.
+        PARÂMETROS:
+        - statmts (std::vector<node::Statmt*>&): statements do programa
+        principal ou do corpo de uma função.
+        - nomes (std::unordered_map<std::string_view, uint32_t>):
+        variáveis já visíveis no início da lista.
+        - em_funcao (bool): a lista é o corpo de uma função, onde
+        'return' é permitido.
+        RETURNS:
+        - (bool): falso caso algum identificador não tenha sido
+        declarado ou tenha sido declarado duas vezes, ou caso haja um
+        'return' fora de uma função.
+        */
+        inline bool resolver_lista(std::vector<node::Statmt*>& statmts, std::unordered_map<std::string_view, uint32_t> nomes, bool em_funcao) {
+            struct Quadro {
+                std::vector<node::Statmt*>* lista;
+                size_t i;
+                size_t base_nomes;
+                size_t corte;
+                bool bloco; // escopo '{ }' (executado sempre), e não o corpo de um 'if'
+            };
+            std::vector<std::string_view> declarados;
+            std::vector<Quadro> pilha {{.lista = &statmts, .i = 0, .base_nomes = 0, .corte = SIZE_MAX, .bloco = false}};
+
+            while (!pilha.empty()) {
+                Quadro& quadro = pilha.back();
+                if (quadro.i == quadro.lista->size()) {
+                    for (size_t k = quadro.base_nomes; k < declarados.size(); k++) {
+                        nomes.erase(declarados[k]);
+                    }
+                    declarados.resize(quadro.base_nomes);
+                    if (quadro.corte < quadro.lista->size()) {
+                        m_cortes.push_back({.lista = quadro.lista, .tamanho = quadro.corte});
+                    }
+                    bool termina = quadro.bloco && quadro.corte != SIZE_MAX;
+                    pilha.pop_back();
+                    if (termina && pilha.back().corte == SIZE_MAX) {
+                        pilha.back().corte = pilha.back().i;
+                    }
+                    continue;
+                }
+                node::Statmt* statmt = (*quadro.lista)[quadro.i++];
+                if (std::holds_alternative<node::StatmtExit*>(statmt->variant_statmt) || std::holds_alternative<node::StatmtReturn*>(statmt->variant_statmt)) {
+                    if (!em_funcao && std::holds_alternative<node::StatmtReturn*>(statmt->variant_statmt)) {
+                        return false;
+                    }
+                    if (!resolver_expr(expr_saida(statmt), nomes)) {
+                        return false;
+                    }
+                    if (quadro.corte == SIZE_MAX) {
+                        quadro.corte = quadro.i;
+                    }
+                } else if (auto statmt_var = std::get_if<node::StatmtVar*>(&statmt->variant_statmt)) {
+                    if (auto new_var = std::get_if<node::NewVar*>(&(*statmt_var)->variant_var)) {
+                        // assim como no Generator, a variável já existe durante a sua própria expressão
+                        std::string_view nome = (*new_var)->token_identif.valor.value();
+                        if (!nomes.try_emplace(nome, m_num_vars).second) {
+                            return false;
+                        }
+                        declarados.push_back(nome);
+                        (*new_var)->id_var = m_num_vars++;
+                        if (!resolver_expr((*new_var)->expr, nomes)) {
+                            return false;
+                        }
+                    } else {
+                        node::ReassVar* reass_var = std::get<node::ReassVar*>((*statmt_var)->variant_var);
+                        auto it = nomes.find(reass_var->token_identif.valor.value());
+                        if (it == nomes.end() || tamanho(it->second) > 0) {
+                            return false;
+                        }
+                        reass_var->id_var = it->second;
+                        if (!resolver_expr(reass_var->expr, nomes)) {
+                            return false;
+                        }
+                    }
+                } else if (auto statmt_array = std::get_if<node::StatmtArray*>(&statmt->variant_statmt)) {
+                    std::string_view nome = (*statmt_array)->token_identif.valor.value();
+                    if (!nomes.try_emplace(nome, m_num_vars).second) {
+                        return false;
+                    }
+                    declarados.push_back(nome);
+                    m_tamanhos.resize(m_num_vars + 1, 0);
+                    m_tamanhos[m_num_vars] = (*statmt_array)->token_tamanho.valor_int;
+                    (*statmt_array)->id_var = m_num_vars++;
+                } else if (auto statmt_index = std::get_if<node::StatmtIndex*>(&statmt->variant_statmt)) {
+                    auto it = nomes.find((*statmt_index)->token_identif.valor.value());
+                    if (it == nomes.end() || tamanho(it->second) == 0) {
+                        return false;
+                    }
+                    (*statmt_index)->id_var = it->second;
+                    if (!resolver_expr((*statmt_index)->indice, nomes) || !resolver_expr((*statmt_index)->expr, nomes)) {
+                        return false;
+                    }
+                } else if (auto statmt_print = std::get_if<node::StatmtPrint*>(&statmt->variant_statmt)) {
+                    if (!resolver_expr((*statmt_print)->expr, nomes)) {
+                        return false;
+                    }
+                } else if (auto scope = std::get_if<node::Scope*>(&statmt->variant_statmt)) {
+                    pilha.push_back({.lista = &(*scope)->statmts_scope, .i = 0, .base_nomes = declarados.size(), .corte = SIZE_MAX, .bloco = true});
+                } else if (auto statmt_if = std::get_if<node::StatmtIf*>(&statmt->variant_statmt)) {
+                    if (!resolver_expr((*statmt_if)->expr, nomes)) {
+                        return false;
+                    }
+                    pilha.push_back({.lista = &(*statmt_if)->scope->statmts_scope, .i = 0, .base_nomes = declarados.size(), .corte = SIZE_MAX, .bloco = false});
+                } else if (auto statmt_while = std::get_if<node::StatmtWhile*>(&statmt->variant_statmt)) {
+                    if (!resolver_expr((*statmt_while)->expr, nomes)) {
+                        return false;
+                    }
+                    m_lacos.push_back({.lista = quadro.lista, .indice = quadro.i - 1, .statmt = statmt});
+                    pilha.push_back({.lista = &(*statmt_while)->scope->statmts_scope, .i = 0, .base_nomes = declarados.size(), .corte = SIZE_MAX, .bloco = false});
+                }
+            }
+            return true;
+        }
+
+        /*
+        Método que preenche 'id_var' em todos os identificadores de
+        uma expressão e verifica as suas chamadas de função.
+        PARÂMETROS:
+        - expr (node::Expr*): nó da expressão.
+        - nomes (const std::unordered_map<std::string_view, uint32_t>&):
+        variáveis visíveis no ponto da expressão.
+        RETURNS:
+        - (bool): falso caso algum identificador não exista (ou
+        seja usado como array sem ser um, ou vice-versa), ou caso
+        alguma função chamada não exista ou receba o número errado de
+        argumentos.
+        */
+        inline bool resolver_expr(node::Expr* expr, const std::unordered_map<std::string_view, uint32_t>& nomes) {
+            std::vector<node::Expr*> pilha {expr};
+            while (!pilha.empty()) {
+                node::Expr* atual = pilha.back();
+                pilha.pop_back();
+                if (auto bin_expr = std::get_if<node::BinExpr>(&atual->variant_expr)) {
+                    pilha.push_back(bin_expr->lado_esquerdo);
+                    pilha.push_back(bin_expr->lado_direito);
+                    continue;
+                }
+                node::Term& term = std::get<node::Term>(atual->variant_expr);
+                if (auto term_paren = std::get_if<node::TermParen>(&term.variant_term)) {
+                    pilha.push_back(term_paren->expr);
+                } else if (auto term_identif = std::get_if<node::TermIdentif>(&term.variant_term)) {
+                    auto it = nomes.find(term_identif->token_identif.valor.value());
+                    if (it == nomes.end() || tamanho(it->second) > 0) {
+                        return false;
+                    }
+                    term_identif->id_var = it->second;
+                } else if (auto term_call = std::get_if<node::TermCall>(&term.variant_term)) {
+                    auto it = m_aridades.find(term_call->token_identif.valor.value());
+                    if (it == m_aridades.end() || it->second != term_call->args.size()) {
+                        return false;
+                    }
+                    pilha.insert(pilha.end(), term_call->args.begin(), term_call->args.end());
+                } else if (auto term_index = std::get_if<node::TermIndex>(&term.variant_term)) {
+                    auto it = nomes.find(term_index->token_identif.valor.value());
+                    if (it == nomes.end() || tamanho(it->second) == 0) {
+                        return false;
+                    }
+                    term_index->id_var = it->second;
+                    pilha.push_back(term_index->indice);
+                }
+            }
+            return true;
+        }
+
+        /*
+        Intervalo [min, max] dos valores que uma expressão pode ter.
+        */
+        struct Faixa {
+            int64_t min;
+            int64_t max;
+        };
+
+        /*
+        Contador de um loop 'while (i < L)' (ou 'i <= L'), com L literal,
+        cuja única atribuição no loop é 'i = i + c' (c > 0) direto no
+        corpo, na posição 'posicao', e cujo valor na entrada do loop é
+        um literal. Antes da atualização, i está em 'antes'; depois, em
+        'depois'.
+        */
+        struct Contador {
+            uint32_t id;
+            size_t posicao;
+            Faixa antes;
+            Faixa depois;
+        };
+
+        /*
+        Método que remove as verificações de limites dos acessos a
+        arrays cujo índice está provadamente dentro do array. O
+        intervalo de cada índice é calculado a partir de literais e
+        dos contadores dos loops que envolvem o acesso (checar
+        Contador). O programa é percorrido com uma pilha explícita, e
+        cada loop com um contador o deixa ativo enquanto o seu corpo é
+        percorrido.
+        PARÂMETROS:
+        RETURNS:
+        */
+        inline void eliminar_checagens() {
+            struct Quadro {
+                std::vector<node::Statmt*>* lista;
+                size_t i;
+                std::optional<Contador> contador; // contador do loop dono da lista, caso exista
+            };
+            std::vector<Quadro> pilha;
+            auto faixa_var = [&pilha](uint32_t id) -> std::optional<Faixa> {
+                for (auto it = pilha.rbegin(); it != pilha.rend(); it++) {
+                    if (it->contador.has_value() && it->contador->id == id) {
+                        // 'i' é o statement atual da lista do loop (já incrementado)
+                        return it->i - 1 < it->contador->posicao ? it->contador->antes : it->contador->depois;
+                    }
+                }
+                return {};
+            };
+            auto checar = [&](const node::Expr* indice, uint32_t id_array, bool& flag) {
+                std::optional<Faixa> faixa = calcular_faixa(indice, faixa_var);
+                if (faixa.has_value() && faixa->min >= 0 && faixa->max < tamanho(id_array)) {
+                    flag = false;
+                }
+            };
+            auto checar_expr = [&](const node::Expr* expr) {
+                std::vector<const node::Expr*> exprs {expr};
+                while (!exprs.empty()) {
+                    const node::Expr* atual = exprs.back();
+                    exprs.pop_back();
+                    if (auto bin_expr = std::get_if<node::BinExpr>(&atual->variant_expr)) {
+                        exprs.push_back(bin_expr->lado_esquerdo);
+                        exprs.push_back(bin_expr->lado_direito);
+                        continue;
+                    }
+                    const node::Term& term = std::get<node::Term>(atual->variant_expr);
+                    if (auto term_paren = std::get_if<node::TermParen>(&term.variant_term)) {
+                        exprs.push_back(term_paren->expr);
+                    } else if (auto term_call = std::get_if<node::TermCall>(&term.variant_term)) {
+                        exprs.insert(exprs.end(), term_call->args.begin(), term_call->args.end());
+                    } else if (auto term_index = std::get_if<node::TermIndex>(&term.variant_term)) {
+                        checar(term_index->indice, term_index->id_var, const_cast<node::TermIndex*>(term_index)->checar);
+                        exprs.push_back(term_index->indice);
+                    }
+                }
+            };
+
+            std::vector<std::vector<node::Statmt*>*> raizes {&m_program.statmts};
+            for (node::Function* funcao : m_program.funcoes) {
+                raizes.push_back(&funcao->scope->statmts_scope);
+            }
+            for (std::vector<node::Statmt*>* raiz : raizes) {
+                pilha.push_back({.lista = raiz, .i = 0, .contador = {}});
+                while (!pilha.empty()) {
+                    Quadro& quadro = pilha.back();
+                    if (quadro.i == quadro.lista->size()) {
+                        pilha.pop_back();
+                        continue;
+                    }
+                    node::Statmt* statmt = (*quadro.lista)[quadro.i++];
+                    if (std::holds_alternative<node::StatmtExit*>(statmt->variant_statmt) || std::holds_alternative<node::StatmtReturn*>(statmt->variant_statmt)) {
+                        checar_expr(expr_saida(statmt));
+                    } else if (auto statmt_var = std::get_if<node::StatmtVar*>(&statmt->variant_statmt)) {
+                        std::visit([&checar_expr](auto* var) { checar_expr(var->expr); }, (*statmt_var)->variant_var);
+                    } else if (auto statmt_index = std::get_if<node::StatmtIndex*>(&statmt->variant_statmt)) {
+                        checar((*statmt_index)->indice, (*statmt_index)->id_var, (*statmt_index)->checar);
+                        checar_expr((*statmt_index)->indice);
+                        checar_expr((*statmt_index)->expr);
+                    } else if (auto statmt_print = std::get_if<node::StatmtPrint*>(&statmt->variant_statmt)) {
+                        checar_expr((*statmt_print)->expr);
+                    } else if (auto scope = std::get_if<node::Scope*>(&statmt->variant_statmt)) {
+                        pilha.push_back({.lista = &(*scope)->statmts_scope, .i = 0, .contador = {}});
+                    } else if (auto statmt_if = std::get_if<node::StatmtIf*>(&statmt->variant_statmt)) {
+                        checar_expr((*statmt_if)->expr);
+                        pilha.push_back({.lista = &(*statmt_if)->scope->statmts_scope, .i = 0, .contador = {}});
+                    } else if (auto statmt_while = std::get_if<node::StatmtWhile*>(&statmt->variant_statmt)) {
+                        checar_expr((*statmt_while)->expr);
+                        std::optional<Contador> contador = buscar_contador(*statmt_while, *quadro.lista, quadro.i - 1);
+                        pilha.push_back({.lista = &(*statmt_while)->scope->statmts_scope, .i = 0, .contador = contador});
+                    }
+                }
+            }
+        }
+
+        /*
+        Método que reconhece o contador de um loop (checar Contador).
+        PARÂMETROS:
+        - statmt_while (const node::StatmtWhile*): nó do loop.
+        - lista (const std::vector<node::Statmt*>&): lista que contém o loop.
+        - indice (size_t): posição do loop na lista.
+        RETURNS:
+        - (std::optional<Contador>): o contador, ou vazio caso o loop
+        não tenha um.
+        */
+        inline std::optional<Contador> buscar_contador(const node::StatmtWhile* statmt_while, const std::vector<node::Statmt*>& lista, size_t indice) const {
+            auto condicao = std::get_if<node::BinExpr>(&statmt_while->expr->variant_expr);
+            if (condicao == nullptr) {
+                return {};
+            }
+            // 'i < L', 'i <= L', 'L > i' ou 'L >= i'
+            TipoToken tipo = condicao->token.tipo;
+            const node::Expr* lado_var = condicao->lado_esquerdo;
+            const node::Expr* lado_limite = condicao->lado_direito;
+            if (tipo == TipoToken::maior || tipo == TipoToken::maior_igual) {
+                std::swap(lado_var, lado_limite);
+                tipo = tipo == TipoToken::maior ? TipoToken::menor : TipoToken::menor_igual;
+            }
+            uint32_t id = le_var(lado_var);
+            const node::TermIntLit* limite = eh_literal(lado_limite);
+            if ((tipo != TipoToken::menor && tipo != TipoToken::menor_igual) || id == SEM_POS || limite == nullptr) {
+                return {};
+            }
+            int64_t maximo = limite->token_int.valor_int;
+            if (tipo == TipoToken::menor) {
+                if (maximo == std::numeric_limits<int64_t>::min()) {
+                    return {};
+                }
+                maximo--;
+            }
+
+            // a única atribuição de 'i' no loop é 'i = i + c', direto no corpo
+            std::vector<node::Expr*> raizes;
+            std::vector<uint32_t> atribuidas;
+            percorrer_laco(statmt_while, raizes, &atribuidas);
+            if (std::count(atribuidas.begin(), atribuidas.end(), id) != 1) {
+                return {};
+            }
+            const std::vector<node::Statmt*>& corpo = statmt_while->scope->statmts_scope;
+            std::optional<size_t> posicao;
+            int64_t passo = 0;
+            for (size_t k = 0; k < corpo.size(); k++) {
+                auto statmt_var = std::get_if<node::StatmtVar*>(&corpo[k]->variant_statmt);
+                auto reass_var = statmt_var != nullptr ? std::get_if<node::ReassVar*>(&(*statmt_var)->variant_var) : nullptr;
+                if (reass_var == nullptr || (*reass_var)->id_var != id) {
+                    continue;
+                }
+                auto bin_expr = std::get_if<node::BinExpr>(&(*reass_var)->expr->variant_expr);
+                if (bin_expr == nullptr || bin_expr->token.tipo != TipoToken::mais || le_var(bin_expr->lado_esquerdo) != id
+                    || eh_literal(bin_expr->lado_direito) == nullptr || eh_literal(bin_expr->lado_direito)->token_int.valor_int <= 0) {
+                    return {};
+                }
+                posicao = k;
+                passo = eh_literal(bin_expr->lado_direito)->token_int.valor_int;
+            }
+            if (!posicao.has_value()) {
+                return {};
+            }
+
+            // valor de 'i' na entrada: a última atribuição antes do loop, na mesma lista, deve ser um literal
+            std::optional<int64_t> inicial;
+            for (size_t k = indice; k > 0 && !inicial.has_value(); k--) {
+                const node::Statmt* anterior = lista[k - 1];
+                if (auto statmt_var = std::get_if<node::StatmtVar*>(&anterior->variant_statmt)) {
+                    const node::Expr* expr = nullptr;
+                    std::visit([&](auto* var) {
+                        if (var->id_var == id) {
+                            expr = var->expr;
+                        }
+                    }, (*statmt_var)->variant_var);
+                    if (expr == nullptr) {
+                        continue;
+                    }
+                    if (eh_literal(expr) == nullptr) {
+                        return {};
+                    }
+                    inicial = eh_literal(expr)->token_int.valor_int;
+                } else if (atribui(anterior, id)) {
+                    return {};
+                }
+            }
+            int64_t depois_min, depois_max;
+            if (!inicial.has_value() || inicial.value() > maximo
+                || __builtin_add_overflow(inicial.value(), passo, &depois_min) || __builtin_add_overflow(maximo, passo, &depois_max)) {
+                return {};
+            }
+            return Contador {
+                .id = id,
+                .posicao = posicao.value(),
+                .antes = {.min = inicial.value(), .max = maximo},
+                .depois = {.min = depois_min, .max = depois_max}
+            };
+        }
+
+        /*
+        Método que verifica se um statement (ou algum statement
+        aninhado nele) atribui um valor à variável 'id'.
+        PARÂMETROS:
+        - statmt (const node::Statmt*): nó do statement.
+        - id (uint32_t): variável.
+        RETURNS:
+        - (bool): verdadeiro caso a variável seja atribuída.
+        */
+        static inline bool atribui(const node::Statmt* statmt, uint32_t id) {
+            std::vector<const node::Statmt*> pilha {statmt};
+            while (!pilha.empty()) {
+                const node::Statmt* atual = pilha.back();
+                pilha.pop_back();
+                if (auto statmt_var = std::get_if<node::StatmtVar*>(&atual->variant_statmt)) {
+                    bool atribuida = false;
+                    std::visit([&](auto* var) { atribuida = var->id_var == id; }, (*statmt_var)->variant_var);
+                    if (atribuida) {
+                        return true;
+                    }
+                } else if (auto scope = std::get_if<node::Scope*>(&atual->variant_statmt)) {
+                    pilha.insert(pilha.end(), (*scope)->statmts_scope.begin(), (*scope)->statmts_scope.end());
+                } else if (auto statmt_if = std::get_if<node::StatmtIf*>(&atual->variant_statmt)) {
+                    pilha.insert(pilha.end(), (*statmt_if)->scope->statmts_scope.begin(), (*statmt_if)->scope->statmts_scope.end());
+                } else if (auto statmt_while = std::get_if<node::StatmtWhile*>(&atual->variant_statmt)) {
+                    pilha.insert(pilha.end(), (*statmt_while)->scope->statmts_scope.begin(), (*statmt_while)->scope->statmts_scope.end());
+                }
+            }
+            return false;
+        }
+
+        /*
+        Método que calcula o intervalo de valores de uma expressão
+        (aritmética de intervalos), em pós-ordem com pilha explícita.
+        PARÂMETROS:
+        - expr (const node::Expr*): nó da expressão.
+        - faixa_var (const F&): intervalo de uma variável, ou vazio
+        caso ele não seja conhecido.
+        RETURNS:
+        - (std::optional<Faixa>): intervalo da expressão, ou vazio caso
+        ele não possa ser calculado (ou possa estourar 64 bits).
+        */
+        template <typename F>
+        static inline std::optional<Faixa> calcular_faixa(const node::Expr* expr, const F& faixa_var) {
+            struct Visita {
+                const node::Expr* expr;
+                bool filhos_prontos;
+            };
+            std::vector<Visita> pilha {{.expr = expr, .filhos_prontos = false}};
+            std::vector<Faixa> resultados;
+            while (!pilha.empty()) {
+                Visita visita = pilha.back();
+                pilha.pop_back();
+                if (auto bin_expr = std::get_if<node::BinExpr>(&visita.expr->variant_expr)) {
+                    if (!visita.filhos_prontos) {
+                        pilha.push_back({.expr = visita.expr, .filhos_prontos = true});
+                        pilha.push_back({.expr = bin_expr->lado_direito, .filhos_prontos = false});
+                        pilha.push_back({.expr = bin_expr->lado_esquerdo, .filhos_prontos = false});
+                        continue;
+                    }
+                    Faixa b = resultados.back();
+                    resultados.pop_back();
+                    Faixa a = resultados.back();
+                    Faixa& r = resultados.back();
+                    bool estouro;
+                    if (bin_expr->token.tipo == TipoToken::mais) {
+                        estouro = __builtin_add_overflow(a.min, b.min, &r.min) || __builtin_add_overflow(a.max, b.max, &r.max);
+                    } else if (bin_expr->token.tipo == TipoToken::menos) {
+                        estouro = __builtin_sub_overflow(a.min, b.max, &r.min) || __builtin_sub_overflow(a.max, b.min, &r.max);
+                    } else if (bin_expr->token.tipo == TipoToken::asterisco) {
+                        int64_t cantos[4] = {}; // a cadeia para no primeiro estouro, sem escrever os seguintes
+                        estouro = __builtin_mul_overflow(a.min, b.min, &cantos[0]) || __builtin_mul_overflow(a.min, b.max, &cantos[1])
+                            || __builtin_mul_overflow(a.max, b.min, &cantos[2]) || __builtin_mul_overflow(a.max, b.max, &cantos[3]);
+                        r = {.min = *std::min_element(cantos, cantos + 4), .max = *std::max_element(cantos, cantos + 4)};
+                    } else {
+                        estouro = true;
+                    }
+                    if (estouro) {
+                        return {};
+                    }
+                    continue;
+                }
+                const node::Term& term = std::get<node::Term>(visita.expr->variant_expr);
+                if (auto term_paren = std::get_if<node::TermParen>(&term.variant_term)) {
+                    pilha.push_back({.expr = term_paren->expr, .filhos_prontos = false});
+                } else if (auto term_int_lit = std::get_if<node::TermIntLit>(&term.variant_term)) {
+                    resultados.push_back({.min = term_int_lit->token_int.valor_int, .max = term_int_lit->token_int.valor_int});
+                } else if (auto term_identif = std::get_if<node::TermIdentif>(&term.variant_term)) {
+                    std::optional<Faixa> faixa = faixa_var(term_identif->id_var);
+                    if (!faixa.has_value()) {
+                        return {};
+                    }
+                    resultados.push_back(faixa.value());
+                } else {
+                    return {};
+                }
+            }
+            return resultados.back();
+        }
+
+        /*
+        Método que marca os loops que podem ser gerados com instruções
+        SIMD ('vetorizar'), ou seja, loops da forma
+            while (i < L) { a[i] = <expr>; ...; i = i + 1; }
+        onde L é um literal ou uma variável, todo acesso a array usa
+        exatamente o índice 'i', e as expressões só têm +, -, * por
+        potência de 2, elementos 'x[i]', literais e variáveis (exceto
+        'i'). Como cada iteração só lê e escreve a posição i, as
+        iterações são independentes e podem ser feitas várias de uma
+        vez. Os valores intermediários e invariantes precisam caber
+        nos 16 registradores vetoriais.
+        PARÂMETROS:
+        RETURNS:
+        */
+        inline void marcar_vetoriais() {
+            for (const Laco& laco : m_lacos) {
+                if (std::find(laco.lista->begin(), laco.lista->end(), laco.statmt) == laco.lista->end()) {
+                    continue; // loop removido
+                }
+                node::StatmtWhile* statmt_while = std::get<node::StatmtWhile*>(laco.statmt->variant_statmt);
+                auto condicao = std::get_if<node::BinExpr>(&statmt_while->expr->variant_expr);
+                if (condicao == nullptr || condicao->token.tipo != TipoToken::menor) {
+                    continue;
+                }
+                uint32_t id = le_var(condicao->lado_esquerdo);
+                uint32_t id_limite = le_var(condicao->lado_direito);
+                if (id == SEM_POS || id_limite == id || (id_limite == SEM_POS && eh_literal(condicao->lado_direito) == nullptr)) {
+                    continue;
+                }
+                const std::vector<node::Statmt*>& corpo = statmt_while->scope->statmts_scope;
+                if (corpo.size() < 2 || !eh_incremento(corpo.back(), id)) {
+                    continue;
+                }
+                bool vetorizavel = true;
+                std::vector<std::pair<bool, int64_t>> invariantes; // (literal?, valor ou id)
+                size_t registradores = 0; // registradores temporários da expressão mais profunda
+                for (size_t k = 0; k + 1 < corpo.size() && vetorizavel; k++) {
+                    auto statmt_index = std::get_if<node::StatmtIndex*>(&corpo[k]->variant_statmt);
+                    vetorizavel = statmt_index != nullptr && le_var((*statmt_index)->indice) == id
+                        && expr_vetorizavel((*statmt_index)->expr, id, invariantes, registradores);
+                }
+                statmt_while->vetorizar = vetorizavel && registradores + invariantes.size() <= REGS_VETOR;
+            }
+        }
+
+        /*
+        Método que verifica se uma expressão pode ser calculada com
+        instruções SIMD num loop vetorizado (checar marcar_vetoriais),
+        anotando os valores invariantes que ela usa.
+        PARÂMETROS:
+        - expr (const node::Expr*): nó da expressão.
+        - id (uint32_t): contador do loop.
+        - invariantes (std::vector<std::pair<bool, int64_t>>&): valores
+        invariantes do loop (literais e variáveis), sem repetição.
+        - registradores (size_t&): máximo de registradores temporários
+        usados pelas expressões, atualizado com os desta expressão.
+        RETURNS:
+        - (bool): verdadeiro caso a expressão seja vetorizável.
+        */
+        static inline bool expr_vetorizavel(const node::Expr* expr, uint32_t id, std::vector<std::pair<bool, int64_t>>& invariantes, size_t& registradores) {
+            // 'profundidade' é o número de valores já calculados e ainda não usados (um registrador cada)
+            struct Visita {
+                const node::Expr* expr;
+                size_t profundidade;
+            };
+            std::vector<Visita> pilha {{.expr = expr, .profundidade = 1}};
+            while (!pilha.empty()) {
+                Visita visita = pilha.back();
+                pilha.pop_back();
+                registradores = std::max(registradores, visita.profundidade);
+                if (auto bin_expr = std::get_if<node::BinExpr>(&visita.expr->variant_expr)) {
+                    if (bin_expr->token.tipo == TipoToken::asterisco) {
+                        if (potencia_de_2(bin_expr->lado_direito) >= 0) {
+                            pilha.push_back({.expr = bin_expr->lado_esquerdo, .profundidade = visita.profundidade});
+                        } else if (potencia_de_2(bin_expr->lado_esquerdo) >= 0) {
+                            pilha.push_back({.expr = bin_expr->lado_direito, .profundidade = visita.profundidade});
+                        } else {
+                            return false;
+                        }
+                    } else if (bin_expr->token.tipo == TipoToken::mais || bin_expr->token.tipo == TipoToken::menos) {
+                        pilha.push_back({.expr = bin_expr->lado_esquerdo, .profundidade = visita.profundidade});
+                        pilha.push_back({.expr = bin_expr->lado_direito, .profundidade = visita.profundidade + 1});
+                    } else {
+                        return false;
+                    }
+                    continue;
+                }
+                const node::Term& term = std::get<node::Term>(visita.expr->variant_expr);
+                std::optional<std::pair<bool, int64_t>> invariante;
+                if (auto term_paren = std::get_if<node::TermParen>(&term.variant_term)) {
+                    pilha.push_back({.expr = term_paren->expr, .profundidade = visita.profundidade});
+                } else if (auto term_index = std::get_if<node::TermIndex>(&term.variant_term)) {
+                    if (le_var(term_index->indice) != id) {
+                        return false;
+                    }
+                } else if (auto term_int_lit = std::get_if<node::TermIntLit>(&term.variant_term)) {
+                    invariante = {true, term_int_lit->token_int.valor_int};
+                } else if (auto term_identif = std::get_if<node::TermIdentif>(&term.variant_term); term_identif != nullptr && term_identif->id_var != id) {
+                    invariante = {false, term_identif->id_var};
+                } else {
+                    return false;
+                }
+                if (invariante.has_value() && std::find(invariantes.begin(), invariantes.end(), invariante.value()) == invariantes.end()) {
+                    invariantes.push_back(invariante.value());
+                }
+            }
+            return true;
+        }
+
+        /*
+        Método que verifica se um statement é 'i = i + 1'.
+        */
+        static inline bool eh_incremento(const node::Statmt* statmt, uint32_t id) {
+            auto statmt_var = std::get_if<node::StatmtVar*>(&statmt->variant_statmt);
+            auto reass_var = statmt_var != nullptr ? std::get_if<node::ReassVar*>(&(*statmt_var)->variant_var) : nullptr;
+            if (reass_var == nullptr || (*reass_var)->id_var != id) {
+                return false;
+            }
+            auto bin_expr = std::get_if<node::BinExpr>(&(*reass_var)->expr->variant_expr);
+            return bin_expr != nullptr && bin_expr->token.tipo == TipoToken::mais && le_var(bin_expr->lado_esquerdo) == id
+                && eh_literal(bin_expr->lado_direito) != nullptr && eh_literal(bin_expr->lado_direito)->token_int.valor_int == 1;
+        }
+
+        static inline int potencia_de_2(const node::Expr* expr) {
+            const node::TermIntLit* term_int_lit = eh_literal(expr);
+            if (term_int_lit == nullptr || term_int_lit->token_int.valor_int <= 0 || !std::has_single_bit(static_cast<uint64_t>(term_int_lit->token_int.valor_int))) {
+                return -1;
+            }
+            return std::countr_zero(static_cast<uint64_t>(term_int_lit->token_int.valor_int));
+        }
+
+        inline int64_t tamanho(uint32_t id) const {
+            return id < m_tamanhos.size() ? m_tamanhos[id] : 0;
+        }
+
+        /*
+        Método que otimiza os loops do programa, do mais interno para
+        o mais externo (ordem inversa da pré-ordem). Assim, o que um
+        loop interno calcula antes do seu início ainda pode ser
+        levado para fora do loop externo, caso também seja invariante
+        nele.
+        PARÂMETROS:
+        RETURNS:
+        */
+        inline void otimizar_lacos() {
+            for (auto it = m_lacos.rbegin(); it != m_lacos.rend(); it++) {
+                if (it->indice >= it->lista->size() || (*it->lista)[it->indice] != it->statmt) {
+                    continue; // loop inalcançável, já removido
+                }
+                node::StatmtWhile* statmt_while = std::get<node::StatmtWhile*>(it->statmt->variant_statmt);
+                std::vector<node::Expr*> raizes;
+                std::vector<uint32_t> atribuidas;
+                percorrer_laco(statmt_while, raizes, &atribuidas);
+                m_atribuicoes.resize(m_num_vars, 0);
+                for (uint32_t id : atribuidas) {
+                    m_atribuicoes[id]++;
+                }
+
+                std::vector<node::Statmt*> antes;
+                reduzir_inducao(statmt_while, raizes, antes, atribuidas);
+                m_atribuicoes.resize(m_num_vars, 0);
+                mover_invariantes(raizes, antes);
+                it->lista->insert(it->lista->begin() + static_cast<std::ptrdiff_t>(it->indice), antes.begin(), antes.end());
+
+                for (uint32_t id : atribuidas) {
+                    m_atribuicoes[id] = 0;
+                }
+            }
+        }
+
+        /*
+        Método que encontra as variáveis de indução do loop (variáveis
+        com uma única atribuição no loop, da forma 'i = i + c' ou
+        'i = i - c', direto no corpo) e troca cada multiplicação
+        'i * k' (com k literal) por uma variável sintética, iniciada
+        com 'i * k' antes do loop e atualizada com '+ c * k' logo
+        depois da atualização de 'i'.
+        PARÂMETROS:
+        - statmt_while (node::StatmtWhile*): nó do loop.
+        - raizes (const std::vector<node::Expr*>&): expressões do loop.
+        - antes (std::vector<node::Statmt*>&): recebe as declarações
+        que devem ser inseridas antes do loop.
+        - atribuidas (std::vector<uint32_t>&): variáveis atribuídas no
+        loop, que passa a incluir as variáveis sintéticas criadas aqui.
+        RETURNS:
+        */
+        inline void reduzir_inducao(node::StatmtWhile* statmt_while, const std::vector<node::Expr*>& raizes, std::vector<node::Statmt*>& antes, std::vector<uint32_t>& atribuidas) {
+            struct Inducao {
+                uint32_t id;
+                int64_t passo;
+                size_t posicao; // índice da atualização no corpo
+            };
+            std::vector<Inducao> inducoes;
+            std::vector<node::Statmt*>& corpo = statmt_while->scope->statmts_scope;
+            for (size_t k = 0; k < corpo.size(); k++) {
+                auto statmt_var = std::get_if<node::StatmtVar*>(&corpo[k]->variant_statmt);
+                if (statmt_var == nullptr || !std::holds_alternative<node::ReassVar*>((*statmt_var)->variant_var)) {
+                    continue;
+                }
+                node::ReassVar* reass_var = std::get<node::ReassVar*>((*statmt_var)->variant_var);
+                auto bin_expr = std::get_if<node::BinExpr>(&reass_var->expr->variant_expr);
+                if (m_atribuicoes[reass_var->id_var] != 1 || bin_expr == nullptr) {
+                    continue;
+                }
+                const node::TermIntLit* passo = eh_literal(bin_expr->lado_direito);
+                bool soma = bin_expr->token.tipo == TipoToken::mais;
+                if (soma && passo == nullptr && le_var(bin_expr->lado_direito) == reass_var->id_var) {
+                    passo = eh_literal(bin_expr->lado_esquerdo); // 'i = c + i'
+                } else if (le_var(bin_expr->lado_esquerdo) != reass_var->id_var) {
+                    continue;
+                }
+                if (passo == nullptr || (!soma && bin_expr->token.tipo != TipoToken::menos)) {
+                    continue;
+                }
+                inducoes.push_back({
+                    .id = reass_var->id_var,
+                    .passo = soma ? passo->token_int.valor_int : static_cast<int64_t>(0 - static_cast<uint64_t>(passo->token_int.valor_int)),
+                    .posicao = k
+                });
+            }
+            if (inducoes.empty()) {
+                return;
+            }
+
+            struct Reducao {
+                uint32_t id_var;
+                int64_t fator;
+                const node::NewVar* sintetica;
+                size_t posicao;
+                int64_t passo;
+            };
+            std::vector<Reducao> reducoes;
+            std::vector<node::Expr*> pilha;
+            for (node::Expr* raiz : raizes) {
+                pilha.push_back(raiz);
+                while (!pilha.empty()) {
+                    node::Expr* atual = pilha.back();
+                    pilha.pop_back();
+                    auto bin_expr = std::get_if<node::BinExpr>(&atual->variant_expr);
+                    if (bin_expr == nullptr) {
+                        if (auto term_paren = std::get_if<node::TermParen>(&std::get<node::Term>(atual->variant_expr).variant_term)) {
+                            pilha.push_back(term_paren->expr);
+                        }
+                        continue;
+                    }
+                    const Inducao* inducao = nullptr;
+                    const node::TermIntLit* fator = nullptr;
+                    if (bin_expr->token.tipo == TipoToken::asterisco) {
+                        // 'i * k' ou 'k * i'
+                        uint32_t id = le_var(bin_expr->lado_esquerdo);
+                        fator = eh_literal(bin_expr->lado_direito);
+                        if (fator == nullptr) {
+                            id = le_var(bin_expr->lado_direito);
+                            fator = eh_literal(bin_expr->lado_esquerdo);
+                        }
+                        for (const Inducao& candidata : inducoes) {
+                            if (fator != nullptr && candidata.id == id) {
+                                inducao = &candidata;
+                            }
+                        }
+                    }
+                    if (inducao == nullptr) {
+                        pilha.push_back(bin_expr->lado_esquerdo);
+                        pilha.push_back(bin_expr->lado_direito);
+                        continue;
+                    }
+                    int64_t valor_fator = fator->token_int.valor_int;
+                    auto reducao = std::find_if(reducoes.begin(), reducoes.end(), [&](const Reducao& r) {
+                        return r.id_var == inducao->id && r.fator == valor_fator;
+                    });
+                    if (reducao == reducoes.end()) {
+                        node::Expr* inicial = m_alloc.alloc<node::Expr>();
+                        inicial->variant_expr = std::move(atual->variant_expr);
+                        reducoes.push_back({
+                            .id_var = inducao->id,
+                            .fator = valor_fator,
+                            .sintetica = criar_var(inicial, antes),
+                            .posicao = inducao->posicao,
+                            .passo = static_cast<int64_t>(static_cast<uint64_t>(inducao->passo) * static_cast<uint64_t>(valor_fator))
+                        });
+                        reducao = reducoes.end() - 1;
+                        m_atribuicoes.resize(m_num_vars, 0);
+                        m_atribuicoes[reducao->sintetica->id_var] = 1;
+                        atribuidas.push_back(reducao->sintetica->id_var);
+                    }
+                    atual->variant_expr = criar_leitura(reducao->sintetica);
+                }
+            }
+
+            // as atualizações das variáveis sintéticas entram logo depois das atualizações das variáveis de indução
+            std::vector<node::Statmt*> novo_corpo;
+            novo_corpo.reserve(corpo.size() + reducoes.size());
+            for (size_t k = 0; k < corpo.size(); k++) {
+                novo_corpo.push_back(corpo[k]);
+                for (const Reducao& reducao : reducoes) {
+                    if (reducao.posicao == k) {
+                        novo_corpo.push_back(criar_incremento(reducao.sintetica, reducao.passo));
+                    }
+                }
+            }
+            corpo = std::move(novo_corpo);
+        }
+
+        /*
+        Método que move para antes do loop as maiores subexpressões
+        invariantes do loop: expressões (não triviais) que só leem
+        variáveis sem atribuições dentro do loop e que não podem
+        falhar. Cada uma vira uma variável sintética calculada uma
+        única vez.
+        PARÂMETROS:
+        - raizes (const std::vector<node::Expr*>&): expressões do loop.
+        - antes (std::vector<node::Statmt*>&): recebe as declarações
+        que devem ser inseridas antes do loop.
+        RETURNS:
+        */
+        inline void mover_invariantes(const std::vector<node::Expr*>& raizes, std::vector<node::Statmt*>& antes) {
+            /*
+            Percurso em pós-ordem com pilha explícita: cada nó é visitado duas vezes, e na
+            segunda visita os resultados dos filhos (invariante ou não) estão no topo de
+            'resultados'. Um nó invariante cujo pai não é invariante é movido para fora.
+            */
+            struct Visita {
+                node::Expr* expr;
+                bool filhos_prontos;
+            };
+            struct Resultado {
+                node::Expr* expr;
+                bool invariante;
+            };
+            std::vector<Visita> pilha;
+            std::vector<Resultado> resultados;
+            std::vector<node::Expr*> mover;
+            auto mover_filhos = [&](size_t num_filhos, bool invariante) {
+                for (size_t k = resultados.size() - num_filhos; k < resultados.size(); k++) {
+                    if (!invariante && resultados[k].invariante && !eh_trivial(resultados[k].expr)) {
+                        mover.push_back(resultados[k].expr);
+                    }
+                }
+                resultados.resize(resultados.size() - num_filhos);
+            };
+
+            for (node::Expr* raiz : raizes) {
+                pilha.push_back({.expr = raiz, .filhos_prontos = false});
+                while (!pilha.empty()) {
+                    Visita visita = pilha.back();
+                    pilha.pop_back();
+                    auto bin_expr = std::get_if<node::BinExpr>(&visita.expr->variant_expr);
+                    const node::Term* term = std::get_if<node::Term>(&visita.expr->variant_expr);
+                    const node::TermParen* term_paren = term != nullptr ? std::get_if<node::TermParen>(&term->variant_term) : nullptr;
+                    if (!visita.filhos_prontos && (bin_expr != nullptr || term_paren != nullptr)) {
+                        pilha.push_back({.expr = visita.expr, .filhos_prontos = true});
+                        if (bin_expr != nullptr) {
+                            pilha.push_back({.expr = bin_expr->lado_direito, .filhos_prontos = false});
+                            pilha.push_back({.expr = bin_expr->lado_esquerdo, .filhos_prontos = false});
+                        } else {
+                            pilha.push_back({.expr = term_paren->expr, .filhos_prontos = false});
+                        }
+                        continue;
+                    }
+                    bool invariante;
+                    if (bin_expr != nullptr) {
+                        invariante = resultados[resultados.size() - 2].invariante && resultados.back().invariante
+                            && (bin_expr->token.tipo != TipoToken::barra_div || eh_literal_nao_nulo(bin_expr->lado_direito));
+                        mover_filhos(2, invariante);
+                    } else if (term_paren != nullptr) {
+                        invariante = resultados.back().invariante;
+                        mover_filhos(1, invariante);
+                    } else if (std::holds_alternative<node::TermCall>(term->variant_term)) {
+                        invariante = false; // a função pode nunca retornar ou encerrar o programa
+                    } else if (std::holds_alternative<node::TermIndex>(term->variant_term)) {
+                        invariante = false; // o array pode ser alterado dentro do loop
+                    } else {
+                        uint32_t id = le_var(visita.expr);
+                        invariante = id == SEM_POS || m_atribuicoes[id] == 0;
+                    }
+                    resultados.push_back({.expr = visita.expr, .invariante = invariante});
+                }
+                if (resultados.back().invariante && !eh_trivial(raiz)) {
+                    mover.push_back(raiz);
+                }
+                resultados.clear();
+            }
+
+            for (node::Expr* expr : mover) {
+                node::Expr* movida = m_alloc.alloc<node::Expr>();
+                movida->variant_expr = std::move(expr->variant_expr);
+                expr->variant_expr = criar_leitura(criar_var(movida, antes));
+            }
+        }
+
+        /*
+        Método que lista as expressões de um loop (condição e todas as
+        expressões do corpo, incluindo escopos aninhados) e, caso
+        'atribuidas' não seja nulo, as variáveis atribuídas ou
+        declaradas dentro dele.
+        PARÂMETROS:
+        - statmt_while (const node::StatmtWhile*): nó do loop.
+        - raizes (std::vector<node::Expr*>&): recebe as expressões.
+        - atribuidas (std::vector<uint32_t>*): recebe o id de cada
+        variável a cada atribuição.
+        RETURNS:
+        */
+        static inline void percorrer_laco(const node::StatmtWhile* statmt_while, std::vector<node::Expr*>& raizes, std::vector<uint32_t>* atribuidas = nullptr) {
+            raizes.push_back(statmt_while->expr);
+            std::vector<const std::vector<node::Statmt*>*> pilha {&statmt_while->scope->statmts_scope};
+            while (!pilha.empty()) {
+                const std::vector<node::Statmt*>* lista = pilha.back();
+                pilha.pop_back();
+                for (const node::Statmt* statmt : *lista) {
+                    if (std::holds_alternative<node::StatmtExit*>(statmt->variant_statmt) || std::holds_alternative<node::StatmtReturn*>(statmt->variant_statmt)) {
+                        raizes.push_back(expr_saida(statmt));
+                    } else if (auto statmt_var = std::get_if<node::StatmtVar*>(&statmt->variant_statmt)) {
+                        if (auto new_var = std::get_if<node::NewVar*>(&(*statmt_var)->variant_var)) {
+                            raizes.push_back((*new_var)->expr);
+                            if (atribuidas != nullptr) {
+                                atribuidas->push_back((*new_var)->id_var);
+                            }
+                        } else {
+                            node::ReassVar* reass_var = std::get<node::ReassVar*>((*statmt_var)->variant_var);
+                            raizes.push_back(reass_var->expr);
+                            if (atribuidas != nullptr) {
+                                atribuidas->push_back(reass_var->id_var);
+                            }
+                        }
+                    } else if (auto scope = std::get_if<node::Scope*>(&statmt->variant_statmt)) {
+                        pilha.push_back(&(*scope)->statmts_scope);
+                    } else if (auto statmt_if = std::get_if<node::StatmtIf*>(&statmt->variant_statmt)) {
+                        raizes.push_back((*statmt_if)->expr);
+                        pilha.push_back(&(*statmt_if)->scope->statmts_scope);
+                    } else if (auto interno = std::get_if<node::StatmtWhile*>(&statmt->variant_statmt)) {
+                        raizes.push_back((*interno)->expr);
+                        pilha.push_back(&(*interno)->scope->statmts_scope);
+                    } else if (auto statmt_index = std::get_if<node::StatmtIndex*>(&statmt->variant_statmt)) {
+                        raizes.push_back((*statmt_index)->indice);
+                        raizes.push_back((*statmt_index)->expr);
+                    } else if (auto statmt_print = std::get_if<node::StatmtPrint*>(&statmt->variant_statmt)) {
+                        raizes.push_back((*statmt_print)->expr);
+                    }
+                }
+            }
+        }
+
+        /*
+        Métodos auxiliares que criam os nós das variáveis sintéticas:
+        a declaração 'var $tN = inicial;' (adicionada ao fim de
+        'antes'), a leitura '$tN' e a atualização '$tN = $tN + passo;'.
+        */
+        inline const node::NewVar* criar_var(node::Expr* inicial, std::vector<node::Statmt*>& antes) {
+            auto new_var = m_alloc.alloc<node::NewVar>();
+            new_var->token_identif = {.tipo = TipoToken::identif, .valor = "$t" + std::to_string(m_num_sinteticas++)};
+            new_var->expr = inicial;
+            new_var->id_var = m_num_vars++;
+            auto statmt_var = m_alloc.alloc<node::StatmtVar>();
+            statmt_var->variant_var = new_var;
+            auto statmt = m_alloc.alloc<node::Statmt>();
+            statmt->variant_statmt = statmt_var;
+            antes.push_back(statmt);
+            return new_var;
+        }
+
+        static inline node::Term criar_leitura(const node::NewVar* sintetica) {
+            return node::Term {.variant_term = node::TermIdentif {.token_identif = sintetica->token_identif, .id_var = sintetica->id_var}};
+        }
+
+        inline node::Statmt* criar_incremento(const node::NewVar* sintetica, int64_t passo) {
+            auto leitura = m_alloc.alloc<node::Expr>();
+            leitura->variant_expr = criar_leitura(sintetica);
+            auto literal = m_alloc.alloc<node::Expr>();
+            literal->variant_expr = node::Term {.variant_term = node::TermIntLit {.token_int = {.tipo = TipoToken::int_lit, .valor_int = passo}}};
+            auto soma = m_alloc.alloc<node::Expr>();
+            soma->variant_expr = node::BinExpr {.token = {.tipo = TipoToken::mais}, .lado_esquerdo = leitura, .lado_direito = literal};
+            auto reass_var = m_alloc.alloc<node::ReassVar>();
+            reass_var->token_identif = sintetica->token_identif;
+            reass_var->expr = soma;
+            reass_var->id_var = sintetica->id_var;
+            auto statmt_var = m_alloc.alloc<node::StatmtVar>();
+            statmt_var->variant_var = reass_var;
+            auto statmt = m_alloc.alloc<node::Statmt>();
+            statmt->variant_statmt = statmt_var;
+            return statmt;
+        }
+
+        /*
+        Métodos auxiliares sobre expressões: o id da variável lida
+        por um identificador (ou SEM_POS caso não seja um) e se a
+        expressão é trivial (literal ou identificador, que não vale
+        a pena mover).
+        */
+        static inline uint32_t le_var(const node::Expr* expr) {
+            if (auto term = std::get_if<node::Term>(&expr->variant_expr)) {
+                if (auto term_identif = std::get_if<node::TermIdentif>(&term->variant_term)) {
+                    return term_identif->id_var;
+                }
+            }
+            return SEM_POS;
+        }
+
+        static inline bool eh_trivial(const node::Expr* expr) {
+            return eh_literal(expr) != nullptr || le_var(expr) != SEM_POS;
+        }
+
+        /*
+        Método que retorna a expressão de um 'exit' ou de um 'return',
+        statements depois dos quais nada do mesmo corpo é executado.
+        */
+        static inline node::Expr* expr_saida(const node::Statmt* statmt) {
+            if (auto statmt_exit = std::get_if<node::StatmtExit*>(&statmt->variant_statmt)) {
+                return (*statmt_exit)->expr;
+            }
+            return std::get<node::StatmtReturn*>(statmt->variant_statmt)->expr;
+        }
+
+        /*
+        Método que percorre o programa (ou o corpo de uma função) de trás para frente mantendo
+        o conjunto de variáveis vivas (que ainda serão lidas antes de
+        serem sobrescritas), e remove os statements mortos. Cada
+        escopo é processado do último para o primeiro statement, com
+        uma pilha explícita. O corpo de um 'if' ou 'while' pode não ser
+        executado: as variáveis que ele mata são anotadas em m_log e
+        voltam a ficar vivas ao final do corpo. Num 'while', tudo o que
+        é lido dentro do loop já está vivo no fim do corpo (a próxima
+        iteração pode ler), o que dispensa iterar a análise até um
+        ponto fixo.
+        PARÂMETROS:
+        - statmts (std::vector<node::Statmt*>&): statements do programa
+        principal ou do corpo de uma função.
+        RETURNS:
+        */
+        inline void eliminar_mortos(std::vector<node::Statmt*>& statmts) {
+            struct Quadro {
+                std::vector<node::Statmt*>* lista;
+                size_t i;
+                node::Statmt** slot; // posição do statement dono do escopo na lista pai
+                const node::Expr* condicao; // condição do dono do escopo, caso seja o corpo de um 'if' ou 'while'
+                bool laco;
+                size_t base_log;
+            };
+            std::vector<Quadro> pilha {{.lista = &statmts, .i = statmts.size(), .slot = nullptr, .condicao = nullptr, .laco = false, .base_log = 0}};
+
+            while (!pilha.empty()) {
+                Quadro& quadro = pilha.back();
+                if (quadro.i == 0) {
+                    std::erase(*quadro.lista, nullptr);
+                    bool vazio = quadro.lista->empty();
+                    if (quadro.condicao != nullptr) {
+                        for (size_t k = quadro.base_log; k < m_log.size(); k++) {
+                            marcar_viva(m_log[k]);
+                        }
+                        m_log.resize(quadro.base_log);
+                        m_corpos_abertos--;
+                        // um 'while' vazio ainda pode nunca terminar, então só o 'if' é removido
+                        if (vazio && !quadro.laco && eh_pura(quadro.condicao)) {
+                            *quadro.slot = nullptr;
+                        } else {
+                            usar_expr(quadro.condicao);
+                        }
+                    } else if (vazio && quadro.slot != nullptr) {
+                        *quadro.slot = nullptr;
+                    }
+                    pilha.pop_back();
+                    continue;
+                }
+                quadro.i--;
+                node::Statmt*& statmt = (*quadro.lista)[quadro.i];
+                if (std::holds_alternative<node::StatmtExit*>(statmt->variant_statmt) || std::holds_alternative<node::StatmtReturn*>(statmt->variant_statmt)) {
+                    // nada depois do 'exit' (ou do 'return') é executado
+                    while (!m_vivas.empty()) {
+                        marcar_morta(m_vivas.back());
+                    }
+                    usar_expr(expr_saida(statmt));
+                } else if (auto statmt_var = std::get_if<node::StatmtVar*>(&statmt->variant_statmt)) {
+                    if (!manter_var(*statmt_var)) {
+                        statmt = nullptr;
+                    }
+                } else if (auto statmt_index = std::get_if<node::StatmtIndex*>(&statmt->variant_statmt)) {
+                    // o conteúdo dos arrays não é analisado: toda escrita é mantida
+                    usar_expr((*statmt_index)->expr);
+                    usar_expr((*statmt_index)->indice);
+                } else if (auto statmt_print = std::get_if<node::StatmtPrint*>(&statmt->variant_statmt)) {
+                    usar_expr((*statmt_print)->expr);
+                } else if (auto scope = std::get_if<node::Scope*>(&statmt->variant_statmt)) {
+                    std::vector<node::Statmt*>& lista = (*scope)->statmts_scope;
+                    pilha.push_back({.lista = &lista, .i = lista.size(), .slot = &statmt, .condicao = nullptr, .laco = false, .base_log = 0});
+                } else if (auto statmt_if = std::get_if<node::StatmtIf*>(&statmt->variant_statmt)) {
+                    std::vector<node::Statmt*>& lista = (*statmt_if)->scope->statmts_scope;
+                    m_corpos_abertos++;
+                    pilha.push_back({.lista = &lista, .i = lista.size(), .slot = &statmt, .condicao = (*statmt_if)->expr, .laco = false, .base_log = m_log.size()});
+                } else if (auto statmt_while = std::get_if<node::StatmtWhile*>(&statmt->variant_statmt)) {
+                    std::vector<node::Statmt*>& lista = (*statmt_while)->scope->statmts_scope;
+                    std::vector<node::Expr*> raizes;
+                    percorrer_laco(*statmt_while, raizes);
+                    for (const node::Expr* raiz : raizes) {
+                        marcar_lidas(raiz);
+                    }
+                    m_corpos_abertos++;
+                    pilha.push_back({.lista = &lista, .i = lista.size(), .slot = &statmt, .condicao = (*statmt_while)->expr, .laco = true, .base_log = m_log.size()});
+                }
+            }
+        }
+
+        /*
+        Método que decide se uma declaração ou atribuição de variável
+        deve ser mantida, atualizando as variáveis vivas. Uma atribuição
+        é morta quando a variável não está viva depois dela. Uma
+        declaração morta é removida se a variável nunca é lida; caso
+        contrário, apenas o seu valor inicial é trocado por 0.
+        PARÂMETROS:
+        - statmt_var (node::StatmtVar*): nó do statement.
+        RETURNS:
+        - (bool): verdadeiro caso o statement deva ser mantido.
+        */
+        inline bool manter_var(node::StatmtVar* statmt_var) {
+            if (auto new_var = std::get_if<node::NewVar*>(&statmt_var->variant_var)) {
+                uint32_t id = (*new_var)->id_var;
+                bool viva = m_pos[id] != SEM_POS;
+                marcar_morta(id);
+                if (viva || !eh_pura((*new_var)->expr)) {
+                    usar_expr((*new_var)->expr);
+                    return true;
+                }
+                if (m_usos[id] == 0) {
+                    return false;
+                }
+                if (!eh_literal((*new_var)->expr)) {
+                    (*new_var)->expr->variant_expr = node::Term {.variant_term = node::TermIntLit {
+                        .token_int = {.tipo = TipoToken::int_lit, .valor_int = 0, .offset = (*new_var)->token_identif.offset}
+                    }};
+                }
+                return true;
+            }
+            node::ReassVar* reass_var = std::get<node::ReassVar*>(statmt_var->variant_var);
+            uint32_t id = reass_var->id_var;
+            if (m_pos[id] == SEM_POS && eh_pura(reass_var->expr)) {
+                return false;
+            }
+            marcar_morta(id);
+            m_usos[id]++; // a atribuição fica, então a declaração também precisa ficar
+            usar_expr(reass_var->expr);
+            return true;
+        }
+
+        /*
+        Método que marca como vivas todas as variáveis lidas por uma
+        expressão que será mantida no programa.
+        PARÂMETROS:
+        - expr (const node::Expr*): nó da expressão.
+        RETURNS:
+        */
+        inline void usar_expr(const node::Expr* expr) {
+            marcar_lidas(expr, true);
+        }
+
+        /*
+        Método que marca como vivas as variáveis lidas por uma expressão.
+        PARÂMETROS:
+        - expr (const node::Expr*): nó da expressão.
+        - contar (bool): se verdadeiro, também conta as leituras em
+        m_usos (ou seja, a expressão certamente fica no programa).
+        RETURNS:
+        */
+        inline void marcar_lidas(const node::Expr* expr, bool contar = false) {
+            std::vector<const node::Expr*> pilha {expr};
+            while (!pilha.empty()) {
+                const node::Expr* atual = pilha.back();
+                pilha.pop_back();
+                if (auto bin_expr = std::get_if<node::BinExpr>(&atual->variant_expr)) {
+                    pilha.push_back(bin_expr->lado_esquerdo);
+                    pilha.push_back(bin_expr->lado_direito);
+                    continue;
+                }
+                const node::Term& term = std::get<node::Term>(atual->variant_expr);
+                if (auto term_paren = std::get_if<node::TermParen>(&term.variant_term)) {
+                    pilha.push_back(term_paren->expr);
+                } else if (auto term_identif = std::get_if<node::TermIdentif>(&term.variant_term)) {
+                    marcar_viva(term_identif->id_var);
+                    if (contar) {
+                        m_usos[term_identif->id_var]++;
+                    }
+                } else if (auto term_call = std::get_if<node::TermCall>(&term.variant_term)) {
+                    pilha.insert(pilha.end(), term_call->args.begin(), term_call->args.end());
+                } else if (auto term_index = std::get_if<node::TermIndex>(&term.variant_term)) {
+                    pilha.push_back(term_index->indice);
+                }
+            }
+        }
+
+        /*
+        Método que verifica se uma expressão pode ser removida sem
+        mudar o comportamento do programa, ou seja, se ela não tem
+        nenhuma divisão que possa falhar (divisor que não seja um
+        literal diferente de 0), nem chamadas de função, nem acessos
+        a arrays que ainda precisam ser verificados.
+        PARÂMETROS:
+        - expr (const node::Expr*): nó da expressão.
+        RETURNS:
+        - (bool): verdadeiro caso a expressão possa ser removida.
+        */
+        static inline bool eh_pura(const node::Expr* expr) {
+            std::vector<const node::Expr*> pilha {expr};
+            while (!pilha.empty()) {
+                const node::Expr* atual = pilha.back();
+                pilha.pop_back();
+                if (auto bin_expr = std::get_if<node::BinExpr>(&atual->variant_expr)) {
+                    if (bin_expr->token.tipo == TipoToken::barra_div && !eh_literal_nao_nulo(bin_expr->lado_direito)) {
+                        return false;
+                    }
+                    pilha.push_back(bin_expr->lado_esquerdo);
+                    pilha.push_back(bin_expr->lado_direito);
+                } else if (auto term_paren = std::get_if<node::TermParen>(&std::get<node::Term>(atual->variant_expr).variant_term)) {
+                    pilha.push_back(term_paren->expr);
+                } else if (std::holds_alternative<node::TermCall>(std::get<node::Term>(atual->variant_expr).variant_term)) {
+                    return false;
+                } else if (auto term_index = std::get_if<node::TermIndex>(&std::get<node::Term>(atual->variant_expr).variant_term)) {
+                    if (term_index->checar) {
+                        return false;
+                    }
+                    pilha.push_back(term_index->indice);
+                }
+            }
+            return true;
+        }
+
+        static inline const node::TermIntLit* eh_literal(const node::Expr* expr) {
+            if (auto term = std::get_if<node::Term>(&expr->variant_expr)) {
+                return std::get_if<node::TermIntLit>(&term->variant_term);
+            }
+            return nullptr;
+        }
+
+        static inline bool eh_literal_nao_nulo(const node::Expr* expr) {
+            const node::TermIntLit* term_int_lit = eh_literal(expr);
+            return term_int_lit != nullptr && term_int_lit->token_int.valor_int != 0;
+        }
+
+        /*
+        Métodos que adicionam e removem uma variável do conjunto
+        de variáveis vivas, em O(1). Remoções feitas dentro do corpo
+        de um 'if' ou 'while' são anotadas em m_log para serem desfeitas.
+        */
+        inline void marcar_viva(uint32_t id) {
+            if (m_pos[id] == SEM_POS) {
+                m_pos[id] = static_cast<uint32_t>(m_vivas.size());
+                m_vivas.push_back(id);
+            }
+        }
+
+        inline void marcar_morta(uint32_t id) {
+            uint32_t pos = m_pos[id];
+            if (pos == SEM_POS) {
+                return;
+            }
+            m_pos[m_vivas.back()] = pos;
+            m_vivas[pos] = m_vivas.back();
+            m_vivas.pop_back();
+            m_pos[id] = SEM_POS;
+            if (m_corpos_abertos > 0) {
+                m_log.push_back(id);
+            }
+        }
+};
@@ -13,7 +13,6 @@ implementação da árvore de parsing. Cada nó representa
 uma expressão sintática da linguagem (.ml)
 */
 namespace node {
-    struct BinExpr;
     struct Expr;
     struct Statmt;
 
@@ -23,18 +22,32 @@ namespace node {
 
     struct TermIdentif {
         Token token_identif;
+        uint32_t id_var = 0; // variável referenciada, preenchido pelo Otimizador
     };
     
     struct TermParen {
         node::Expr *expr;
     };
 
-    struct Term {
-        std::variant<node::TermIntLit*, node::TermIdentif*, node::TermParen*> variant_term;
+    struct TermCall {
+        Token token_identif;
+        std::vector<node::Expr*> args;
     };
 
-    struct Expr {
-        std::variant<node::Term*, node::BinExpr*> variant_expr;
+    /*
+    Leitura de um elemento de array. 'checar' indica se o índice
+    precisa ser verificado em tempo de execução; o Otimizador o
+    desliga quando prova que o índice está dentro dos limites.
+    */
+    struct TermIndex {
+        Token token_identif;
+        node::Expr* indice;
+        uint32_t id_var = 0;
+        bool checar = true;
+    };
+
+    struct Term {
+        std::variant<node::TermIntLit, node::TermIdentif, node::TermParen, node::TermCall, node::TermIndex> variant_term;
     };
 
     struct BinExpr {
@@ -43,6 +56,15 @@ namespace node {
         node::Expr* lado_direito;
     };
 
+    /*
+    Termos e expressões binárias são guardados por valor dentro
+    do nó Expr, de modo que cada termo e cada operação custam uma
+    única alocação na arena.
+    */
+    struct Expr {
+        std::variant<node::Term, node::BinExpr> variant_expr;
+    };
+
     struct StatmtExit {
         node::Expr* expr;
     };
@@ -50,212 +72,330 @@ namespace node {
     struct NewVar {
         Token token_identif;
         node::Expr* expr;
+        uint32_t id_var = 0;
     };
 
     struct ReassVar {
         Token token_identif;
         node::Expr *expr;
+        uint32_t id_var = 0;
     };
 
     struct StatmtVar {
         std::variant<node::NewVar*, node::ReassVar*> variant_var;
     };
 
+    /*
+    'contador' numera, na ordem do código fonte, os escopos e
+    os 'ifs' do programa. É a posição do contador de execuções
+    do nó no perfil (checar perfil.hpp), e por isso não depende
+    das otimizações aplicadas depois do parser.
+    */
     struct Scope {
         std::vector<node::Statmt*> statmts_scope;
+        uint32_t contador = 0;
     };
 
     struct StatmtIf {
         node::Expr* expr;
         node::Scope* scope;
+        uint32_t contador = 0;
+    };
+
+    /*
+    'vetorizar' é marcado pelo Otimizador quando o loop percorre
+    arrays elemento a elemento e pode ser gerado com instruções
+    SIMD (checar Generator::generate_while_vetorial).
+    */
+    struct StatmtWhile {
+        node::Expr* expr;
+        node::Scope* scope;
+        bool vetorizar = false;
+    };
+
+    struct StatmtReturn {
+        Token token_return;
+        node::Expr* expr;
+    };
+
+    /*
+    Escrita de um inteiro, seguido de uma quebra de linha, na
+    saída padrão: 'print(expr);'.
+    */
+    struct StatmtPrint {
+        node::Expr* expr;
+    };
+
+    /*
+    Declaração de um array de 'int' com tamanho fixo, alocado
+    na stack e iniciado com zeros: 'var a[N];'.
+    */
+    struct StatmtArray {
+        Token token_identif;
+        Token token_tamanho;
+        uint32_t id_var = 0;
+    };
+
+    /*
+    Atribuição a um elemento de array: 'a[indice] = expr;'.
+    */
+    struct StatmtIndex {
+        Token token_identif;
+        node::Expr* indice;
+        node::Expr* expr;
+        uint32_t id_var = 0;
+        bool checar = true;
     };
     
     struct Statmt {
-        std::variant<node::StatmtVar*, node::StatmtExit*, node::Scope*, node::StatmtIf*> variant_statmt;
+        std::variant<node::StatmtVar*, node::StatmtExit*, node::Scope*, node::StatmtIf*, node::StatmtWhile*, node::StatmtReturn*,
+            node::StatmtArray*, node::StatmtIndex*, node::StatmtPrint*> variant_statmt;
     };
 
+    struct Function {
+        Token token_identif;
+        std::vector<Token> params;
+        node::Scope* scope;
+    };
+
+    /*
+    Os statements fora de funções formam o corpo de '_start'. As
+    funções só podem ser declaradas nesse nível, e podem ser
+    chamadas de qualquer ponto do programa. 'usa_print' indica
+    se o programa contém algum 'print', e portanto precisa do
+    buffer de saída (checar Generator::generate_runtime_print).
+    'num_contadores' é o número de escopos e 'ifs' numerados.
+    */
     struct Program {
         std::vector<node::Statmt*> statmts;
+        std::vector<node::Function*> funcoes;
+        bool usa_print = false;
+        uint32_t num_contadores = 0;
     };
 };
 
 
 class Parser {
     public:
-        inline Parser(std::vector<Token> tokens) 
-            : m_tokens(std::move(tokens)), m_alloc(1024 * 1024 * 4) //member initialization list
+        /*
+        O parser não possui a arena: ela é recebida por referência
+        para que possa ser reaproveitada entre compilações (checar
+        mlc::Compiler). Os nós da AST vivem enquanto a arena viver.
+        */
+        inline Parser(std::vector<Token> tokens, ArenaAlloc& alloc)
+            : m_tokens(std::move(tokens)), m_alloc(alloc) //member initialization list
         {}
 
         /*
-        Método responsável pelo parseamento dos possíveis termos na 
-        sintaxe da linguagem (checar grammar.md). Assim, realiza as 
-        alocações necessárias para cada tipo através de 'ifs' e checa 
-        procura erros de sintaxe.
+        Método responsável pelo parseamento dos termos simples na
+        sintaxe da linguagem (checar grammar.md): literais inteiros
+        e identificadores. Termos entre parênteses e chamadas de
+        função são tratados por parse_expr, que mantém a sua própria
+        pilha explícita.
         PARÂMETROS:
         RETURNS:
-        - term (std::optional<node::Term*>): um std::optional para um
-        ponteiro do nó "Term"que, por sua vez, contêm um std::variant 
-        com os tipos possíveis de termos (checar grammar.md)
+        - expr (std::optional<node::Expr*>): um std::optional para
+        a expressão que contêm o termo (checar grammar.md), ou vazio
+        caso o próximo token não seja um termo simples.
         */
-        inline std::optional<node::Term*> parse_term() {
-            auto term = m_alloc.alloc<node::Term>();
-            if (peek().has_value()) {
-                if (peek().value().tipo == TipoToken::int_lit) {
-                    auto term_int_lit = m_alloc.alloc<node::TermIntLit>();
-                    term_int_lit->token_int = consume();
-                    term->variant_term = term_int_lit;
-                } else if (peek().value().tipo == TipoToken::identif) {
-                    auto term_identif = m_alloc.alloc<node::TermIdentif>();
-                    term_identif->token_identif = consume();
-                    term->variant_term = term_identif;
-                } else if (peek().value().tipo == TipoToken::parenteses_abre) {
-                    consume();
-                    auto expr = parse_expr();
-                    if (!expr.has_value()) {
-                        std::cerr << "Expressão inválida." << std::endl;
-                        exit(EXIT_FAILURE);
-                    }
-                    try_consume(TipoToken::parenteses_fecha, "Esperava-se ')' ao final da expressão.");
-                    auto term_paren = m_alloc.alloc<node::TermParen>();
-                    term_paren->expr = expr.value();
-                    term->variant_term = term_paren;
-                }
+        inline std::optional<node::Expr*> parse_term() {
+            std::optional<TipoToken> tipo = peek_tipo();
+            node::Term term;
+            if (tipo == TipoToken::int_lit) {
+                term.variant_term = node::TermIntLit {.token_int = consume()};
+            } else if (tipo == TipoToken::identif) {
+                term.variant_term = node::TermIdentif {.token_identif = consume()};
+            } else {
+                return {};
             }
-            return term;
+            auto expr = m_alloc.alloc<node::Expr>();
+            expr->variant_expr = std::move(term);
+            return expr;
         }
 
         /*
-        TODO: documentacao
+        Método responsável pelo parseamento de expressões através de
+        um parser de Pratt guiado pela tabela de operadores
+        (TABELA_OPERADORES, em tokenization.hpp): a precedência e a
+        associatividade de cada operador vêm da tabela, e não de um
+        switch por operador.
         https://eli.thegreenplace.net/2012/08/02/parsing-expressions-by-precedence-climbing
+        Em vez de uma chamada recursiva por operador, por parênteses e
+        por chamada de função, o estado de cada nível (lado esquerdo,
+        operador pendente e precedência mínima) é guardado numa pilha
+        explícita alocada no heap. Assim, a profundidade de aninhamento da expressão é
+        limitada apenas pela memória, e não pela stack nativa. Cada
+        expressão binária é construída uma única vez, quando os seus
+        dois lados estão prontos.
+        PARÂMETROS:
+        RETURNS:
+        - expr (std::optional<node::Expr*>): nó da expressão, ou vazio
+        caso não exista um termo no início da expressão.
         */
-        inline std::optional<node::Expr*> parse_expr(int min_prec = 0) {
-            auto term_esquerda = parse_term();
-            if (!term_esquerda.has_value()) {
-                return {};
-            }
-            auto expr_esquerda = m_alloc.alloc<node::Expr>();
-            expr_esquerda->variant_expr = term_esquerda.value();
+        inline std::optional<node::Expr*> parse_expr() {
+            struct Quadro {
+                enum Tipo { binario, parenteses, chamada, indice } tipo;
+                node::Expr* esquerda; // lado esquerdo do operador, ou a expressão da chamada (ou do acesso ao array)
+                Token operador;
+                int min_prec;
+            };
+            std::vector<Quadro> pilha;
+            int min_prec = 0;
 
             while (true) {
-                std::optional<Token> token_atual = peek();
-                std::optional<int> prec;
-                if (token_atual.has_value()) {
-                    prec = bin_prec(token_atual.value().tipo);
-                    if (!prec.has_value() || prec < min_prec) {
-                        break;
+                node::Expr* expr = nullptr;
+                while (expr == nullptr) {
+                    if (peek_tipo() == TipoToken::parenteses_abre) {
+                        consume();
+                        pilha.push_back({.tipo = Quadro::parenteses, .esquerda = nullptr, .operador = {}, .min_prec = min_prec});
+                        min_prec = 0;
+                    } else if (peek_tipo() == TipoToken::identif && peek(1).has_value() && peek(1).value().tipo == TipoToken::parenteses_abre) {
+                        // chamada de função: cada argumento é parseado como o conteúdo de um parênteses
+                        auto chamada = m_alloc.alloc<node::Expr>();
+                        chamada->variant_expr = node::Term {.variant_term = node::TermCall {.token_identif = consume(), .args = {}}};
+                        consume();
+                        if (peek_tipo() == TipoToken::parenteses_fecha) {
+                            consume();
+                            expr = chamada;
+                        } else {
+                            pilha.push_back({.tipo = Quadro::chamada, .esquerda = chamada, .operador = {}, .min_prec = min_prec});
+                            min_prec = 0;
+                        }
+                    } else if (peek_tipo() == TipoToken::identif && peek(1).has_value() && peek(1).value().tipo == TipoToken::colchetes_abre) {
+                        // acesso a um elemento de array: o índice é parseado como o conteúdo de um parênteses
+                        auto acesso = m_alloc.alloc<node::Expr>();
+                        acesso->variant_expr = node::Term {.variant_term = node::TermIndex {.token_identif = consume(), .indice = nullptr}};
+                        consume();
+                        pilha.push_back({.tipo = Quadro::indice, .esquerda = acesso, .operador = {}, .min_prec = min_prec});
+                        min_prec = 0;
+                    } else if (auto term = parse_term()) {
+                        expr = term.value();
+                    } else if (pilha.empty()) {
+                        return {};
+                    } else if (pilha.back().tipo != Quadro::binario) {
+                        erro("Expressão inválida.");
+                    } else {
+                        erro("Expressão inválida. Esperava-se um termo após o operador.");
                     }
-                } else {
-                    break;
                 }
-                Token operador = consume();
-                auto expr_direita = parse_expr(prec.value() + 1);
-                if (!expr_direita.has_value()) {
-                    std::cerr << "Expressão inválida. Esperava-se um termo após o operador." << std::endl;
-                    exit(EXIT_FAILURE);
-                } 
-                auto bin_expr = m_alloc.alloc<node::BinExpr>();
-                auto expr_esquerda_temp = m_alloc.alloc<node::Expr>();
-                expr_esquerda_temp->variant_expr = expr_esquerda->variant_expr;
-                switch (operador.tipo) {
-                    case TipoToken::mais:
-                        {
-                            // auto bin_expr_soma = m_alloc.alloc<node::BinExprSoma>();
-                            // bin_expr_soma->lado_esquerdo = expr_esquerda_temp;
-                            // bin_expr_soma->lado_direito = expr_direita.value();
-                            // bin_expr->variant_bin_expr = bin_expr_soma;
-                            bin_expr->token = {.tipo = TipoToken::mais};
-                            bin_expr->lado_esquerdo = expr_esquerda_temp;
-                            bin_expr->lado_direito = expr_direita.value();
-                        }
-                        break;
-                    case TipoToken::menos:
-                        {
-                            // auto bin_expr_sub = m_alloc.alloc<node::BinExprSub>();
-                            // bin_expr_sub->lado_esquerdo = expr_esquerda_temp;
-                            // bin_expr_sub->lado_direito = expr_direita.value();
-                            // bin_expr->variant_bin_expr = bin_expr_sub;
-                            bin_expr->token = {.tipo = TipoToken::menos};
-                            bin_expr->lado_esquerdo = expr_esquerda_temp;
-                            bin_expr->lado_direito = expr_direita.value();
-                        }
-                        break;
-                    case TipoToken::asterisco:
-                        {
-                            // auto bin_expr_multi = m_alloc.alloc<node::BinExprMulti>();
-                            // bin_expr_multi->lado_esquerdo = expr_esquerda_temp;
-                            // bin_expr_multi->lado_direito = expr_direita.value();
-                            // bin_expr->variant_bin_expr = bin_expr_multi;
-                            bin_expr->token = {.tipo = TipoToken::asterisco};
-                            bin_expr->lado_esquerdo = expr_esquerda_temp;
-                            bin_expr->lado_direito = expr_direita.value();
-                        }
-                        break;
-                    case TipoToken::barra_div:
-                        {
-                            // auto bin_expr_div = m_alloc.alloc<node::BinExprDiv>();
-                            // bin_expr_div->lado_esquerdo = expr_esquerda_temp;
-                            // bin_expr_div->lado_direito = expr_direita.value();
-                            // bin_expr->variant_bin_expr = bin_expr_div;
-                            bin_expr->token = {.tipo = TipoToken::barra_div};
-                            bin_expr->lado_esquerdo = expr_esquerda_temp;
-                            bin_expr->lado_direito = expr_direita.value();
-                        }
-                        break;
-                    case TipoToken::maior:
-                        {
-                            // auto bin_expr_maior = m_alloc.alloc<node::BinExprComp>();
-                            // bin_expr_maior->lado_esquerdo = expr_esquerda_temp;
-                            // bin_expr_maior->lado_direito = expr_direita.value();
-                            // bin_expr_maior->valor = 'a';
-                            // bin_expr->variant_bin_expr = bin_expr_maior;
-                            bin_expr->token = {.tipo = TipoToken::maior};
-                            bin_expr->lado_esquerdo = expr_esquerda_temp;
-                            bin_expr->lado_direito = expr_direita.value();
-                        }
-                        break;
-                    case TipoToken::menor:
-                        {
-                            // auto bin_expr_menor = m_alloc.alloc<node::BinExprComp>();
-                            // bin_expr_menor->lado_esquerdo = expr_esquerda_temp;
-                            // bin_expr_menor->lado_direito = expr_direita.value();
-                            // bin_expr_menor->valor = 'b';
-                            // bin_expr->variant_bin_expr = bin_expr_menor;
-                            bin_expr->token = {.tipo = TipoToken::menor};
-                            bin_expr->lado_esquerdo = expr_esquerda_temp;
-                            bin_expr->lado_direito = expr_direita.value();
-                        }
-                        break;
-                    case TipoToken::maior_igual:
-                        {
-                            bin_expr->token = {.tipo = TipoToken::maior_igual};
-                            bin_expr->lado_esquerdo = expr_esquerda_temp;
-                            bin_expr->lado_direito = expr_direita.value();
-                        }
+
+                while (true) {
+                    const InfoOperador* info = nullptr;
+                    if (std::optional<TipoToken> tipo = peek_tipo(); tipo.has_value() && info_operador(tipo.value()).has_value()) {
+                        info = &info_operador(tipo.value()).value();
+                    }
+                    if (info != nullptr && info->prec >= min_prec) {
+                        pilha.push_back({.tipo = Quadro::binario, .esquerda = expr, .operador = consume(), .min_prec = min_prec});
+                        min_prec = info->assoc == Assoc::esquerda ? info->prec + 1 : info->prec;
                         break;
-                    case TipoToken::menor_igual:
-                        {
-                            bin_expr->token = {.tipo = TipoToken::menor_igual};
-                            bin_expr->lado_esquerdo = expr_esquerda_temp;
-                            bin_expr->lado_direito = expr_direita.value();
+                    }
+                    if (pilha.empty()) {
+                        return expr;
+                    }
+                    Quadro& quadro = pilha.back();
+                    if (quadro.tipo == Quadro::chamada) {
+                        auto& call = std::get<node::TermCall>(std::get<node::Term>(quadro.esquerda->variant_expr).variant_term);
+                        call.args.push_back(expr);
+                        if (peek_tipo() == TipoToken::virgula) {
+                            consume();
+                            break; // próximo argumento, ainda dentro da mesma chamada
                         }
-                        break;
+                        try_consume(TipoToken::parenteses_fecha, "Esperava-se ',' ou ')' nos argumentos da função.");
+                        min_prec = quadro.min_prec;
+                        expr = quadro.esquerda;
+                        pilha.pop_back();
+                        continue;
+                    }
+                    min_prec = quadro.min_prec;
+                    if (quadro.tipo == Quadro::indice) {
+                        try_consume(TipoToken::colchetes_fecha, "Esperava-se ']' após o índice do array.");
+                        std::get<node::TermIndex>(std::get<node::Term>(quadro.esquerda->variant_expr).variant_term).indice = expr;
+                        expr = quadro.esquerda;
+                        pilha.pop_back();
+                        continue;
+                    }
+                    node::Expr* expr_pai = m_alloc.alloc<node::Expr>();
+                    if (quadro.tipo == Quadro::parenteses) {
+                        try_consume(TipoToken::parenteses_fecha, "Esperava-se ')' ao final da expressão.");
+                        expr_pai->variant_expr = node::Term {.variant_term = node::TermParen {.expr = expr}};
+                    } else {
+                        expr_pai->variant_expr = node::BinExpr {
+                            .token = std::move(quadro.operador),
+                            .lado_esquerdo = quadro.esquerda,
+                            .lado_direito = expr
+                        };
+                    }
+                    pilha.pop_back();
+                    expr = expr_pai;
                 }
-                expr_esquerda->variant_expr = bin_expr;
             }
-            return expr_esquerda;
         }
 
         /*
-        TODO: documentação
+        Método responsável pelo parseamento de um escopo ('{' seguido
+        de statements e '}').
+        PARÂMETROS:
+        RETURNS:
+        - scope (std::optional<node::Scope*>): nó do escopo.
         */
         inline std::optional<node::Scope*> parse_scope() {
-                    try_consume(TipoToken::chaves_abre, "Erro de sintaxe. Esperava-se um '{' após a expressão.");
-                    auto scope = m_alloc.alloc<node::Scope>();
-                    while (auto statmt = parse_statmt()) {
-                        scope->statmts_scope.push_back(statmt.value());
+            try_consume(TipoToken::chaves_abre, "Erro de sintaxe. Esperava-se um '{' após a expressão.");
+            auto scope = m_alloc.alloc<node::Scope>();
+            scope->contador = m_num_contadores++;
+            parse_statmts(scope->statmts_scope, true);
+            return scope;
+        }
+
+        /*
+        Método que parseia uma sequência de statements, guardando-os
+        em 'destino'. Escopos aninhados (blocos e corpos de 'if' e
+        'while') não são parseados recursivamente: cada escopo aberto
+        é empilhado numa pilha explícita e recebe os statements
+        seguintes até o seu '}'. Assim, a profundidade de aninhamento
+        é limitada apenas pela memória.
+        PARÂMETROS:
+        - destino (std::vector<node::Statmt*>&): vetor que recebe os
+        statements do nível mais externo.
+        - ate_chaves (bool): se verdadeiro, 'destino' pertence a um
+        escopo cujo '{' já foi consumido, e o método termina no '}'
+        correspondente. Se falso, termina no fim dos tokens.
+        - funcoes (std::vector<node::Function*>*): caso não seja nulo,
+        recebe as funções declaradas no nível mais externo.
+        RETURNS:
+        */
+        inline void parse_statmts(std::vector<node::Statmt*>& destino, bool ate_chaves, std::vector<node::Function*>* funcoes = nullptr) {
+            std::vector<std::vector<node::Statmt*>*> abertos {&destino};
+            while (true) {
+                if (!peek().has_value()) {
+                    if (ate_chaves || abertos.size() > 1) {
+                        erro("Erro de sintaxe. Esperava-se '}'.");
+                    }
+                    return;
+                }
+                if (peek().value().tipo == TipoToken::chaves_fecha && (ate_chaves || abertos.size() > 1)) {
+                    consume();
+                    abertos.pop_back();
+                    if (abertos.empty()) {
+                        return;
                     }
-                    try_consume(TipoToken::chaves_fecha, "Erro de sintaxe. Esperava-se '}'.");
-                    return scope;
+                    continue;
+                }
+                if (funcoes != nullptr && abertos.size() == 1 && peek().value().tipo == TipoToken::_fn) {
+                    funcoes->push_back(parse_fn());
+                    continue;
+                }
+                node::Scope* bloco = nullptr;
+                if (auto statmt = parse_statmt(bloco)) {
+                    abertos.back()->push_back(statmt.value());
+                    if (bloco != nullptr) {
+                        abertos.push_back(&bloco->statmts_scope);
+                    }
+                } else if (ate_chaves || abertos.size() > 1) {
+                    erro("Erro de sintaxe. Esperava-se '}'.");
+                } else {
+                    erro("Declaração inválida.");
+                }
+            }
         }
 
         /*
@@ -263,12 +403,14 @@ class Parser {
         do arquivo fonte, procurando por erros de sintaxe
         e nós para cada uma das entidades necessárias
         PARÂMETROS:
+        - bloco (node::Scope*&): recebe o escopo, ainda vazio, de
+        statements que abrem um bloco ('{', 'if' e 'while'). O seu conteúdo
+        é preenchido por parse_statmts.
         RETURNS:
-        - exit_node (std::optional<node::Exit>): nó atrelado
-        à expressão de saída do código.
-        TODO: rever pq ta mto feio
+        - statmt (std::optional<node::Statmt*>): nó do statement, ou
+        vazio caso o próximo token não inicie um statement.
         */
-        inline std::optional<node::Statmt*> parse_statmt() {
+        inline std::optional<node::Statmt*> parse_statmt(node::Scope*& bloco) {
             if (peek().has_value() && peek().value().tipo == TipoToken::_exit) { // função de saída do programa
                 consume();
                 auto statmt_exit = m_alloc.alloc<node::StatmtExit>();
@@ -276,14 +418,46 @@ class Parser {
                 if (auto node_expr = parse_expr()) {
                     statmt_exit->expr = node_expr.value();
                 } else {
-                    std::cerr << "Expressão inválida. A função 'exit' deve conter uma expressão 'int_lit' ou um identificador." << std::endl;
-                    exit(EXIT_FAILURE);
+                    erro("Expressão inválida. A função 'exit' deve conter uma expressão 'int_lit' ou um identificador.");
                 }
                 try_consume(TipoToken::parenteses_fecha, "Erro de sintaxe. Esperava-se ')' ao final da função.");
                 try_consume(TipoToken::ponto_virgula, "Erro de sintaxe. Esperava-se ';' no final da linha.");
                 auto statmt = m_alloc.alloc<node::Statmt>();
                 statmt->variant_statmt = statmt_exit;
                 return statmt;
+            } else if (peek().has_value() && peek().value().tipo == TipoToken::_print) { // escrita na saída padrão
+                consume();
+                auto statmt_print = m_alloc.alloc<node::StatmtPrint>();
+                try_consume(TipoToken::parenteses_abre, "Erro de sintaxe. A função deve conter '('.");
+                if (auto node_expr = parse_expr()) {
+                    statmt_print->expr = node_expr.value();
+                } else {
+                    erro("Expressão inválida. A função 'print' deve conter uma expressão.");
+                }
+                try_consume(TipoToken::parenteses_fecha, "Erro de sintaxe. Esperava-se ')' ao final da função.");
+                try_consume(TipoToken::ponto_virgula, "Erro de sintaxe. Esperava-se ';' no final da linha.");
+                m_usa_print = true;
+                auto statmt = m_alloc.alloc<node::Statmt>();
+                statmt->variant_statmt = statmt_print;
+                return statmt;
+            } else if (peek().has_value() && peek().value().tipo == TipoToken::var
+                && peek(2).has_value() && peek(2).value().tipo == TipoToken::colchetes_abre) { // declaração de array
+                consume();
+                auto statmt_array = m_alloc.alloc<node::StatmtArray>();
+                statmt_array->token_identif = try_consume(TipoToken::identif, "Declaração inválida. Um array precisa de um identificador.");
+                consume();
+                statmt_array->token_tamanho = try_consume(TipoToken::int_lit, "O tamanho de um array deve ser um inteiro literal.");
+                if (statmt_array->token_tamanho.valor_int <= 0 || statmt_array->token_tamanho.valor_int > TAMANHO_MAX_ARRAY) {
+                    throw ErroCompilacao {
+                        .mensagem = "O tamanho de um array deve estar entre 1 e " + std::to_string(TAMANHO_MAX_ARRAY) + ".",
+                        .offset = statmt_array->token_tamanho.offset
+                    };
+                }
+                try_consume(TipoToken::colchetes_fecha, "Erro de sintaxe. Esperava-se ']' após o tamanho do array.");
+                try_consume(TipoToken::ponto_virgula, "Erro de sintaxe. Esperava-se ';' no final da linha.");
+                auto statmt = m_alloc.alloc<node::Statmt>();
+                statmt->variant_statmt = statmt_array;
+                return statmt;
             } else if (peek().has_value() && peek().value().tipo == TipoToken::var) { // declaração de nova variável
                 consume();
                 auto statmt_var = m_alloc.alloc<node::StatmtVar>();
@@ -294,18 +468,37 @@ class Parser {
                     if (auto node_expr = parse_expr()) {
                         new_var->expr = node_expr.value();
                     } else {
-                        std::cerr << "Expressão inválida." << std::endl;
-                        exit(EXIT_FAILURE);
+                        erro("Expressão inválida.");
                     }
                     try_consume(TipoToken::ponto_virgula, "Erro de sintaxe. Esperava-se ';' no final da linha.");
                 } else {
-                    std::cerr << "Declaração inválida. Uma variável precisa de um identificador." << std::endl;
-                    exit(EXIT_FAILURE);
+                    erro("Declaração inválida. Uma variável precisa de um identificador.");
                 }
                 statmt_var->variant_var = new_var;
                 auto statmt = m_alloc.alloc<node::Statmt>();
                 statmt->variant_statmt = statmt_var;
                 return statmt;
+            } else if (peek().has_value() && peek().value().tipo == TipoToken::identif
+                && peek(1).has_value() && peek(1).value().tipo == TipoToken::colchetes_abre) { // atribuição a um elemento de array
+                auto statmt_index = m_alloc.alloc<node::StatmtIndex>();
+                statmt_index->token_identif = consume();
+                consume();
+                if (auto indice = parse_expr()) {
+                    statmt_index->indice = indice.value();
+                } else {
+                    erro("Expressão inválida como índice do array.");
+                }
+                try_consume(TipoToken::colchetes_fecha, "Esperava-se ']' após o índice do array.");
+                try_consume(TipoToken::igual, "Erro de sintaxe. Esperava-se '=' após o elemento do array.");
+                if (auto node_expr = parse_expr()) {
+                    statmt_index->expr = node_expr.value();
+                } else {
+                    erro("Expressão inválida.");
+                }
+                try_consume(TipoToken::ponto_virgula, "Erro de sintaxe. Esperava-se ';' no final da linha.");
+                auto statmt = m_alloc.alloc<node::Statmt>();
+                statmt->variant_statmt = statmt_index;
+                return statmt;
             } else if (peek().has_value() && peek().value().tipo == TipoToken::identif) { // realocação de variável
                 auto statmt_var = m_alloc.alloc<node::StatmtVar>();
                 auto reass_var = m_alloc.alloc<node::ReassVar>();
@@ -314,8 +507,7 @@ class Parser {
                 if (auto node_expr = parse_expr()) {
                     reass_var->expr = node_expr.value();
                 } else {
-                    std::cerr << "Expressão inválida." << std::endl;
-                    exit(EXIT_FAILURE);
+                    erro("Expressão inválida.");
                 }
                 try_consume(TipoToken::ponto_virgula, "Erro de sintaxe. Esperava-se ';' no final da linha.");
                 statmt_var->variant_var = reass_var; 
@@ -323,33 +515,60 @@ class Parser {
                 statmt->variant_statmt = statmt_var;
                 return statmt;
             } else if (peek().has_value() && peek().value().tipo == TipoToken::chaves_abre) { // inicialização de novo escopo
-                if (auto scope = parse_scope()) {
-                    auto statmt = m_alloc.alloc<node::Statmt>();
-                    statmt->variant_statmt = scope.value();
-                    return statmt;
-                } else {
-                    std::cerr << "Escopo inválido.";
-                    exit(EXIT_FAILURE);
-                }
+                consume();
+                bloco = m_alloc.alloc<node::Scope>();
+                bloco->contador = m_num_contadores++;
+                auto statmt = m_alloc.alloc<node::Statmt>();
+                statmt->variant_statmt = bloco;
+                return statmt;
             } else if (peek().has_value() && peek().value().tipo == TipoToken::_if) { // início do if
                 consume();
                 try_consume(TipoToken::parenteses_abre, "Esperava-se '(' após expressão 'if'.");
                 auto statmt_if = m_alloc.alloc<node::StatmtIf>();
+                statmt_if->contador = m_num_contadores++;
                 if (auto expr = parse_expr()) {
                     statmt_if->expr = expr.value();
                 } else {
-                    std::cerr << "Expressão inválida como condição da expressão 'if'." << std::endl;
-                    exit(EXIT_FAILURE);
+                    erro("Expressão inválida como condição da expressão 'if'.");
                 }
                 try_consume(TipoToken::parenteses_fecha, "Erro de sintaxe. Esperava-se ')' ao final da expressão.");
-                if (auto scope = parse_scope()) {
-                    statmt_if->scope = scope.value();
+                try_consume(TipoToken::chaves_abre, "Erro de sintaxe. Esperava-se um '{' após a expressão.");
+                bloco = m_alloc.alloc<node::Scope>();
+                bloco->contador = m_num_contadores++;
+                statmt_if->scope = bloco;
+                auto statmt = m_alloc.alloc<node::Statmt>();
+                statmt->variant_statmt = statmt_if;
+                return statmt;
+            } else if (peek().has_value() && peek().value().tipo == TipoToken::_return) { // retorno de função
+                auto statmt_return = m_alloc.alloc<node::StatmtReturn>();
+                statmt_return->token_return = consume();
+                if (auto node_expr = parse_expr()) {
+                    statmt_return->expr = node_expr.value();
+                } else {
+                    erro("Expressão inválida. 'return' deve ser seguido de uma expressão.");
+                }
+                try_consume(TipoToken::ponto_virgula, "Erro de sintaxe. Esperava-se ';' no final da linha.");
+                auto statmt = m_alloc.alloc<node::Statmt>();
+                statmt->variant_statmt = statmt_return;
+                return statmt;
+            } else if (peek().has_value() && peek().value().tipo == TipoToken::_fn) {
+                erro("Funções só podem ser declaradas fora de escopos.");
+            } else if (peek().has_value() && peek().value().tipo == TipoToken::_while) { // início do while
+                consume();
+                try_consume(TipoToken::parenteses_abre, "Esperava-se '(' após expressão 'while'.");
+                auto statmt_while = m_alloc.alloc<node::StatmtWhile>();
+                if (auto expr = parse_expr()) {
+                    statmt_while->expr = expr.value();
                 } else {
-                    std::cerr << "Escopo inválido para expressão 'if'." << std::endl;
-                    exit(EXIT_FAILURE);
+                    erro("Expressão inválida como condição da expressão 'while'.");
                 }
+                try_consume(TipoToken::parenteses_fecha, "Erro de sintaxe. Esperava-se ')' ao final da expressão.");
+                try_consume(TipoToken::chaves_abre, "Erro de sintaxe. Esperava-se um '{' após a expressão.");
+                bloco = m_alloc.alloc<node::Scope>();
+                bloco->contador = m_num_contadores++;
+                statmt_while->scope = bloco;
                 auto statmt = m_alloc.alloc<node::Statmt>();
-                statmt->variant_statmt = statmt_if;
+                statmt->variant_statmt = statmt_while;
                 return statmt;
             } else {
                 return {};
@@ -357,41 +576,108 @@ class Parser {
         }
 
         /*
-        TODO: documentação
+        Método que parseia o programa inteiro, ou seja, a sequência
+        de statements até o fim do vetor de tokens.
+        PARÂMETROS:
+        RETURNS:
+        - program (std::optional<node::Program>): nó raiz da AST.
         */
         inline std::optional<node::Program> parse_program() {
             node::Program program;
-            while(peek().has_value()) {
-                if (auto node_statmt = parse_statmt()) {
-                    program.statmts.push_back(node_statmt.value());
-                } else {
-                    std::cerr << "Declaração inválida." << std::endl;
-                    exit(EXIT_FAILURE);
+            parse_statmts(program.statmts, false, &program.funcoes);
+            program.usa_print = m_usa_print;
+            program.num_contadores = m_num_contadores;
+            return program;
+        }
+
+        /*
+        Método que parseia um único item do nível mais externo (um
+        statement, com todos os escopos que ele abre, ou uma função)
+        e o acrescenta a 'program', com as mesmas mensagens de erro
+        de parse_program. Usado pela compilação incremental (checar
+        incremental.hpp), que parseia cada item separadamente.
+        PARÂMETROS:
+        - program (node::Program&): recebe o statement ou a função.
+        RETURNS:
+        - (bool): falso caso não haja mais tokens.
+        */
+        inline bool parse_item(node::Program& program) {
+            if (!peek_tipo().has_value()) {
+                return false;
+            }
+            if (peek_tipo() == TipoToken::_fn) {
+                program.funcoes.push_back(parse_fn());
+            } else {
+                node::Scope* bloco = nullptr;
+                std::optional<node::Statmt*> statmt = parse_statmt(bloco);
+                if (!statmt.has_value()) {
+                    erro("Declaração inválida.");
+                }
+                program.statmts.push_back(statmt.value());
+                if (bloco != nullptr) {
+                    parse_statmts(bloco->statmts_scope, true);
                 }
             }
-            return program;
+            program.usa_print = program.usa_print || m_usa_print;
+            program.num_contadores = m_num_contadores;
+            return true;
+        }
+
+        /*
+        Número de tokens já consumidos.
+        */
+        inline size_t posicao() const {
+            return m_index;
+        }
+
+        /*
+        Método que parseia a declaração de uma função:
+        'fn nome(param1, param2, ...) { statements }'.
+        PARÂMETROS:
+        RETURNS:
+        - (node::Function*): nó da função.
+        */
+        inline node::Function* parse_fn() {
+            try_consume(TipoToken::_fn, "Esperava-se 'fn'.");
+            auto funcao = m_alloc.alloc<node::Function>();
+            funcao->token_identif = try_consume(TipoToken::identif, "Declaração inválida. Uma função precisa de um identificador.");
+            try_consume(TipoToken::parenteses_abre, "Erro de sintaxe. Esperava-se '(' após o nome da função.");
+            if (peek_tipo() != TipoToken::parenteses_fecha) {
+                funcao->params.push_back(try_consume(TipoToken::identif, "Declaração inválida. Esperava-se o nome de um parâmetro."));
+                while (peek_tipo() == TipoToken::virgula) {
+                    consume();
+                    funcao->params.push_back(try_consume(TipoToken::identif, "Declaração inválida. Esperava-se o nome de um parâmetro."));
+                }
+            }
+            try_consume(TipoToken::parenteses_fecha, "Erro de sintaxe. Esperava-se ')' após os parâmetros da função.");
+            funcao->scope = parse_scope().value();
+            return funcao;
         }
 
 
 
     private:
+        static constexpr int64_t TAMANHO_MAX_ARRAY = 1 << 18; // Em elementos (2 MiB): o array precisa caber na stack, de 8 MiB por padrão
+
         const std::vector<Token> m_tokens;
-        int m_index = 0;
-        ArenaAlloc m_alloc;
+        size_t m_index = 0;
+        ArenaAlloc& m_alloc;
+        bool m_usa_print = false; // Algum 'print' foi encontrado
+        uint32_t m_num_contadores = 0; // Escopos e 'ifs' numerados até aqui (checar node::Scope)
 
         /*
         Método que "olha" o próximo índice do vetor de tokens
         para ver se chegou ao seu fim, ou se é um token
         válido.
         PARÂMETROS:
-        - offset (int): número de tokens que o usuário 
+        - offset (size_t): número de tokens que o usuário 
         deseja analisar a frente do índice atual. Por padrão
         é settado como = 0.
         RETURNS:
         - m_tokens[m_index] (std::optional<Token>): token no 
         índice de análise do vetor
         */
-        inline std::optional<Token> peek(int offset = 0) const {
+        inline std::optional<Token> peek(size_t offset = 0) const {
             if (m_index + offset >= m_tokens.size()) {
                 return {};
             } else {
@@ -399,6 +685,21 @@ class Parser {
             }
         }
 
+        /*
+        Versão de peek() que devolve apenas o tipo do token, sem
+        copiar o token (e o seu valor) inteiro.
+        PARÂMETROS:
+        RETURNS:
+        - (std::optional<TipoToken>): tipo do token atual, ou vazio
+        no fim do vetor.
+        */
+        inline std::optional<TipoToken> peek_tipo() const {
+            if (m_index >= m_tokens.size()) {
+                return {};
+            }
+            return m_tokens[m_index].tipo;
+        }
+
         /*
         Método que retorna o token no índice atual e 
         incrementa o índice com +1.
@@ -413,14 +714,37 @@ class Parser {
         }
 
         /*
-        TODO: documentação
+        Método que consome o próximo token caso ele seja do tipo
+        esperado. Caso contrário, lança um erro de sintaxe.
+        PARÂMETROS:
+        - tipo (TipoToken): tipo de token esperado.
+        - erro_desc (const std::string&): mensagem do erro lançado
+        caso o token não seja do tipo esperado.
+        RETURNS:
+        - token (Token): token consumido.
         */
         inline Token try_consume(TipoToken tipo, const std::string& erro_desc) {
             if (peek().has_value() && peek().value().tipo == tipo) {
                 return consume();
             } else {
-                std::cerr << erro_desc << std::endl;
-                exit(EXIT_FAILURE);
+                erro(erro_desc);
+            }
+        }
+
+        /*
+        Método que lança um ErroCompilacao posicionado no token
+        atual (ou no último token, caso o vetor tenha acabado).
+        PARÂMETROS:
+        - erro_desc (const std::string&): descrição do erro.
+        RETURNS:
+        */
+        [[noreturn]] inline void erro(const std::string& erro_desc) const {
+            uint32_t offset = 0;
+            if (peek().has_value()) {
+                offset = peek().value().offset;
+            } else if (!m_tokens.empty()) {
+                offset = m_tokens.back().offset;
             }
+            throw ErroCompilacao {.mensagem = erro_desc, .offset = offset};
         }
 };
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+Perfil de execução (profile-guided optimization). Um programa
+compilado com Options::gerar_perfil conta quantas vezes cada
+escopo e cada 'if' (checar node::Scope) foi executado e, ao
+terminar, grava os contadores num arquivo binário:
+- 8 bytes: MAGICA_PERFIL ("MLCPERF1").
+- 8 bytes: hash do código fonte (hash_fonte).
+- 8 bytes: número de contadores.
+- 8 bytes por contador, na ordem de node::Scope::contador.
+Todos os campos são inteiros de 64 bits little-endian. Esse
+arquivo, lido com ler_perfil e passado em Options::perfil,
+orienta a disposição do código na compilação seguinte.
+*/
+namespace mlc {
+    inline constexpr uint64_t MAGICA_PERFIL = 0x314652455043'4C4DULL; // "MLCPERF1" em little-endian
+
+    struct Perfil {
+        uint64_t hash_fonte = 0;
+        std::vector<uint64_t> contadores;
+    };
+
+    inline constexpr uint64_t BASE_HASH = 0xcbf29ce484222325ULL; // offset basis do FNV-1a de 64 bits
+
+    /*
+    Passo do FNV-1a de 64 bits: combina 'valor' (um byte do código
+    ou uma palavra inteira) com 'hash'. Usado em todos os hashes do
+    compilador que precisam coincidir entre si (perfil, prelúdio e
+    compilação incremental).
+    PARÂMETROS:
+    - hash (uint64_t): hash acumulado (BASE_HASH no início).
+    - valor (uint64_t): valor a combinar.
+    RETURNS:
+    - (uint64_t): o novo hash.
+    */
+    inline constexpr uint64_t misturar_hash(uint64_t hash, uint64_t valor) {
+        return (hash ^ valor) * 0x100000001b3ULL;
+    }
+
+    /*
+    Hash (FNV-1a de 64 bits) do código fonte, gravado no perfil
+    para que ele não seja usado com outra versão do programa.
+    PARÂMETROS:
+    - src (std::string_view): código fonte.
+    RETURNS:
+    - (uint64_t): hash do código.
+    */
+    inline uint64_t hash_fonte(std::string_view src) {
+        uint64_t hash = BASE_HASH;
+        for (char c : src) {
+            hash = misturar_hash(hash, static_cast<unsigned char>(c));
+        }
+        return hash;
+    }
+
+    /*
+    Lê um perfil gravado por um programa instrumentado.
+    PARÂMETROS:
+    - arquivo (const std::string&): caminho do arquivo.
+    RETURNS:
+    - (std::optional<Perfil>): o perfil, ou vazio caso o arquivo
+    não exista ou não esteja no formato esperado.
+    */
+    inline std::optional<Perfil> ler_perfil(const std::string& arquivo) {
+        std::ifstream fs_perfil (arquivo, std::ios::in | std::ios::binary);
+        if (!fs_perfil) {
+            return {};
+        }
+        std::vector<char> dados {std::istreambuf_iterator<char>(fs_perfil), std::istreambuf_iterator<char>()};
+        auto palavra = [&](size_t k) {
+            uint64_t valor;
+            std::memcpy(&valor, dados.data() + 8 * k, sizeof(valor));
+            return valor;
+        };
+        if (dados.size() < 24 || dados.size() % 8 != 0 || palavra(0) != MAGICA_PERFIL || palavra(2) != dados.size() / 8 - 3) {
+            return {};
+        }
+        Perfil perfil;
+        perfil.hash_fonte = palavra(1);
+        perfil.contadores.reserve(palavra(2));
+        for (size_t k = 3; k < dados.size() / 8; k++) {
+            perfil.contadores.push_back(palavra(k));
+        }
+        return perfil;
+    }
+}
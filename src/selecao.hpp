@@ -0,0 +1,559 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "./parser.hpp"
+
+/*
+Seleção de instruções por reescrita de árvores de baixo para cima
+(BURS). A tabela REGRAS descreve, para cada padrão da árvore de
+expressões (ex.: soma de um valor já em registrador com um literal),
+a forma em que o valor fica (o não-terminal), o custo das instruções
+que o padrão gera e a ação usada pelo Generator para gerá-las.
+O Seletor rotula cada nó em pós-ordem com o menor custo de cada
+não-terminal (programação dinâmica sobre os filhos, seguida das
+regras de cadeia), e o Generator depois percorre a árvore de cima
+para baixo aplicando as regras escolhidas (checar
+Generator::generate_valor). Assim, 'a + b*4 + 12' vira um único
+'lea', 'x + 5' vira 'add rax, 5' e 'x * y' usa 'y' direto da memória.
+Não-terminais:
+- reg: valor em rax;
+- imm: literal que cabe em 32 bits (com sinal), usado como imediato;
+- mem: variável, usada como operando de memória ('QWORD [rsp + N]');
+- escala: valor multiplicado por 2, 4 ou 8 (índice de um endereço);
+- ender: endereço [base + indice*fator + deslocamento], que um único
+'lea' calcula;
+- cond: comparação já feita com 'cmp', com o resultado nas flags.
+Os custos aproximam o número de instruções, somando 1 a cada acesso
+à memória e a latência das multiplicações e divisões.
+*/
+namespace burs {
+    enum class NaoTerminal : uint8_t {
+        reg,
+        imm,
+        mem,
+        escala,
+        ender,
+        cond,
+        _num // não é um não-terminal: usado para dimensionar os rótulos
+    };
+
+    constexpr size_t NUM_NAO_TERMINAIS = static_cast<size_t>(NaoTerminal::_num);
+
+    /*
+    Forma do nó da AST que uma regra reconhece. Regras de cadeia
+    ('cadeia') convertem um não-terminal em outro no mesmo nó.
+    */
+    enum class Forma : uint8_t {
+        literal,
+        variavel,
+        chamada,
+        leitura,
+        binario,
+        cadeia
+    };
+
+    enum class Grupo : uint8_t {
+        nenhum,
+        soma,
+        subtracao,
+        multiplicacao,
+        divisao,
+        comparacao
+    };
+
+    /*
+    Restrição sobre o valor do filho 'imm' de uma regra: 'escala'
+    aceita 2, 4 e 8 (fatores de um endereço) e 'escala_lea' aceita
+    3, 5 e 9 (base e índice no mesmo registrador, ex.: [rax + rax*2]).
+    */
+    enum class Restricao : uint8_t {
+        nenhuma,
+        escala,
+        escala_lea
+    };
+
+    enum class Acao : uint8_t {
+        operando, // imm e mem: não geram código, o valor é usado direto
+        carregar_literal, // mov rax, imm
+        carregar_mem, // mov rax, [mem]
+        chamada, // argumentos na stack, resultado em rax
+        leitura, // elemento de array: índice em rax, depois a leitura
+        op_direita, // Op(reg, imm|mem): op rax, X
+        op_esquerda, // Op(imm|mem, reg): mesma operação, com os lados trocados
+        op_mem_imm, // imul rax, [mem], imm
+        op_reg, // Op(reg, reg): o lado esquerdo espera na stack
+        lea, // reg ← ender
+        shl, // reg ← escala
+        setcc, // reg ← cond
+        compor // escala e ender: só descrevem o endereço, sem código
+    };
+
+    struct Regra {
+        NaoTerminal resultado;
+        Forma forma;
+        Grupo grupo;
+        NaoTerminal esq; // filho esquerdo (ou origem, numa regra de cadeia)
+        NaoTerminal dir;
+        Restricao restricao;
+        uint8_t custo;
+        Acao acao;
+    };
+
+    using NT = NaoTerminal;
+    using F = Forma;
+    using G = Grupo;
+    using R = Restricao;
+    using A = Acao;
+
+    /*
+    Tabela de regras. Em caso de empate no custo, vale a primeira.
+    Nas regras 'compor', o custo é calculado a partir dos componentes
+    do endereço (checar Seletor::custo_componentes).
+    */
+    inline constexpr Regra REGRAS[] = {
+        // folhas
+        {NT::imm, F::literal, G::nenhum, NT::imm, NT::imm, R::nenhuma, 0, A::operando},
+        {NT::reg, F::literal, G::nenhum, NT::imm, NT::imm, R::nenhuma, 1, A::carregar_literal},
+        {NT::mem, F::variavel, G::nenhum, NT::mem, NT::mem, R::nenhuma, 0, A::operando},
+        {NT::reg, F::chamada, G::nenhum, NT::reg, NT::reg, R::nenhuma, 10, A::chamada},
+        {NT::reg, F::leitura, G::nenhum, NT::reg, NT::reg, R::nenhuma, 4, A::leitura},
+        // soma
+        {NT::reg, F::binario, G::soma, NT::reg, NT::imm, R::nenhuma, 1, A::op_direita},
+        {NT::reg, F::binario, G::soma, NT::reg, NT::mem, R::nenhuma, 2, A::op_direita},
+        {NT::reg, F::binario, G::soma, NT::imm, NT::reg, R::nenhuma, 1, A::op_esquerda},
+        {NT::reg, F::binario, G::soma, NT::mem, NT::reg, R::nenhuma, 2, A::op_esquerda},
+        {NT::reg, F::binario, G::soma, NT::reg, NT::reg, R::nenhuma, 5, A::op_reg},
+        // subtração
+        {NT::reg, F::binario, G::subtracao, NT::reg, NT::imm, R::nenhuma, 1, A::op_direita},
+        {NT::reg, F::binario, G::subtracao, NT::reg, NT::mem, R::nenhuma, 2, A::op_direita},
+        {NT::reg, F::binario, G::subtracao, NT::imm, NT::reg, R::nenhuma, 2, A::op_esquerda},
+        {NT::reg, F::binario, G::subtracao, NT::mem, NT::reg, R::nenhuma, 3, A::op_esquerda},
+        {NT::reg, F::binario, G::subtracao, NT::reg, NT::reg, R::nenhuma, 6, A::op_reg},
+        // multiplicação
+        {NT::reg, F::binario, G::multiplicacao, NT::reg, NT::imm, R::nenhuma, 3, A::op_direita},
+        {NT::reg, F::binario, G::multiplicacao, NT::reg, NT::mem, R::nenhuma, 4, A::op_direita},
+        {NT::reg, F::binario, G::multiplicacao, NT::imm, NT::reg, R::nenhuma, 3, A::op_esquerda},
+        {NT::reg, F::binario, G::multiplicacao, NT::mem, NT::reg, R::nenhuma, 4, A::op_esquerda},
+        {NT::reg, F::binario, G::multiplicacao, NT::mem, NT::imm, R::nenhuma, 4, A::op_mem_imm},
+        {NT::reg, F::binario, G::multiplicacao, NT::imm, NT::mem, R::nenhuma, 4, A::op_mem_imm},
+        {NT::reg, F::binario, G::multiplicacao, NT::reg, NT::reg, R::nenhuma, 7, A::op_reg},
+        // divisão
+        {NT::reg, F::binario, G::divisao, NT::reg, NT::imm, R::nenhuma, 24, A::op_direita},
+        {NT::reg, F::binario, G::divisao, NT::reg, NT::mem, R::nenhuma, 24, A::op_direita},
+        {NT::reg, F::binario, G::divisao, NT::imm, NT::reg, R::nenhuma, 25, A::op_esquerda},
+        {NT::reg, F::binario, G::divisao, NT::mem, NT::reg, R::nenhuma, 26, A::op_esquerda},
+        {NT::reg, F::binario, G::divisao, NT::reg, NT::reg, R::nenhuma, 27, A::op_reg},
+        // comparações
+        {NT::cond, F::binario, G::comparacao, NT::reg, NT::imm, R::nenhuma, 1, A::op_direita},
+        {NT::cond, F::binario, G::comparacao, NT::reg, NT::mem, R::nenhuma, 2, A::op_direita},
+        {NT::cond, F::binario, G::comparacao, NT::imm, NT::reg, R::nenhuma, 1, A::op_esquerda},
+        {NT::cond, F::binario, G::comparacao, NT::mem, NT::reg, R::nenhuma, 2, A::op_esquerda},
+        {NT::cond, F::binario, G::comparacao, NT::reg, NT::reg, R::nenhuma, 5, A::op_reg},
+        // endereços
+        {NT::escala, F::binario, G::multiplicacao, NT::reg, NT::imm, R::escala, 0, A::compor},
+        {NT::escala, F::binario, G::multiplicacao, NT::imm, NT::reg, R::escala, 0, A::compor},
+        {NT::ender, F::binario, G::multiplicacao, NT::reg, NT::imm, R::escala_lea, 0, A::compor},
+        {NT::ender, F::binario, G::multiplicacao, NT::imm, NT::reg, R::escala_lea, 0, A::compor},
+        {NT::ender, F::binario, G::soma, NT::reg, NT::imm, R::nenhuma, 0, A::compor},
+        {NT::ender, F::binario, G::soma, NT::imm, NT::reg, R::nenhuma, 0, A::compor},
+        {NT::ender, F::binario, G::subtracao, NT::reg, NT::imm, R::nenhuma, 0, A::compor},
+        {NT::ender, F::binario, G::soma, NT::ender, NT::imm, R::nenhuma, 0, A::compor},
+        {NT::ender, F::binario, G::soma, NT::imm, NT::ender, R::nenhuma, 0, A::compor},
+        {NT::ender, F::binario, G::subtracao, NT::ender, NT::imm, R::nenhuma, 0, A::compor},
+        {NT::ender, F::binario, G::soma, NT::reg, NT::escala, R::nenhuma, 0, A::compor},
+        {NT::ender, F::binario, G::soma, NT::escala, NT::reg, R::nenhuma, 0, A::compor},
+        {NT::ender, F::binario, G::soma, NT::reg, NT::reg, R::nenhuma, 0, A::compor},
+        {NT::ender, F::binario, G::soma, NT::ender, NT::reg, R::nenhuma, 0, A::compor},
+        {NT::ender, F::binario, G::soma, NT::reg, NT::ender, R::nenhuma, 0, A::compor},
+        // cadeias
+        {NT::reg, F::cadeia, G::nenhum, NT::mem, NT::mem, R::nenhuma, 2, A::carregar_mem},
+        {NT::reg, F::cadeia, G::nenhum, NT::ender, NT::ender, R::nenhuma, 1, A::lea},
+        {NT::reg, F::cadeia, G::nenhum, NT::escala, NT::escala, R::nenhuma, 1, A::shl},
+        {NT::reg, F::cadeia, G::nenhum, NT::cond, NT::cond, R::nenhuma, 2, A::setcc},
+        {NT::ender, F::cadeia, G::nenhum, NT::escala, NT::escala, R::nenhuma, 0, A::compor},
+    };
+
+    constexpr uint32_t INF = std::numeric_limits<uint32_t>::max() / 2; // não-terminal impossível no nó
+
+    /*
+    Endereço descrito pelos não-terminais 'ender' e 'escala' (que
+    só usa 'indice' e 'fator'). 'base' e 'indice' são subexpressões
+    calculadas em registradores; quando as duas geram código, a que
+    aparece primeiro no código fonte é calculada primeiro.
+    */
+    struct Endereco {
+        const node::Expr* base = nullptr;
+        const node::Expr* indice = nullptr;
+        int64_t fator = 1;
+        int64_t deslocamento = 0;
+        bool indice_primeiro = false;
+    };
+
+    /*
+    Rótulo de um nó: para cada não-terminal, o menor custo e a regra
+    (posição em REGRAS) que o atinge.
+    */
+    struct Rotulo {
+        std::array<uint32_t, NUM_NAO_TERMINAIS> custo;
+        std::array<uint8_t, NUM_NAO_TERMINAIS> regra;
+        Endereco ender;
+        Endereco escala;
+    };
+
+    constexpr size_t idx(NaoTerminal nt) {
+        return static_cast<size_t>(nt);
+    }
+
+    constexpr Grupo grupo(TipoToken tipo) {
+        switch (tipo) {
+            case TipoToken::mais:
+                return Grupo::soma;
+            case TipoToken::menos:
+                return Grupo::subtracao;
+            case TipoToken::asterisco:
+                return Grupo::multiplicacao;
+            case TipoToken::barra_div:
+                return Grupo::divisao;
+            case TipoToken::maior:
+            case TipoToken::menor:
+            case TipoToken::maior_igual:
+            case TipoToken::menor_igual:
+                return Grupo::comparacao;
+            default:
+                return Grupo::nenhum;
+        }
+    }
+}
+
+
+class Seletor {
+    public:
+        /*
+        Método que rotula a árvore de uma expressão (incluindo os
+        argumentos de chamadas e os índices de arrays), em pós-ordem
+        com uma pilha explícita. Nós já rotulados são mantidos, então
+        rotular a mesma expressão de novo não custa nada.
+        PARÂMETROS:
+        - raiz (const node::Expr*): nó da expressão.
+        RETURNS:
+        */
+        inline void rotular(const node::Expr* raiz) {
+            m_pilha.push_back({desembrulhar(raiz), false});
+            while (!m_pilha.empty()) {
+                auto [expr, filhos_prontos] = m_pilha.back();
+                m_pilha.pop_back();
+                if (m_rotulos.contains(expr)) {
+                    continue;
+                }
+                if (!filhos_prontos) {
+                    m_pilha.push_back({expr, true});
+                    if (auto bin_expr = std::get_if<node::BinExpr>(&expr->variant_expr)) {
+                        m_pilha.push_back({desembrulhar(bin_expr->lado_direito), false});
+                        m_pilha.push_back({desembrulhar(bin_expr->lado_esquerdo), false});
+                    } else if (auto term_call = std::get_if<node::TermCall>(&std::get<node::Term>(expr->variant_expr).variant_term)) {
+                        for (const node::Expr* arg : term_call->args) {
+                            m_pilha.push_back({desembrulhar(arg), false});
+                        }
+                    } else if (auto term_index = std::get_if<node::TermIndex>(&std::get<node::Term>(expr->variant_expr).variant_term)) {
+                        m_pilha.push_back({desembrulhar(term_index->indice), false});
+                    }
+                    continue;
+                }
+                m_rotulos.emplace(expr, calcular(expr));
+            }
+        }
+
+        /*
+        Métodos de consulta ao rótulo de um nó já rotulado (sem
+        parênteses; checar desembrulhar).
+        */
+        inline const burs::Rotulo& rotulo(const node::Expr* expr) const {
+            return m_rotulos.at(expr);
+        }
+
+        inline uint32_t custo(const node::Expr* expr, burs::NaoTerminal nt) const {
+            return rotulo(expr).custo[burs::idx(nt)];
+        }
+
+        inline const burs::Regra& regra(const node::Expr* expr, burs::NaoTerminal nt) const {
+            return burs::REGRAS[rotulo(expr).regra[burs::idx(nt)]];
+        }
+
+        /*
+        Método que descarta todos os rótulos, chamado ao fim de cada
+        expressão gerada.
+        */
+        inline void limpar() {
+            m_rotulos.clear();
+        }
+
+        /*
+        Método que pula os parênteses em volta de uma expressão, que
+        não geram código e, portanto, não são rotulados.
+        PARÂMETROS:
+        - expr (const node::Expr*): nó da expressão.
+        RETURNS:
+        - (const node::Expr*): primeiro nó que não é um TermParen.
+        */
+        static inline const node::Expr* desembrulhar(const node::Expr* expr) {
+            while (auto term = std::get_if<node::Term>(&expr->variant_expr)) {
+                auto term_paren = std::get_if<node::TermParen>(&term->variant_term);
+                if (term_paren == nullptr) {
+                    break;
+                }
+                expr = term_paren->expr;
+            }
+            return expr;
+        }
+
+        /*
+        Método que retorna o valor de um literal inteiro.
+        PARÂMETROS:
+        - expr (const node::Expr*): nó da expressão (sem parênteses).
+        RETURNS:
+        - (std::optional<int64_t>): valor, ou vazio caso a expressão
+        não seja um literal.
+        */
+        static inline std::optional<int64_t> valor_literal(const node::Expr* expr) {
+            if (auto term = std::get_if<node::Term>(&expr->variant_expr)) {
+                if (auto term_int_lit = std::get_if<node::TermIntLit>(&term->variant_term)) {
+                    return term_int_lit->token_int.valor_int;
+                }
+            }
+            return {};
+        }
+
+        static inline bool cabe_32(int64_t valor) {
+            return valor >= std::numeric_limits<int32_t>::min() && valor <= std::numeric_limits<int32_t>::max();
+        }
+
+        /*
+        Método que verifica se um componente de endereço é uma
+        variável, que pode ser carregada direto em qualquer registrador
+        (sem passar por rax e pela stack).
+        */
+        inline bool eh_folha(const node::Expr* expr) const {
+            return custo(expr, burs::NaoTerminal::mem) == 0;
+        }
+
+
+    private:
+        std::unordered_map<const node::Expr*, burs::Rotulo> m_rotulos;
+        std::vector<std::pair<const node::Expr*, bool>> m_pilha; // Pilha de trabalho de rotular
+
+        /*
+        Método que calcula o rótulo de um nó cujos filhos já foram
+        rotulados: aplica as regras da forma do nó e, depois, as
+        regras de cadeia até que nenhum custo diminua.
+        PARÂMETROS:
+        - expr (const node::Expr*): nó da expressão (sem parênteses).
+        RETURNS:
+        - (burs::Rotulo): rótulo do nó.
+        */
+        inline burs::Rotulo calcular(const node::Expr* expr) const {
+            using burs::NaoTerminal;
+            burs::Rotulo rotulo;
+            rotulo.custo.fill(burs::INF);
+            rotulo.regra.fill(0);
+
+            burs::Forma forma = burs::Forma::binario;
+            const node::BinExpr* bin_expr = std::get_if<node::BinExpr>(&expr->variant_expr);
+            const node::Expr* esq = nullptr;
+            const node::Expr* dir = nullptr;
+            if (bin_expr != nullptr) {
+                esq = desembrulhar(bin_expr->lado_esquerdo);
+                dir = desembrulhar(bin_expr->lado_direito);
+            } else {
+                const node::Term& term = std::get<node::Term>(expr->variant_expr);
+                if (std::holds_alternative<node::TermIntLit>(term.variant_term)) {
+                    forma = burs::Forma::literal;
+                } else if (std::holds_alternative<node::TermIdentif>(term.variant_term)) {
+                    forma = burs::Forma::variavel;
+                } else if (std::holds_alternative<node::TermCall>(term.variant_term)) {
+                    forma = burs::Forma::chamada;
+                } else {
+                    forma = burs::Forma::leitura;
+                    esq = desembrulhar(std::get<node::TermIndex>(term.variant_term).indice);
+                }
+            }
+
+            for (size_t k = 0; k < std::size(burs::REGRAS); k++) {
+                const burs::Regra& regra = burs::REGRAS[k];
+                if (regra.forma != forma || (bin_expr != nullptr && regra.grupo != burs::grupo(bin_expr->token.tipo))) {
+                    continue;
+                }
+                uint32_t custo = regra.custo;
+                burs::Endereco ender;
+                if (forma == burs::Forma::literal) {
+                    if (regra.resultado == NaoTerminal::imm && !cabe_32(valor_literal(expr).value())) {
+                        continue;
+                    }
+                } else if (forma == burs::Forma::leitura) {
+                    custo = somar(custo, this->custo(esq, NaoTerminal::reg));
+                } else if (forma == burs::Forma::binario) {
+                    if (!satisfaz(regra, esq, dir)) {
+                        continue;
+                    }
+                    if (regra.acao == burs::Acao::compor) {
+                        if (!compor(regra, esq, dir, ender)) {
+                            continue;
+                        }
+                        custo = custo_componentes(ender);
+                    } else {
+                        custo = somar(custo, somar(this->custo(esq, regra.esq), this->custo(dir, regra.dir)));
+                    }
+                }
+                atualizar(rotulo, k, custo, ender);
+            }
+
+            bool mudou = true;
+            while (mudou) {
+                mudou = false;
+                for (size_t k = 0; k < std::size(burs::REGRAS); k++) {
+                    const burs::Regra& regra = burs::REGRAS[k];
+                    if (regra.forma == burs::Forma::cadeia) {
+                        const burs::Endereco& origem = regra.esq == NaoTerminal::escala ? rotulo.escala : rotulo.ender;
+                        mudou |= atualizar(rotulo, k, somar(rotulo.custo[burs::idx(regra.esq)], regra.custo), origem);
+                    }
+                }
+            }
+            return rotulo;
+        }
+
+        /*
+        Método que anota uma regra no rótulo caso ela produza o seu
+        não-terminal com um custo menor que o atual.
+        RETURNS:
+        - (bool): verdadeiro caso o rótulo tenha mudado.
+        */
+        static inline bool atualizar(burs::Rotulo& rotulo, size_t k, uint32_t custo, const burs::Endereco& ender) {
+            const burs::Regra& regra = burs::REGRAS[k];
+            size_t nt = burs::idx(regra.resultado);
+            if (custo >= rotulo.custo[nt]) {
+                return false;
+            }
+            rotulo.custo[nt] = custo;
+            rotulo.regra[nt] = static_cast<uint8_t>(k);
+            if (regra.resultado == burs::NaoTerminal::ender) {
+                rotulo.ender = ender;
+            } else if (regra.resultado == burs::NaoTerminal::escala) {
+                rotulo.escala = ender;
+            }
+            return true;
+        }
+
+        /*
+        Método que verifica a restrição de uma regra sobre o valor do
+        seu filho 'imm'.
+        */
+        static inline bool satisfaz(const burs::Regra& regra, const node::Expr* esq, const node::Expr* dir) {
+            if (regra.restricao == burs::Restricao::nenhuma) {
+                return true;
+            }
+            std::optional<int64_t> valor = valor_literal(regra.esq == burs::NaoTerminal::imm ? esq : dir);
+            if (!valor.has_value()) {
+                return false;
+            }
+            if (regra.restricao == burs::Restricao::escala) {
+                return *valor == 2 || *valor == 4 || *valor == 8;
+            }
+            return *valor == 3 || *valor == 5 || *valor == 9;
+        }
+
+        /*
+        Método que monta o endereço descrito por uma regra 'compor'
+        a partir dos filhos do nó.
+        PARÂMETROS:
+        - regra (const burs::Regra&): regra aplicada.
+        - esq, dir (const node::Expr*): filhos do nó (sem parênteses).
+        - ender (burs::Endereco&): recebe o endereço.
+        RETURNS:
+        - (bool): falso caso a regra não se aplique (ex.: um filho não
+        pode ser um endereço, ou o deslocamento não cabe em 32 bits).
+        */
+        inline bool compor(const burs::Regra& regra, const node::Expr* esq, const node::Expr* dir, burs::Endereco& ender) const {
+            using burs::NaoTerminal;
+            for (auto [filho, nt] : {std::pair {esq, regra.esq}, std::pair {dir, regra.dir}}) {
+                if (custo(filho, nt) >= burs::INF) {
+                    return false;
+                }
+            }
+            bool imm_esq = regra.esq == NaoTerminal::imm;
+            const node::Expr* outro = imm_esq ? dir : esq; // filho que não é o 'imm'
+            NaoTerminal nt_outro = imm_esq ? regra.dir : regra.esq;
+            if (regra.grupo == burs::Grupo::multiplicacao) {
+                int64_t valor = valor_literal(imm_esq ? esq : dir).value();
+                if (regra.resultado == NaoTerminal::escala) {
+                    ender = {.indice = outro, .fator = valor};
+                } else {
+                    ender = {.base = outro, .indice = outro, .fator = valor - 1};
+                }
+                return true;
+            }
+            if (regra.esq == NaoTerminal::imm || regra.dir == NaoTerminal::imm) {
+                int64_t valor = valor_literal(imm_esq ? esq : dir).value();
+                if (regra.grupo == burs::Grupo::subtracao) {
+                    valor = -valor;
+                }
+                if (nt_outro == NaoTerminal::ender) {
+                    ender = rotulo(outro).ender;
+                } else {
+                    ender = {.base = outro};
+                }
+                ender.deslocamento += valor;
+                return cabe_32(ender.deslocamento);
+            }
+            // soma de dois componentes: reg + reg, reg + escala ou reg + ender sem base
+            if (regra.esq == NaoTerminal::reg && regra.dir == NaoTerminal::reg) {
+                ender = {.base = esq, .indice = dir};
+                return true;
+            }
+            bool componente_esq = regra.esq != NaoTerminal::reg;
+            const burs::Endereco& parcial = componente_esq
+                ? (regra.esq == NaoTerminal::escala ? rotulo(esq).escala : rotulo(esq).ender)
+                : (regra.dir == NaoTerminal::escala ? rotulo(dir).escala : rotulo(dir).ender);
+            if (parcial.base != nullptr) {
+                return false;
+            }
+            ender = parcial;
+            ender.base = componente_esq ? dir : esq;
+            ender.indice_primeiro = componente_esq;
+            return true;
+        }
+
+        /*
+        Método que calcula o custo de calcular os componentes de um
+        endereço: cada um custa o seu 'reg', exceto variáveis, que são
+        carregadas direto num registrador; quando os dois componentes
+        geram código, um deles passa pela stack.
+        */
+        inline uint32_t custo_componentes(const burs::Endereco& ender) const {
+            using burs::NaoTerminal;
+            if (ender.indice == nullptr) {
+                return custo(ender.base, NaoTerminal::reg);
+            }
+            if (ender.base == nullptr || ender.base == ender.indice) {
+                return custo(ender.indice, NaoTerminal::reg);
+            }
+            bool folha_base = eh_folha(ender.base);
+            bool folha_indice = eh_folha(ender.indice);
+            if (folha_base && folha_indice) {
+                return 4;
+            }
+            if (folha_base || folha_indice) {
+                return somar(custo(folha_base ? ender.indice : ender.base, NaoTerminal::reg), 2);
+            }
+            return somar(somar(custo(ender.base, NaoTerminal::reg), custo(ender.indice, NaoTerminal::reg)), 4);
+        }
+
+        static inline uint32_t somar(uint32_t a, uint32_t b) {
+            return std::min(a + b, burs::INF);
+        }
+};
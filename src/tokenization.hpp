@@ -1,8 +1,15 @@
 #pragma once
 
+#include <array>
 #include <optional>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "./erro.hpp"
 
 enum class TipoToken {
     _exit,
@@ -23,41 +30,206 @@ enum class TipoToken {
     maior, 
     menor,
     maior_igual,
-    menor_igual
+    menor_igual,
+    _while,
+    virgula,
+    _fn,
+    _return,
+    colchetes_abre,
+    colchetes_fecha,
+    _print,
+    _num_tipos // não é um token: número de tipos de token, usado para indexar tabelas
 };
 
 struct Token {
     TipoToken tipo;
-    std::optional<std::string> valor;
+    std::optional<std::string> valor = std::nullopt; // nome do identificador
+    int64_t valor_int = 0; // valor de literais inteiros, já convertido na tokenização
+    uint32_t offset = 0; // posição, em bytes, do início do token no código fonte
 };
 
-inline std::optional<int> bin_prec(TipoToken tipo) {
-    switch(tipo) {
-        case TipoToken::maior:
-            return 0;
-        case TipoToken::menor:
-            return 0;
-        case TipoToken::maior_igual:
-            return 0;
-        case TipoToken::menor_igual:
-            return 0;
-        case TipoToken::mais:
-            return 1;
-        case TipoToken::menos:
-            return 1;
-        case TipoToken::asterisco:
-            return 2;
-        case TipoToken::barra_div:
-            return 2;
-        default:
-            return {};
+/*
+Associatividade de um operador binário: com 'esquerda', a - b - c
+é (a - b) - c; com 'direita', seria a - (b - c).
+*/
+enum class Assoc {
+    esquerda,
+    direita
+};
+
+/*
+Classe do nó gerado por um operador binário: operações aritméticas
+produzem um valor; comparações produzem 0/1 e, quando usadas como
+condição, viram um 'cmp' seguido de salto condicional.
+*/
+enum class ClasseOp {
+    aritmetica,
+    comparacao
+};
+
+struct InfoOperador {
+    int prec;
+    Assoc assoc;
+    ClasseOp classe;
+};
+
+/*
+Tabela de operadores binários, indexada por TipoToken e montada em
+tempo de compilação. Tokens que não são operadores binários ficam
+vazios. Para adicionar um operador basta adicionar uma linha aqui.
+*/
+constexpr std::array<std::optional<InfoOperador>, static_cast<size_t>(TipoToken::_num_tipos)> criar_tabela_operadores() {
+    std::array<std::optional<InfoOperador>, static_cast<size_t>(TipoToken::_num_tipos)> tabela {};
+    auto definir = [&tabela](TipoToken tipo, int prec, Assoc assoc, ClasseOp classe) {
+        tabela[static_cast<size_t>(tipo)] = InfoOperador {.prec = prec, .assoc = assoc, .classe = classe};
+    };
+    definir(TipoToken::maior, 0, Assoc::esquerda, ClasseOp::comparacao);
+    definir(TipoToken::menor, 0, Assoc::esquerda, ClasseOp::comparacao);
+    definir(TipoToken::maior_igual, 0, Assoc::esquerda, ClasseOp::comparacao);
+    definir(TipoToken::menor_igual, 0, Assoc::esquerda, ClasseOp::comparacao);
+    definir(TipoToken::mais, 1, Assoc::esquerda, ClasseOp::aritmetica);
+    definir(TipoToken::menos, 1, Assoc::esquerda, ClasseOp::aritmetica);
+    definir(TipoToken::asterisco, 2, Assoc::esquerda, ClasseOp::aritmetica);
+    definir(TipoToken::barra_div, 2, Assoc::esquerda, ClasseOp::aritmetica);
+    return tabela;
+}
+
+inline constexpr auto TABELA_OPERADORES = criar_tabela_operadores();
+
+/*
+Função que consulta a tabela de operadores binários.
+PARÂMETROS:
+- tipo (TipoToken): tipo do token.
+RETURNS:
+- (const std::optional<InfoOperador>&): precedência, associatividade
+e classe do operador, ou vazio caso o token não seja um operador.
+*/
+constexpr const std::optional<InfoOperador>& info_operador(TipoToken tipo) {
+    return TABELA_OPERADORES[static_cast<size_t>(tipo)];
+}
+
+/*
+Palavras-chave da linguagem. Para adicionar uma palavra-chave basta
+adicionar uma linha aqui (com no máximo 8 caracteres): a tabela hash
+abaixo é recalculada em tempo de compilação.
+*/
+struct PalavraChave {
+    std::string_view texto;
+    TipoToken tipo;
+};
+
+inline constexpr PalavraChave PALAVRAS_CHAVE[] = {
+    {"exit", TipoToken::_exit},
+    {"var", TipoToken::var},
+    {"if", TipoToken::_if},
+    {"while", TipoToken::_while},
+    {"fn", TipoToken::_fn},
+    {"return", TipoToken::_return},
+    {"print", TipoToken::_print},
+};
+
+/*
+Hash perfeito das palavras-chave, gerado em tempo de compilação. A
+chave é formada pelo tamanho da palavra e pelo seu primeiro e último
+caracteres, e é espalhada por uma multiplicação com uma 'semente'
+escolhida (também em tempo de compilação) de modo que nenhuma duas
+palavras-chave caiam na mesma posição da tabela. Cada posição guarda
+a palavra inteira empacotada em 8 bytes, então confirmar que um
+identificador é a palavra-chave da posição é uma única comparação de
+64 bits, independente do número de palavras-chave.
+*/
+namespace hash_pc {
+    constexpr size_t BITS = 5;
+    constexpr size_t TAMANHO = size_t {1} << BITS;
+
+    struct Posicao {
+        uint64_t palavra;
+        uint8_t tamanho; // 0 indica uma posição vazia
+        TipoToken tipo;
+    };
+
+    constexpr uint32_t calcular(size_t tamanho, char primeiro, char ultimo, uint32_t semente) {
+        uint32_t chave = static_cast<uint32_t>(tamanho)
+            | (static_cast<uint32_t>(static_cast<unsigned char>(primeiro)) << 8)
+            | (static_cast<uint32_t>(static_cast<unsigned char>(ultimo)) << 16);
+        return (chave * semente) >> (32 - BITS);
+    }
+
+    constexpr uint64_t empacotar(std::string_view texto) {
+        uint64_t palavra = 0;
+        for (size_t i = 0; i < texto.size(); i++) {
+            palavra |= static_cast<uint64_t>(static_cast<unsigned char>(texto[i])) << (8 * i);
+        }
+        return palavra;
+    }
+
+    constexpr bool sem_colisoes(uint32_t semente) {
+        bool ocupada[TAMANHO] {};
+        for (const PalavraChave& pc : PALAVRAS_CHAVE) {
+            uint32_t h = calcular(pc.texto.size(), pc.texto.front(), pc.texto.back(), semente);
+            if (ocupada[h]) {
+                return false;
+            }
+            ocupada[h] = true;
+        }
+        return true;
     }
+
+    constexpr uint32_t encontrar_semente() {
+        for (uint32_t semente = 0x9E3779B1; semente != 0; semente += 2) {
+            if (sem_colisoes(semente)) {
+                return semente;
+            }
+        }
+        return 0;
+    }
+
+    constexpr uint32_t SEMENTE = encontrar_semente();
+    static_assert(SEMENTE != 0, "Não foi encontrado um hash perfeito para as palavras-chave.");
+
+    constexpr std::array<Posicao, TAMANHO> criar_tabela() {
+        std::array<Posicao, TAMANHO> tabela {};
+        for (const PalavraChave& pc : PALAVRAS_CHAVE) {
+            if (pc.texto.empty() || pc.texto.size() > 8) {
+                throw "Palavras-chave devem ter entre 1 e 8 caracteres.";
+            }
+            tabela[calcular(pc.texto.size(), pc.texto.front(), pc.texto.back(), SEMENTE)] = {
+                .palavra = empacotar(pc.texto),
+                .tamanho = static_cast<uint8_t>(pc.texto.size()),
+                .tipo = pc.tipo
+            };
+        }
+        return tabela;
+    }
+
+    inline constexpr std::array<Posicao, TAMANHO> TABELA = criar_tabela();
+}
+
+/*
+Função que verifica se uma palavra é uma palavra-chave.
+PARÂMETROS:
+- palavra (std::string_view): identificador lido do código fonte.
+RETURNS:
+- (std::optional<TipoToken>): tipo do token da palavra-chave, ou
+vazio caso a palavra seja um identificador comum.
+*/
+inline std::optional<TipoToken> buscar_palavra_chave(std::string_view palavra) {
+    if (palavra.size() > 8) {
+        return {};
+    }
+    const hash_pc::Posicao& posicao = hash_pc::TABELA[hash_pc::calcular(palavra.size(), palavra.front(), palavra.back(), hash_pc::SEMENTE)];
+    uint64_t empacotada = 0;
+    std::memcpy(&empacotada, palavra.data(), palavra.size());
+    if (posicao.tamanho == palavra.size() && posicao.palavra == empacotada) {
+        return posicao.tipo;
+    }
+    return {};
 }
 
 class Tokenizer {
     public:
-        inline Tokenizer(const std::string src) 
-            : m_src(src) 
+        inline Tokenizer(std::string_view src)
+            : m_src(src)
         {}
 
         /*
@@ -65,114 +237,269 @@ class Tokenizer {
         passando por todo o conteúdo do arquivo .ml (tido como uma string)
         e reconhecendo palavras chaves.
         PARÂMETROS:
-        - str (std::string): string com todo o conteúdo do arquivo .ml a ser compilado
         RETURNS:
         - tokens (std::vector<Token): vetor de tokens do arquivo .ml
         */
         inline std::vector<Token> tokenize() {
             std::vector<Token> tokens;
-            std::string buffer;
+            while (std::optional<Token> token = proximo()) {
+                tokens.push_back(std::move(token.value()));
+            }
+            m_index = 0;
+            return tokens;
+        }
 
+        /*
+        Método que lê o próximo token a partir da posição atual,
+        pulando espaços e comentários. Como nenhum estado é mantido
+        entre um token e outro, a leitura pode começar no fim de
+        qualquer token (checar posicionar), o que permite tokenizar
+        de novo só um trecho do arquivo (checar incremental.hpp).
+        PARÂMETROS:
+        RETURNS:
+        - (std::optional<Token>): o token, ou vazio no fim do código.
+        */
+        inline std::optional<Token> proximo() {
             while (peek().has_value()) {
+                uint32_t inicio = m_index;
                 if (std::isalpha(peek().value())) { //estamos garantindo que peek() vai retornar um caracter
-                    buffer.push_back(consume());
+                    consume();
                     while (peek().has_value() && std::isalnum(peek().value())) {
-                        buffer.push_back(consume());
+                        consume();
                     }
-                    if (buffer.compare("exit") == 0) {
-                        tokens.push_back({.tipo = TipoToken::_exit});
-                        buffer.clear();
-                    } else if (buffer.compare("var") == 0) {
-                        tokens.push_back({.tipo = TipoToken::var});
-                        buffer.clear();
-                    } else if (buffer.compare("if") == 0) {
-                        tokens.push_back({.tipo = TipoToken::_if});
-                        buffer.clear();
+                    std::string_view palavra = m_src.substr(inicio, m_index - inicio);
+                    if (std::optional<TipoToken> tipo = buscar_palavra_chave(palavra)) {
+                        return Token {.tipo = tipo.value(), .offset = inicio};
                     } else {
-                        tokens.push_back({.tipo = TipoToken::identif, .valor = buffer});
-                        buffer.clear();
+                        return Token {.tipo = TipoToken::identif, .valor = std::string(palavra), .offset = inicio};
                     }
                 } else if (std::isdigit(peek().value())) {
-                    buffer.push_back(consume());
-                    while (peek().has_value() && std::isalnum(peek().value())) {
-                        buffer.push_back(consume());
-                    }
-                    tokens.push_back({.tipo = TipoToken::int_lit, .valor = buffer});
-                    buffer.clear();
+                    int64_t valor = consume_int_lit(inicio);
+                    return Token {.tipo = TipoToken::int_lit, .valor_int = valor, .offset = inicio};
                 } else if (peek().value() == '=') {
                     consume();
-                    tokens.push_back({.tipo = TipoToken::igual});
+                    return Token {.tipo = TipoToken::igual, .offset = inicio};
                 } else if (peek().value() == '+') {
                     consume();
-                    tokens.push_back({.tipo = TipoToken::mais});
+                    return Token {.tipo = TipoToken::mais, .offset = inicio};
                 } else if (peek().value() == '-') {
                     consume();
-                    tokens.push_back({.tipo = TipoToken::menos});
+                    return Token {.tipo = TipoToken::menos, .offset = inicio};
                 } else if (peek().value() == '*') {
                     consume();
-                    tokens.push_back({.tipo = TipoToken::asterisco});
+                    return Token {.tipo = TipoToken::asterisco, .offset = inicio};
                 } else if (peek().value() == '/') {
                     consume();
-                    tokens.push_back({.tipo = TipoToken::barra_div});
+                    if (peek().has_value() && peek().value() == '/') { // comentário até o fim da linha
+                        while (peek().has_value() && peek().value() != '\n') {
+                            consume();
+                        }
+                    } else {
+                        return Token {.tipo = TipoToken::barra_div, .offset = inicio};
+                    }
                 } else if (peek().value() == '>') {
                     consume();
-                    if (peek().value() == '=') {
+                    if (peek().has_value() && peek().value() == '=') {
                         consume();
-                        tokens.push_back({.tipo = TipoToken::maior_igual});
+                        return Token {.tipo = TipoToken::maior_igual, .offset = inicio};
                     } else {
-                        tokens.push_back({.tipo = TipoToken::maior});
+                        return Token {.tipo = TipoToken::maior, .offset = inicio};
                     }
                 } else if (peek().value() == '<') {
                     consume();
-                    if (peek().value() == '=') {
+                    if (peek().has_value() && peek().value() == '=') {
                         consume();
-                        tokens.push_back({.tipo = TipoToken::menor_igual});
+                        return Token {.tipo = TipoToken::menor_igual, .offset = inicio};
                     } else {
-                        tokens.push_back({.tipo = TipoToken::menor});
+                        return Token {.tipo = TipoToken::menor, .offset = inicio};
                     }
                 } else if (peek().value() == '(') {
                     consume();
-                    tokens.push_back({.tipo = TipoToken::parenteses_abre});
+                    return Token {.tipo = TipoToken::parenteses_abre, .offset = inicio};
                 } else if (peek().value() == ')') {
                     consume();
-                    tokens.push_back({.tipo = TipoToken::parenteses_fecha});
+                    return Token {.tipo = TipoToken::parenteses_fecha, .offset = inicio};
                 } else if (peek().value() == ';') {
                     consume();
-                    tokens.push_back({.tipo = TipoToken::ponto_virgula});
+                    return Token {.tipo = TipoToken::ponto_virgula, .offset = inicio};
+                } else if (peek().value() == ',') {
+                    consume();
+                    return Token {.tipo = TipoToken::virgula, .offset = inicio};
+                } else if (peek().value() == '[') {
+                    consume();
+                    return Token {.tipo = TipoToken::colchetes_abre, .offset = inicio};
+                } else if (peek().value() == ']') {
+                    consume();
+                    return Token {.tipo = TipoToken::colchetes_fecha, .offset = inicio};
                 } else if (peek().value() == '{') {
                     consume();
-                    tokens.push_back({.tipo = TipoToken::chaves_abre});
+                    return Token {.tipo = TipoToken::chaves_abre, .offset = inicio};
                 } else if (peek().value() == '}') {
                     consume();
-                    tokens.push_back({.tipo = TipoToken::chaves_fecha});
+                    return Token {.tipo = TipoToken::chaves_fecha, .offset = inicio};
                 } else if (std::isspace(peek().value())) {
                     consume();
                 } else {
-                    std::cerr << "Erro na tokenização do arquivo." << std::endl;
-                    exit(EXIT_FAILURE);
+                    throw ErroCompilacao {.mensagem = "Erro na tokenização do arquivo.", .offset = inicio};
                 }
             }
-            m_index = 0;
-            return tokens;
+            return {};
+        }
+
+        /*
+        Posiciona a leitura no byte 'offset' do código, que deve
+        ser o início do arquivo ou o fim de um token.
+        */
+        inline void posicionar(uint32_t offset) {
+            m_index = offset;
+        }
+
+        /*
+        Posição da leitura: depois de proximo(), o fim do token lido.
+        */
+        inline uint32_t posicao() const {
+            return m_index;
         }
 
 
     private:
-        const std::string m_src;
-        int m_index = 0;
+        std::string_view m_src;
+        uint32_t m_index = 0;
+
+        /*
+        Método que consome um literal inteiro e o converte para
+        int64_t. Aceita decimal, hexadecimal (prefixo 0x) e binário
+        (prefixo 0b). Literais decimais são convertidos oito dígitos
+        por vez com SWAR (checar converter_8_digitos). Qualquer
+        literal que não caiba em um int64_t é um erro, assim como
+        letras coladas ao final do número (ex.: 12abc).
+        PARÂMETROS:
+        - inicio (uint32_t): offset do início do literal, usado nas
+        mensagens de erro.
+        RETURNS:
+        - valor (int64_t): valor do literal.
+        */
+        inline int64_t consume_int_lit(uint32_t inicio) {
+            uint64_t valor = 0;
+            bool overflow = false;
+            if (peek().value() == '0' && peek(1).has_value() && (peek(1).value() == 'x' || peek(1).value() == 'X'
+                    || peek(1).value() == 'b' || peek(1).value() == 'B')) {
+                unsigned bits = (peek(1).value() == 'x' || peek(1).value() == 'X') ? 4 : 1;
+                consume();
+                consume();
+                size_t num_digitos = 0;
+                while (peek().has_value()) {
+                    int digito = valor_digito(peek().value());
+                    if (digito < 0 || digito >= (1 << bits)) {
+                        break;
+                    }
+                    consume();
+                    overflow |= (valor >> (64 - bits)) != 0;
+                    valor = (valor << bits) | static_cast<uint64_t>(digito);
+                    num_digitos++;
+                }
+                if (num_digitos == 0) {
+                    throw ErroCompilacao {.mensagem = "Literal inteiro inválido: esperava-se um dígito após o prefixo.", .offset = inicio};
+                }
+            } else {
+                while (true) {
+                    uint64_t bloco = 0;
+                    size_t restantes = m_src.size() - m_index;
+                    std::memcpy(&bloco, m_src.data() + m_index, restantes < 8 ? restantes : 8);
+                    size_t num_digitos = contar_digitos(bloco);
+                    if (num_digitos == 0) {
+                        break;
+                    }
+                    uint64_t valor_bloco = converter_8_digitos(bloco, num_digitos);
+                    overflow |= __builtin_mul_overflow(valor, POTENCIAS_10[num_digitos], &valor);
+                    overflow |= __builtin_add_overflow(valor, valor_bloco, &valor);
+                    m_index += static_cast<uint32_t>(num_digitos);
+                    if (num_digitos < 8) {
+                        break;
+                    }
+                }
+            }
+            if (peek().has_value() && (std::isalnum(peek().value()) || peek().value() == '_')) {
+                throw ErroCompilacao {.mensagem = "Literal inteiro inválido.", .offset = inicio};
+            }
+            if (overflow || valor > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+                throw ErroCompilacao {.mensagem = "Literal inteiro não cabe em 64 bits.", .offset = inicio};
+            }
+            return static_cast<int64_t>(valor);
+        }
+
+        static constexpr uint64_t POTENCIAS_10[9] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+
+        /*
+        Função que conta quantos dos 8 bytes de 'bloco' (em ordem
+        little-endian, ou seja, na ordem do código fonte) são dígitos
+        decimais consecutivos a partir do primeiro. Um byte é dígito
+        quando o seu nibble alto é 0x3 e somar 6 não causa 'carry'
+        para o nibble alto (ou seja, ele está entre '0' e '9').
+        PARÂMETROS:
+        - bloco (uint64_t): 8 caracteres do código fonte.
+        RETURNS:
+        - (size_t): número de dígitos no início do bloco (0 a 8).
+        */
+        static inline size_t contar_digitos(uint64_t bloco) {
+            uint64_t nao_digitos = ((bloco & 0xF0F0F0F0F0F0F0F0) ^ 0x3030303030303030)
+                | (((bloco + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) ^ 0x3030303030303030);
+            if (nao_digitos == 0) {
+                return 8;
+            }
+            return static_cast<size_t>(__builtin_ctzll(nao_digitos)) / 8;
+        }
+
+        /*
+        Função que converte até 8 dígitos decimais de uma vez (SWAR),
+        combinando pares de dígitos, depois pares de pares e, por
+        fim, as duas metades, com três multiplicações no total.
+        Os dígitos que sobram à direita são descartados com um
+        deslocamento, o que equivale a completar o número com zeros
+        à esquerda.
+        PARÂMETROS:
+        - bloco (uint64_t): 8 caracteres do código fonte.
+        - num_digitos (size_t): quantos dos primeiros caracteres são
+        dígitos (1 a 8).
+        RETURNS:
+        - (uint64_t): valor numérico dos dígitos.
+        */
+        static inline uint64_t converter_8_digitos(uint64_t bloco, size_t num_digitos) {
+            bloco -= 0x3030303030303030;
+            bloco <<= 8 * (8 - num_digitos);
+            bloco = (bloco * 10) + (bloco >> 8);
+            bloco = (((bloco & 0x000000FF000000FF) * (100 + (1000000ULL << 32)))
+                + (((bloco >> 16) & 0x000000FF000000FF) * (1 + (10000ULL << 32)))) >> 32;
+            return bloco;
+        }
+
+        /*
+        Função que retorna o valor de um dígito hexadecimal (que
+        inclui os binários), ou -1 caso o caracter não seja um.
+        */
+        static inline int valor_digito(char c) {
+            if (c >= '0' && c <= '9') {
+                return c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                return c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                return c - 'A' + 10;
+            }
+            return -1;
+        }
 
         /*
         Método que "olha" o próximo indíce da string para
         ver se chegou ao seu fim, ou se é um caracter válido
         PARÂMETROS:
-        - offset (int): número de caracteres que a função 
+        - offset (uint32_t): número de caracteres que a função 
         vai analisar a frente do índice atual. Por padrão é
         settado como = 0.
         RETURNS:
         - m_src[m_index] (std::optional<char>): caracter no 
         índice de análise.
         */
-        inline std::optional<char> peek(int offset = 0) const {
+        inline std::optional<char> peek(uint32_t offset = 0) const {
             if (m_index + offset >= m_src.length()) {
                 return {};
             } else {
@@ -0,0 +1,135 @@
+#pragma once
+
+/*
+Tracing do compilador. Os pontos de trace (MLC_TRACE_SCOPE) só existem
+quando o projeto é configurado com -DMLC_TRACE=ON; caso contrário, as
+macros se expandem para nada e não custam nenhuma instrução.
+
+Quando habilitado, cada MLC_TRACE_SCOPE registra um intervalo (span)
+com início e duração no buffer da thread atual. Cada thread escreve
+apenas no seu próprio buffer, sem locks; os buffers são encadeados
+numa lista global com compare-and-swap na primeira utilização. No
+final, trace::exportar_chrome escreve todos os eventos no formato
+"Trace Event" do Chrome, que pode ser aberto no Perfetto
+(https://ui.perfetto.dev) ou em chrome://tracing.
+*/
+
+#ifdef MLC_TRACE
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <iomanip>
+#include <memory>
+
+namespace trace {
+    struct Evento {
+        const char* nome;
+        uint64_t inicio_ns;
+        uint64_t duracao_ns;
+    };
+
+    /*
+    Buffer de eventos de uma thread. Tem capacidade fixa: quando
+    enche, novos eventos são descartados e contados em 'descartados'.
+    */
+    struct Buffer {
+        static constexpr size_t CAPACIDADE = 1 << 20;
+
+        std::unique_ptr<Evento[]> eventos = std::make_unique<Evento[]>(CAPACIDADE);
+        std::atomic<size_t> tamanho = 0;
+        size_t descartados = 0;
+        uint32_t tid = 0;
+        Buffer* proximo = nullptr;
+    };
+
+    inline std::atomic<Buffer*> g_buffers = nullptr; // Lista (lock-free) com os buffers de todas as threads
+    inline std::atomic<uint32_t> g_proximo_tid = 1;
+
+    inline uint64_t agora_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    /*
+    Retorna o buffer da thread atual, registrando-o na lista global
+    na primeira chamada. Os buffers nunca são liberados, para que
+    a exportação continue válida depois que a thread terminar.
+    */
+    inline Buffer& buffer_thread() {
+        thread_local Buffer* buffer = [] {
+            Buffer* novo = new Buffer();
+            novo->tid = g_proximo_tid.fetch_add(1, std::memory_order_relaxed);
+            novo->proximo = g_buffers.load(std::memory_order_relaxed);
+            while (!g_buffers.compare_exchange_weak(novo->proximo, novo, std::memory_order_release, std::memory_order_relaxed)) {}
+            return novo;
+        }();
+        return *buffer;
+    }
+
+    /*
+    Span RAII: registra o intervalo entre a sua construção e a sua
+    destruição.
+    */
+    class Span {
+        public:
+            inline explicit Span(const char* nome)
+                : m_nome(nome), m_inicio(agora_ns())
+            {}
+
+            inline ~Span() {
+                uint64_t fim = agora_ns();
+                Buffer& buffer = buffer_thread();
+                size_t i = buffer.tamanho.load(std::memory_order_relaxed);
+                if (i == Buffer::CAPACIDADE) {
+                    buffer.descartados++;
+                    return;
+                }
+                buffer.eventos[i] = {.nome = m_nome, .inicio_ns = m_inicio, .duracao_ns = fim - m_inicio};
+                buffer.tamanho.store(i + 1, std::memory_order_release);
+            }
+
+            Span(const Span&) = delete;
+            Span& operator=(const Span&) = delete;
+
+        private:
+            const char* m_nome;
+            uint64_t m_inicio;
+    };
+
+    /*
+    Função que escreve todos os eventos registrados até aqui no
+    formato JSON do Chrome ("traceEvents", eventos completos "X",
+    com tempos em microssegundos).
+    PARÂMETROS:
+    - out (std::ostream&): destino do JSON.
+    RETURNS:
+    */
+    inline void exportar_chrome(std::ostream& out) {
+        out << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+        bool primeiro = true;
+        for (Buffer* buffer = g_buffers.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->proximo) {
+            size_t tamanho = buffer->tamanho.load(std::memory_order_acquire);
+            for (size_t i = 0; i < tamanho; i++) {
+                const Evento& evento = buffer->eventos[i];
+                out << (primeiro ? "" : ",") << "\n{\"name\":\"" << evento.nome << "\",\"ph\":\"X\",\"pid\":1"
+                    << ",\"tid\":" << buffer->tid
+                    << ",\"ts\":" << static_cast<double>(evento.inicio_ns) / 1000.0
+                    << ",\"dur\":" << static_cast<double>(evento.duracao_ns) / 1000.0 << "}";
+                primeiro = false;
+            }
+        }
+        out << "\n]}\n";
+    }
+}
+
+#define MLC_TRACE_CONCAT_(a, b) a##b
+#define MLC_TRACE_CONCAT(a, b) MLC_TRACE_CONCAT_(a, b)
+#define MLC_TRACE_SCOPE(nome) ::trace::Span MLC_TRACE_CONCAT(mlc_trace_span_, __LINE__)(nome)
+
+#else
+
+#define MLC_TRACE_SCOPE(nome) ((void)0)
+
+#endif
@@ -0,0 +1,6 @@
+// exit: 60
+var a[3];
+a[0] = 10;
+a[1] = 20;
+a[2] = a[0] + a[1];
+exit(a[0] + a[1] + a[2]);
@@ -0,0 +1,5 @@
+// Índices constantes fora do array também são verificados.
+// exit: 1
+var a[4];
+a[4] = 1;
+exit(0);
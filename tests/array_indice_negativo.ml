@@ -0,0 +1,5 @@
+// Leitura com índice negativo encerra com código 1.
+// exit: 1
+var a[3];
+var i = 0 - 1;
+exit(a[i] + 5);
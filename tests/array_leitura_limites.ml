@@ -0,0 +1,17 @@
+// O índice igual ao tamanho já está fora do array, mesmo num loop cujo contador passa do limite.
+// saida: 0
+// saida: 2
+// saida: 4
+// exit: 1
+var a[3];
+var i = 0;
+while (i < 3) {
+    a[i] = i * 2;
+    i = i + 1;
+}
+i = 0;
+while (i <= 3) {
+    print(a[i]);
+    i = i + 1;
+}
+exit(0);
@@ -0,0 +1,11 @@
+// Acesso fora dos limites encerra com código 1, depois de esvaziar o buffer de 'print'.
+// saida: 5
+// exit: 1
+var a[4];
+var i = 0;
+print(5);
+while (i < 10) {
+    a[i] = i;
+    i = i + 1;
+}
+exit(0);
@@ -0,0 +1,21 @@
+// Loop vetorizado com um número ímpar de elementos (o restante passa pelo loop escalar).
+// saida: 7
+// saida: 100
+// saida: 7
+// exit: 0
+var a[21];
+var b[21];
+var i = 0;
+while (i < 21) {
+    b[i] = i;
+    i = i + 1;
+}
+var k = 7;
+i = 0;
+while (i < 21) {
+    a[i] = b[i] * 4 + k - (b[i] - 1) * 2;
+    i = i + 1;
+}
+print(a[0] - 2);
+print(a[20] + 51);
+print(a[0] - 2);
@@ -0,0 +1,10 @@
+// Arrays começam com zeros, inclusive os grandes (rep stosq).
+// exit: 0
+var grande[1000];
+var i = 0;
+var s = 0;
+while (i < 1000) {
+    s = s + grande[i];
+    i = i + 1;
+}
+exit(s);
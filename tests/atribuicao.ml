@@ -0,0 +1,5 @@
+// exit: 50
+var x = 10;
+var y = 20;
+x = 50;
+exit(x);
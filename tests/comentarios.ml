@@ -0,0 +1,4 @@
+// exit: 4
+var x = 8 / 2; // a divisão não é confundida com um comentário
+// x = 100;
+exit(x);
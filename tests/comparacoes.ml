@@ -0,0 +1,15 @@
+// Comparações valem 1 (verdadeira) ou 0 (falsa).
+// saida: 1
+// saida: 0
+// saida: 1
+// saida: 1
+// saida: 0
+// exit: 2
+var a = 3;
+var b = 5;
+print(a < b);
+print(a > b);
+print(a <= 3);
+print(b >= 5);
+print(b < a);
+exit((a < b) + (b >= a));
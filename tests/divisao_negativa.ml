@@ -0,0 +1,8 @@
+// A divisão trunca em direção a zero (idiv).
+// saida: -3
+// saida: 3
+// saida: -2
+// exit: 0
+print((0 - 7) / 2);
+print((0 - 7) / (0 - 2));
+print((0 - 7) - (0 - 7) / 2 * 2 - 1);
@@ -0,0 +1,6 @@
+// erro: A função 'f' espera 1 argumento(s).
+fn f(a) {
+    return a;
+}
+exit(f(2));
+print(f(1, 2));
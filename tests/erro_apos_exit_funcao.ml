@@ -0,0 +1,4 @@
+// Código inalcançável também é verificado: o erro não depende das otimizações.
+// erro: Função 'nada' não declarada.
+exit(0);
+var y = nada(1);
@@ -0,0 +1,3 @@
+// erro: 'return' só pode ser usado dentro de uma função.
+exit(0);
+return 1;
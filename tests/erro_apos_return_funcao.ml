@@ -0,0 +1,6 @@
+// erro: Função 'h' não declarada.
+fn g() {
+    return 1;
+    var q = h();
+}
+exit(g());
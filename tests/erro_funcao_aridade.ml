@@ -0,0 +1,6 @@
+// Chamadas precisam do mesmo número de argumentos que a função tem de parâmetros.
+// erro: A função 'f' espera 2 argumento(s).
+fn f(a, b) {
+    return a + b;
+}
+exit(f(1));
@@ -0,0 +1,9 @@
+// Uma função não pode ser declarada duas vezes.
+// erro: Função 'f' já declarada.
+fn f(a) {
+    return a;
+}
+fn f(b) {
+    return b;
+}
+exit(f(1));
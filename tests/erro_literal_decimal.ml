@@ -0,0 +1,3 @@
+// Literal decimal maior que o maior int64_t.
+// erro: Literal inteiro não cabe em 64 bits.
+exit(9223372036854775808);
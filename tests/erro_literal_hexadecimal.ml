@@ -0,0 +1,3 @@
+// Literal hexadecimal com mais de 64 bits.
+// erro: Literal inteiro não cabe em 64 bits.
+exit(0x10000000000000000);
@@ -0,0 +1,3 @@
+// Prefixo sem dígitos.
+// erro: esperava-se um dígito após o prefixo.
+exit(0b);
@@ -0,0 +1,3 @@
+// Letras coladas ao final de um literal.
+// erro: Literal inteiro inválido.
+exit(12abc);
@@ -0,0 +1,4 @@
+// erro: já utilizado
+var x = 1;
+var x = 2;
+exit(x);
@@ -0,0 +1,2 @@
+// erro: 'return' só pode ser usado dentro de uma função.
+return 1;
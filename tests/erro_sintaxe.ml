@@ -0,0 +1,3 @@
+// erro: Esperava-se ';'
+var x = 1
+exit(x);
@@ -0,0 +1,2 @@
+// erro: não inicializado
+exit(y);
@@ -0,0 +1,14 @@
+// Variáveis de um escopo deixam de existir quando ele termina.
+// exit: 12
+var x = 1;
+{
+    var y = 5;
+    {
+        var z = 6;
+        x = x + y + z;
+    }
+    var w = 7;
+    x = x + w - y - 2;
+}
+var y = 0;
+exit(x + y);
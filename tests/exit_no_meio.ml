@@ -0,0 +1,6 @@
+// O código depois de 'exit' não é executado.
+// saida: 1
+// exit: 9
+print(1);
+exit(9);
+print(2);
@@ -0,0 +1,13 @@
+// Argumentos que também são chamadas são avaliados da esquerda para a direita.
+// saida: 1
+// saida: 2
+// saida: 3
+// exit: 17
+fn mostrar(x) {
+    print(x);
+    return x;
+}
+fn combinar(a, b, c) {
+    return a * 10 + b * 5 + c - 6;
+}
+exit(combinar(mostrar(1), mostrar(2), mostrar(3)));
@@ -0,0 +1,20 @@
+// Funções pequenas são expandidas no local da chamada, com mais de um return e variáveis locais.
+// saida: 3
+// saida: 10
+// saida: 42
+// exit: 0
+fn limitar(x, teto) {
+    var dobro = x * 2;
+    if (dobro > teto) {
+        return teto;
+    }
+    return dobro;
+}
+fn sete() {
+    return 7;
+}
+var a = 1;
+print(limitar(a, 5) + a);
+print(limitar(a + 5, 10));
+print(limitar(sete(), 100) * 3);
+exit(0);
@@ -0,0 +1,6 @@
+// Argumentos além do sexto são passados na stack.
+// exit: 36
+fn f(a, b, c, d, e, g, h, k) {
+    return a + b + c + d + e + g + h + k;
+}
+exit(f(1, 2, 3, 4, 5, 6, 7, 8));
@@ -0,0 +1,6 @@
+// Uma função que termina sem 'return' devolve 0.
+// exit: 3
+fn nada(x) {
+    var y = x;
+}
+exit(nada(5) + 3);
@@ -0,0 +1,5 @@
+// exit: 42
+fn soma(a, b) {
+    return a + b;
+}
+exit(soma(40, 2));
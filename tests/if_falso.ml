@@ -0,0 +1,7 @@
+// exit: 10
+var x = 10;
+var y = 20;
+if (x + y > 50) {
+    x = 100;
+}
+exit(x);
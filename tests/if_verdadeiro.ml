@@ -0,0 +1,7 @@
+// exit: 100
+var x = 10;
+var y = 20;
+if (x + y > 25) {
+    x = 100;
+}
+exit(x);
@@ -0,0 +1,10 @@
+// Statements depois de um escopo que sempre termina em exit são inalcançáveis.
+// exit: 5
+if (1) {
+    {
+        exit(5);
+    }
+    print(1);
+}
+print(2);
+exit(6);
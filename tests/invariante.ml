@@ -0,0 +1,16 @@
+// A expressão invariante e a multiplicação pelo contador são otimizadas sem mudar o resultado.
+// saida: 2280
+// saida: 1080
+// exit: 0
+var a = 3;
+var b = 4;
+var i = 0;
+var s = 0;
+var t = 0;
+while (i < 15) {
+    s = s + a * b + i * 20;
+    t = t + i * 5 + (a + b) * 2 + 23;
+    i = i + 1;
+}
+print(s);
+print(t);
@@ -0,0 +1,14 @@
+// Divisões invariantes não saem do loop: o primeiro loop nunca executa e dividiria por zero.
+// exit: 9
+var z = 0;
+var i = 0;
+var s = 0;
+while (i < 0) {
+    s = s + 10 / z;
+    i = i + 1;
+}
+while (i < 3) {
+    s = s + 12 / (z + 4);
+    i = i + 1;
+}
+exit(s);
@@ -0,0 +1,15 @@
+// Multiplicações pelo contador, antes e depois da sua atualização, com passo negativo.
+// saida: 32
+// saida: 24
+// saida: 16
+// saida: 8
+// saida: 0
+// exit: 90
+var i = 10;
+var s = 0;
+while (i > 0) {
+    s = s + i * 3;
+    i = i - 2;
+    print(i * 4);
+}
+exit(s);
@@ -0,0 +1,12 @@
+// Um contador atualizado também dentro de um if não é uma variável de indução.
+// exit: 85
+var i = 0;
+var s = 0;
+while (i < 10) {
+    s = s + i * 5;
+    i = i + 1;
+    if (s > 40) {
+        i = i + 2;
+    }
+}
+exit(s);
@@ -0,0 +1,11 @@
+// Uma atribuição lida só na próxima iteração do loop não é um dead store.
+// exit: 6
+var s = 0;
+var t = 0;
+var i = 0;
+while (i < 5) {
+    s = s + t;
+    t = i;
+    i = i + 1;
+}
+exit(s);
@@ -0,0 +1,13 @@
+// Literais hexadecimais e binários, e decimais longos convertidos oito dígitos por vez.
+// saida: 255
+// saida: 10
+// saida: 9223372036854775807
+// saida: 9223372036854775807
+// saida: 123456789012
+// exit: 42
+print(0xFF);
+print(0b1010);
+print(0x7FFFFFFFFFFFFFFF);
+print(9223372036854775807);
+print(123456789012);
+exit(0x20 + 0B1010);
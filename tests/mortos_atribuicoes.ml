@@ -0,0 +1,13 @@
+// Atribuições sobrescritas antes de serem lidas e variáveis nunca lidas são removidas
+// sem mudar o resultado, inclusive quando uma atribuição só é lida depois de um if.
+// exit: 39
+var x = 1;
+x = 2;
+x = 3;
+var ignorada = 7;
+var y = x * 10;
+ignorada = y;
+if (y > 20) {
+    x = 9;
+}
+exit(y + x);
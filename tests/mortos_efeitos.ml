@@ -0,0 +1,9 @@
+// Uma declaração nunca lida continua chamando a função do seu valor, que tem efeitos.
+// saida: 7
+// exit: 0
+fn efeito() {
+    print(7);
+    return 1;
+}
+var ignorada = efeito();
+exit(0);
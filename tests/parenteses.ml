@@ -0,0 +1,3 @@
+// exit: 45
+var a = (2 + 3) * (4 + 5);
+exit(((a)));
@@ -0,0 +1,3 @@
+// Multiplicação e divisão antes de soma e subtração, associatividade à esquerda.
+// exit: 23
+exit(1 + 2 * 3 * 4 - 10 / 5 / 1);
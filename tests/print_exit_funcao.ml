@@ -0,0 +1,12 @@
+// Um exit dentro de uma função esvazia o buffer de print antes de encerrar.
+// saida: 1
+// saida: 2
+// exit: 4
+fn terminar(codigo) {
+    print(2);
+    exit(codigo);
+    return 0;
+}
+print(1);
+var x = terminar(4);
+print(3);
@@ -0,0 +1,7 @@
+// O menor int64_t não tem positivo correspondente e é impresso sem negar o valor.
+// saida: -9223372036854775808
+// saida: -10
+// exit: 0
+print(0 - 9223372036854775807 - 1);
+print(0 - 10);
+exit(0);
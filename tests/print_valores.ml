@@ -0,0 +1,13 @@
+// saida: 0
+// saida: 7
+// saida: -1
+// saida: 100
+// saida: 9223372036854775807
+// saida: -9223372036854775807
+// exit: 0
+print(0);
+print(7);
+print(0 - 1);
+print(100);
+print(9223372036854775807);
+print(0 - 9223372036854775807);
@@ -0,0 +1,8 @@
+// exit: 89
+fn fib(n) {
+    if (n < 2) {
+        return 1;
+    }
+    return fib(n - 1) + fib(n - 2);
+}
+exit(fib(10));
@@ -0,0 +1,16 @@
+// Índices de array calculados e imediatos negativos no limite de 32 bits.
+// saida: -2147483645
+// saida: -2147483649
+// saida: 7
+// exit: 10
+var a = 3;
+var v[8];
+var i = 0;
+while (i < 4) {
+    v[i * 2 + 1] = i + a;
+    i = i + 1;
+}
+print(a - 2147483648);
+print(0 - 2147483649);
+print(v[3] + v[7] - v[1] + v[0]);
+exit(v[a * 2 - 1] + v[5]);
@@ -0,0 +1,28 @@
+// Padrões da seleção de instruções: endereços calculados com lea, imediatos no limite
+// de 32 bits, literais maiores, operandos de memória e comparações usadas como valor.
+// saida: 35
+// saida: 37
+// saida: 13
+// saida: 2147483650
+// saida: 2147483651
+// saida: 12884901888
+// saida: 15
+// saida: 1
+// saida: 0
+// saida: 15
+// saida: 16
+// exit: 17
+var a = 3;
+var b = 5;
+print(a + b * 4 + 12);
+print(b * 8 - 3);
+print(2 * b + a);
+print(a + 2147483647);
+print(a + 2147483648);
+print(a * 4294967296);
+print(b * 3);
+print(a < b);
+print(a >= b);
+print(a * b - a / b);
+print(b / a + b * a);
+exit((b - a) * 8 + 1);
@@ -0,0 +1,5 @@
+// Sem 'exit', o programa termina com código 0.
+// saida: 3
+// exit: 0
+var x = 3;
+print(x);
@@ -0,0 +1,10 @@
+// Um milhão de chamadas em posição de cauda não estouram a stack.
+// saida: 500000500000
+// exit: 0
+fn acumular(n, total) {
+    if (n < 1) {
+        return total;
+    }
+    return acumular(n - 1, total + n);
+}
+print(acumular(1000000, 0));
@@ -0,0 +1,9 @@
+// Um return entre parênteses continua sendo uma chamada em posição de cauda.
+// exit: 7
+fn contar(n, passos) {
+    if (n < 1) {
+        return (passos / 1000000 + 6);
+    }
+    return ((contar(n - 1, passos + 1)));
+}
+exit(contar(1000000, 0));
@@ -0,0 +1,14 @@
+// saida: 165
+// exit: 0
+var i = 0;
+var total = 0;
+while (i < 10) {
+    var j = 0;
+    while (j < i) {
+        total = total + j + 1;
+        j = j + 1;
+    }
+    i = i + 1;
+}
+print(total);
+exit(0);
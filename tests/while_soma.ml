@@ -0,0 +1,9 @@
+// exit: 195
+var i = 0;
+var s = 0;
+while (i < 100) {
+    s = s + i;
+    i = i + 1;
+}
+// s = 4950, que não cabe num código de saída
+exit(s - 4755);
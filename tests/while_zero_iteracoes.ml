@@ -0,0 +1,8 @@
+// exit: 7
+var i = 10;
+var x = 7;
+while (i < 5) {
+    x = 0;
+    i = i + 1;
+}
+exit(x);